@@ -28,8 +28,15 @@
 #include <netinet/in.h>
 #include <math.h>
 #include <limits.h>
+#include <time.h>
+#include <sys/time.h>
 #include "fdd_portab.h"
 #include "fdd_msg.h"
+#include "fdd_trace.h"
+#include "fdd_metrics.h"
+#include "fdd_wire.h"
+#include "fdd_warm.h"
+#include "fdd_vis.h"
 
 #define USECS_PER_UNIT 1000	/* all other times in 1000s of usecs
 should be multiple of 10 and less than
@@ -53,24 +60,41 @@ should be multiple of 10 and less than
 #define FDD_PID 0
 #define FDD_GID 0
 
+#define FDD_RECV_BATCH 64 /* maximum datagrams read per socket wake up */
+
 #define HELLO_SENDINT (10 * UNITS_PER_SEC)
 #define HELLO_GROUP "225.0.0.37"  /* My group multicat IP */
 
+/* with -DMULTICAST_ALIVES the alives of the local groups are sent once to
+ HELLO_GROUP instead of once per host */
+#define MCAST_UNICAST_SENDINT UNITS_PER_SEC /* reports to the hosts reached
+ by the multicast */
+#define MCAST_IDLE_SENDINT (UNITS_PER_SEC / 10) /* check again for hosts to
+ reach when none is */
+
+#define DELTA_SNAPSHOT_INT (60 * UNITS_PER_SEC) /* reports with all the lists,
+ even the acked ones, are sent at least that often */
+
+#define ACCUSATION_FLUSH_DELAY 20 /* omega accusations not gone with a
+ report by then are sent in one datagram */
+
 
 #define print_ts(tv) printf("[%010ld.%06ld] ", (tv)->tv_sec, (tv)->tv_usec)
 #define fprint_ts(stream, tv) fprintf(stream, "[%010ld.%06ld] ", \
 (tv)->tv_sec, (tv)->tv_usec)
 
-static inline void timermult(struct timeval *tv, unsigned int n) {
-  
-  double x = n ;
-  x *= tv->tv_usec ;
-  tv->tv_sec = tv->tv_sec * n ;
-  while( x > 1000000.0 ) {
-    x /= 1000000.0 ;
-    tv->tv_sec++ ;
+/* sets tv to us microseconds, tv_usec kept in [0, 1000000) */
+static inline void us2timer(int64_t us, struct timeval *tv) {
+  tv->tv_sec = us / 1000000LL ;
+  tv->tv_usec = us % 1000000LL ;
+  if(tv->tv_usec < 0) {
+    tv->tv_sec-- ;
+    tv->tv_usec += 1000000L ;
   }
-  tv->tv_usec = (long)(rint(x));
+}
+
+static inline void timermult(struct timeval *tv, unsigned int n) {
+  us2timer(((int64_t)tv->tv_sec * 1000000LL + tv->tv_usec) * n, tv) ;
 }
 
 static inline void timerinv(struct timeval *tv) {
@@ -82,19 +106,9 @@ static inline void timerinv(struct timeval *tv) {
   }
 }
 
+/* rounds toward zero, as the division of the absolute value */
 static inline void timerdiv(struct timeval *tv, unsigned int n) {
-  int negative = 0 ;
-  
-  if(tv->tv_sec < 0) {
-    negative = 1 ;
-    timerinv(tv) ;
-  }
-  
-  tv->tv_usec = ((tv->tv_sec%n)*1000000L + tv->tv_usec)/n ;
-  tv->tv_sec /= n ;
-  
-  if(negative)
-    timerinv(tv) ;
+  us2timer(((int64_t)tv->tv_sec * 1000000LL + tv->tv_usec) / (int64_t)n, tv) ;
 }
 
 static inline void unit2timer(u_int units, struct timeval *tv)
@@ -109,6 +123,42 @@ static inline u_int timer2unit(struct timeval *tv)
   tv->tv_usec / USECS_PER_UNIT + ((tv->tv_usec % USECS_PER_UNIT)? 1 : 0) ;
 }
 
+#define NSECS_PER_USEC 1000LL
+#define NSECS_PER_SEC  1000000000LL
+
+static inline fdd_ns_t mono_ns(void)
+{
+  struct timespec ts ;
+  clock_gettime(CLOCK_MONOTONIC, &ts) ;
+  return (fdd_ns_t)ts.tv_sec * NSECS_PER_SEC + ts.tv_nsec ;
+}
+
+static inline fdd_ns_t timer2ns(struct timeval *tv)
+{
+  return (fdd_ns_t)tv->tv_sec * NSECS_PER_SEC + tv->tv_usec * NSECS_PER_USEC ;
+}
+
+static inline fdd_ns_t unit2ns(u_int units)
+{
+  return (fdd_ns_t)units * USECS_PER_UNIT * NSECS_PER_USEC ;
+}
+
+static inline void ns2timer(fdd_ns_t ns, struct timeval *tv)
+{
+  tv->tv_sec = ns / NSECS_PER_SEC ;
+  tv->tv_usec = (ns % NSECS_PER_SEC) / NSECS_PER_USEC ;
+}
+
+/* converts a wall clock deadline to the monotonic timebase, using the
+ current offset between the two clocks */
+static inline fdd_ns_t wall2mono_ns(struct timeval *wall)
+{
+  struct timeval now ;
+  fdd_ns_t mono = mono_ns() ;
+  gettimeofday(&now, NULL) ;
+  return mono + (timer2ns(wall) - timer2ns(&now)) ;
+}
+
 static inline void sockaddr_local(struct sockaddr_in *a)
 {
   a->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
@@ -163,11 +213,17 @@ extern int comm_hello_multicast(char *buf, int len) ;
 /***** Local module ****/
 
 extern void local_init(void);
+extern void local_cleanup(void);
 extern void send_hello_multicast(struct timeval *now_hello) ;
+extern void local_send_alive_multicast(struct timeval *sending_ts) ;
 extern int fdd_local_reg(unsigned int pid, struct timeval *reg_ts);
 extern void local_send_report(struct timeval *tv);
 extern void local_sched_report_sooner(u_int sendint, struct timeval *now,
 struct host_struct *host) ;
+extern int local_queue_accusation(struct sockaddr_in *addr, u_int gid,
+  struct timeval *startTime,
+struct timeval *now) ;
+extern void local_flush_accusations(struct host_struct *host) ;
 extern void local_untrust_host(struct localproc_struct  *lproc,
   struct host_struct *host,
 struct list_head *remove_list);
@@ -205,22 +261,32 @@ struct timeval *largest_jointly_group_ts);
 extern struct list_head remote_host_list_head;
 extern void remote_merge(char *msg, int msg_len, struct sockaddr_in *raddr,
 struct timeval *arrival_ts);
+extern void remote_frag_merge(char *msg, int msg_len,
+  struct sockaddr_in *raddr,
+struct timeval *arrival_ts) ;
+extern void remote_compact_merge(char *msg, int msg_len,
+  struct sockaddr_in *raddr,
+struct timeval *arrival_ts) ;
+extern void remote_alive_multicast_merge(char *msg, int msg_len,
+  struct sockaddr_in *raddr,
+struct timeval *arrival_ts) ;
 extern void remote_replay_host(struct localproc_struct *lproc,
 struct host_struct *host, struct timeval *now);
 extern void remote_replay_all(struct localproc_struct *lproc, struct timeval *now);
 extern int remote_calc_local_sendint(void);
+extern void remote_cleanup(void);
 extern void remote_recalc_all_needed_sendint(void);
 extern void show_host(struct list_head *mng_hosts, int n) ;
 extern void build_mng_host_list(struct list_head *mng_hosts) ;
 extern struct host_struct *locate_host(struct sockaddr_in *addr) ;
-extern char *parse_proc_list(char *msg, char *ptr_start, int pcount,
+extern char *parse_proc_list(char *msg_end, char *ptr_start, int pcount,
 struct list_head *list, int *retval) ;
 extern void remote_host_suspect(struct host_struct *host, struct timeval *now) ;
 extern void suspect_remote_group(struct host_struct *host,
 struct uint_struct *group) ;
 /**** Schedule module ****/
 extern int sched_delay(struct delay_struct *delay, struct timeval *tv);
-extern int exists_report_in_event_list(struct sockaddr_in *raddr, u_int gid);
+extern int exists_report_in_event_list(struct host_struct *host, u_int gid);
 extern int sched_report_now(struct host_struct *host, struct timeval *now);
 extern int sched_report(struct host_struct *host);
 extern int sched_report_a_bit_later(struct host_struct *host, struct timeval *now,
@@ -231,6 +297,9 @@ extern void fd_sched_run(struct timeval *timeout, struct timeval *now);
 /*  extern int sched_suspect_host(struct host_struct *host, struct timeval *now) ; */
 extern int sched_hello_multicast(struct timeval *now, u_int when_hello) ;
 extern int sched_hello_multicast_now();
+extern int sched_alive_multicast(struct timeval *now, u_int sendint) ;
+extern int sched_accusations(struct host_struct *host, struct timeval *now) ;
+extern void remove_accusations_event(struct host_struct *host) ;
 extern int sched_unsched_host(struct localproc_struct *lproc,
 struct host_struct *host);
 
@@ -252,6 +321,7 @@ struct timeval *now) ;
 extern void recalc_needed_sendint(struct host_struct *rhost,
 struct timeval *now) ;
 extern struct localproc_struct* get_local_proc(unsigned int pid) ;
+extern struct list_head *local_group_members(unsigned int gid) ;
 extern void local_send_report_host(struct host_struct *host,
 struct timeval *sending_ts) ;
 
@@ -270,6 +340,10 @@ extern void recompute_delays(struct stats_struct *stats,
   unsigned int remote_sendint,
 struct timeval *arrival_ts ) ;
 extern unsigned int compute_average_delays(struct stats_struct *stats) ;
+extern int phi_fresh_point(struct qos_struct *qos, struct stats_struct *stats,
+  struct timeval *arrival_ts, struct timeval *fresh) ;
+extern void clear_average_delays(struct stats_struct *stats) ;
+extern int initial_delays_converged(struct stats_struct *stats) ;
 extern int merge_average_delay_msg(struct stats_struct *stats,
   unsigned int seq,
   struct timeval *sending_ts,
@@ -283,6 +357,13 @@ struct timeval *sendint_ts) ;
 extern void sched_unsched_say_hello() ;
 extern void hello_multicast_merge(char *msg, int msg_len, struct sockaddr_in *raddr,
 struct timeval *arrival_ts) ;
+extern void hello_digest_merge(char *msg, int msg_len, struct sockaddr_in *raddr,
+struct timeval *arrival_ts) ;
+extern void hello_request_merge(char *msg, int msg_len, struct sockaddr_in *raddr,
+struct timeval *arrival_ts) ;
+extern int hello_digest_keeps_group(struct host_struct *host,
+  struct uint_struct *group,
+struct timeval *now) ;
 extern void remove_report_event(struct host_struct *host) ;
 
 extern void recompute_expected_arrival(struct host_struct *host) ;
@@ -307,6 +388,8 @@ extern void local_init_multicast() ;
 
 /************* The omega Module *********************************************/
 extern inline void doUponSuspected(struct sockaddr_in *addr, u_int pid, u_int gid, struct timeval *now);
+extern void doUponReceivedAccusation(u_int gid, struct timeval *startTime, struct timeval *now);
+extern void send_accusation_msg(struct sockaddr_in *raddr, char *msg, int msg_len);
 
 #endif
 
@@ -0,0 +1,60 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+/* fdd_arena.h - bump allocator for the data living as long as one
+ message */
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stdlib.h>
+
+#define ARENA_ALIGN 8
+
+/* The allocations are taken one after the other in base and all given
+ back at once by arena_reset(). The buffer is kept for the next message. */
+struct arena {
+  char *base ;
+  size_t size ;
+  size_t used ;
+} ;
+
+#define ARENA_INIT { NULL, 0, 0 }
+
+extern int arena_reserve(struct arena *a, size_t size) ;
+extern void arena_free(struct arena *a) ;
+
+/* arena_alloc - returns size bytes of the arena, NULL if it is full */
+static inline void *arena_alloc(struct arena *a, size_t size) {
+  void *p ;
+  
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1) ;
+  if(size > a->size - a->used)
+    return NULL ;
+  p = a->base + a->used ;
+  a->used += size ;
+  return p ;
+}
+
+static inline void arena_reset(struct arena *a) {
+  a->used = 0 ;
+}
+
+#endif /* _ARENA_H */
@@ -0,0 +1,93 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+/* fdd_gset.h - sets of groups, as bitsets over interned group indices */
+#ifndef _GSET_H
+#define _GSET_H
+
+#include <stdlib.h>
+#include <sys/types.h>
+#include "list.h"
+
+#define GSET_WORD_BITS 64
+#define GSET_MIN_SLOTS 64 /* initial size of the gid table, a power of two */
+
+/* A set of groups. The gids are interned once in a dense index (see
+ gset_intern()), the set has the bit of that index set. Bits past nwords
+ are 0. */
+struct gset {
+  u_int64_t *bits ;
+  unsigned int nwords ;
+} ;
+
+#define GSET_INIT { NULL, 0 }
+
+/* A list per group, indexed by the interned index of the gid: what the
+ local processes do in a group is found without looking at the others.
+ A list, once created, stays until gtable_free(). */
+struct gtable {
+  struct list_head **heads ;
+  unsigned int nb_heads ;
+} ;
+
+#define GTABLE_INIT { NULL, 0 }
+
+extern int gset_intern(u_int gid) ;
+extern int gset_lookup(u_int gid) ;
+extern void gset_cleanup(void) ;
+
+extern int gset_add(struct gset *set, u_int gid) ;
+extern void gset_del(struct gset *set, u_int gid) ;
+extern int gset_and(struct gset *dst, struct gset *a, struct gset *b) ;
+extern int gset_equal(struct gset *a, struct gset *b) ;
+
+extern struct list_head *gtable_create(struct gtable *table, u_int gid) ;
+extern void gtable_free(struct gtable *table) ;
+
+static inline void gset_init(struct gset *set) {
+  set->bits = NULL ;
+  set->nwords = 0 ;
+}
+
+static inline void gset_free(struct gset *set) {
+  free(set->bits) ;
+  gset_init(set) ;
+}
+
+/* gset_test - tells whether gid is in the set */
+static inline int gset_test(struct gset *set, u_int gid) {
+  int idx = gset_lookup(gid) ;
+  
+  if(idx < 0 || (unsigned int)idx / GSET_WORD_BITS >= set->nwords)
+    return 0 ;
+  return (set->bits[idx / GSET_WORD_BITS] >> (idx % GSET_WORD_BITS)) & 1 ;
+}
+
+/* gtable_lookup - returns the list of the group gid, NULL if it has none */
+static inline struct list_head *gtable_lookup(struct gtable *table, u_int gid) {
+  int idx = gset_lookup(gid) ;
+  
+  if(idx < 0 || (unsigned int)idx >= table->nb_heads)
+    return NULL ;
+  return table->heads[idx] ;
+}
+
+#endif /* _GSET_H */
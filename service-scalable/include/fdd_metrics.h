@@ -0,0 +1,98 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_metrics.h - runtime counters and latency histograms */
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <sys/types.h>
+#include <sys/select.h>
+#include <time.h>
+
+#define FDD_METRICS_SOCK "/tmp/ddO_fdd-metrics" /* the unix metrics socket */
+
+#define METRICS_BUF_LEN (64 * 1024)   /* initial buffer of a scrape */
+#define METRICS_BUF_MAX (4096 * 1024) /* the buffer grows up to that */
+#define METRICS_TRUNCATED "# fdd: truncated\n" /* ends a cut scrape */
+#define METRICS_MAX_CONNS 4         /* scrapes being sent at the same time */
+#define METRICS_CONN_TIMEOUT (5 * 1000000000LL) /* ns a reader has to take
+ its scrape, the connection is closed afterwards */
+
+/* latency histograms have power of two buckets in microseconds:
+ bucket i counts samples <= 2^i usecs, the last one is +Inf */
+#define METRICS_HIST_BUCKETS 24
+
+struct metrics_hist {
+  u_int64_t bucket[METRICS_HIST_BUCKETS] ;
+  u_int64_t sum_ns ;
+  u_int64_t count ;
+} ;
+
+struct fdd_metrics {
+  u_int64_t loop_iterations ;
+  u_int64_t reports_sent ;
+  u_int64_t reports_send_failed ;
+  u_int64_t reports_rcvd ;
+  u_int64_t reports_out_of_order ;
+  u_int64_t host_suspects ;
+  u_int64_t leader_changes ;
+  u_int64_t events_dispatched ;
+  
+  struct metrics_hist report_build ;    /* local_send_report_host */
+  struct metrics_hist sched_run ;       /* fd_sched_run */
+  struct metrics_hist sched_lateness ;  /* event dispatch time - event time */
+  struct metrics_hist dispatch ;        /* select wake up to end of dispatch */
+  struct metrics_hist leader_update ;   /* updateGlobalLeader */
+} ;
+
+extern struct fdd_metrics metrics ;
+
+extern int metrics_init(void) ;
+extern void metrics_cleanup(void) ;
+extern void metrics_wset(fd_set *wset) ;
+extern void check_metrics_socket(fd_set *active, fd_set *writable) ;
+
+static inline u_int64_t metrics_now_ns(void) {
+  struct timespec ts ;
+  clock_gettime(CLOCK_MONOTONIC, &ts) ;
+  return (u_int64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec ;
+}
+
+/* records a sample, no allocation and no system call */
+static inline void metrics_hist_add(struct metrics_hist *hist, u_int64_t ns) {
+  u_int64_t us = ns / 1000 ;
+  int i = 0 ;
+  
+  if(us > 1)
+    i = 64 - __builtin_clzll(us - 1) ;
+  if(i >= METRICS_HIST_BUCKETS)
+    i = METRICS_HIST_BUCKETS - 1 ;
+  hist->bucket[i]++ ;
+  hist->sum_ns += ns ;
+  hist->count++ ;
+}
+
+static inline void metrics_hist_since(struct metrics_hist *hist, u_int64_t start_ns) {
+  metrics_hist_add(hist, metrics_now_ns() - start_ns) ;
+}
+
+#endif /* _METRICS_H */
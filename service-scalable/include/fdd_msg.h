@@ -70,6 +70,21 @@ The third message type is when we want to join a group but be invisible
 #define MSG_RESTART_SENDING_ALIVES 19
 #define MSG_JOIN_GROUP_INVISIBLE   20
 
+/* group alives sent once to the IP multicast group instead of once per
+ host, see local_send_alive_multicast() */
+#define MSG_ALIVE_MULTICAST        21
+
+/* report in the compact wire format, see fdd_wire.c */
+#define MSG_REPORT_COMPACT         22
+
+/* fragment of a report longer than MAX_MSG_LEN */
+#define MSG_REPORT_FRAG            23
+
+/* HELLO with the digest of the groups instead of their list, and the
+ unicast request for the full HELLO sent when the digest is not known */
+#define MSG_HELLO_DIGEST           24
+#define MSG_HELLO_REQUEST          25
+
 /* max size of MSG_REGISTER, MSG_MONITOR_ALL, MSG_MONITOR_PROC,
  MSG_INTERRUPT_ON, MSG_NOTIFY, MSG_RESULT, ... */
 /* FIXME: in most cases we know the exact size */
@@ -698,6 +713,25 @@ struct timeval *tv)
  *          4 bytes      accusationTime.tv_usec
  *          4 bytes      startTime.tv_sec
  *          4 bytes      startTime.tv_usec
+ *
+ * delta trailer (only to the hosts understanding WIRE_VERSION_DELTA, the
+ * others ignore it):
+ *          4 bytes      omitted       (bitmap of the lists left out,
+ *                                      1 << REP_LIST_*)
+ *     REP_LISTS times, indexed by REP_LIST_*:
+ *          4 bytes      acked_seq     (seq of the last report of the remote
+ *                                      host whose list was applied)
+ * A list is left out, with its count and length set to 0, once the
+ * receiver acked a report sent after its last change: the receiver then
+ * keeps its copy of the list.
+ *
+ * accusations (only to the hosts understanding WIRE_VERSION_ACCUSATIONS,
+ * after the delta trailer, when omega accused some of their processes):
+ *          4 bytes      accusations_count
+ *     accusations_count times:
+ *          4 bytes      gid
+ *          4 bytes      startTime.tv_sec     (of the accused process)
+ *          4 bytes      startTime.tv_usec
  */
 
 /* The function skips the header of the report  message */
@@ -801,9 +835,11 @@ char *msg_parse_rep_head(char *msg, struct timeval *tv,
 }
 
 
+#define REP_GHEAD_LEN (5*4)
+
 static inline char *msg_skip_rep_ghead(char *msg)
 {
-  return msg + 5*4;
+  return msg + REP_GHEAD_LEN;
 }
 static inline char *msg_build_rep_ghead(char *msg, u_int gid, struct timeval *group_ts,
 u_int eta_rcvd, int procs_count)
@@ -832,6 +868,8 @@ u_int *eta_rcvd, int *procs_count)
   return ptr;
 }
 
+#define REP_PID_LEN 4
+
 static inline char *msg_build_rep_pid(char *msg, u_int pid) {
   char *ptr = msg;
   
@@ -850,6 +888,8 @@ static inline char *msg_parse_rep_pid(char *msg, u_int *pid)
 }
 
 
+#define REP_LOCALVARS_LEN (5*4)
+
 static inline char *msg_build_rep_localvars(char *msg, u_int gid, struct timeval *accusationTime,
 struct timeval *startTime)
 {
@@ -878,6 +918,82 @@ struct timeval *startTime)
 }
 
 
+#define REP_DELTA_LEN ((1 + REP_LISTS)*4)
+
+static inline char *msg_build_rep_delta(char *msg, u_int omitted,
+u_int *acked_seq)
+{
+  char *ptr = msg;
+  int i;
+  
+  put32(ptr, (unsigned int)omitted); ptr += 4;
+  for(i = 0; i < REP_LISTS; i++) {
+    put32(ptr, (unsigned int)acked_seq[i]); ptr += 4;
+  }
+  
+  return ptr;
+}
+static inline char *msg_parse_rep_delta(char *msg, u_int *omitted,
+u_int *acked_seq)
+{
+  char *ptr = msg;
+  int i;
+  
+  *omitted = get32(ptr); ptr += 4;
+  for(i = 0; i < REP_LISTS; i++) {
+    acked_seq[i] = get32(ptr); ptr += 4;
+  }
+  
+  return ptr;
+}
+
+#define REP_ACCUSATION_LEN (3*4)
+
+static inline char *msg_build_rep_accusations_count(char *msg, u_int count)
+{
+  put32(msg, (unsigned int)count);
+  return msg + 4;
+}
+static inline char *msg_parse_rep_accusations_count(char *msg, u_int *count)
+{
+  *count = get32(msg);
+  return msg + 4;
+}
+
+static inline char *msg_build_rep_accusation(char *msg, u_int gid,
+struct timeval *startTime)
+{
+  char *ptr = msg;
+  
+  put32(ptr, (unsigned int)gid); ptr += 4;
+  put32(ptr, (unsigned int)startTime->tv_sec); ptr += 4;
+  put32(ptr, (unsigned int)startTime->tv_usec); ptr += 4;
+  
+  return ptr;
+}
+static inline char *msg_parse_rep_accusation(char *msg, u_int *gid,
+struct timeval *startTime)
+{
+  char *ptr = msg;
+  
+  *gid = get32(ptr); ptr += 4;
+  startTime->tv_sec = get32(ptr); ptr += 4;
+  startTime->tv_usec = get32(ptr); ptr += 4;
+  
+  return ptr;
+}
+
+/* msg_digest - FNV-1a hash of a part of a message, tells whether a list
+ changed since it was last sent */
+static inline u_int msg_digest(char *msg, int len)
+{
+  u_int h = 2166136261u;
+  
+  while(len-- > 0)
+    h = (h ^ (unsigned char)*msg++) * 16777619u;
+  
+  return h;
+}
 
 /*
  * Hello message format
@@ -890,6 +1006,8 @@ struct timeval *startTime)
  * process list
  *    groups_count times:
  *            4    bytes    gid
+ * since the compact wire format:
+ *       4    bytes     wire_version (most recent wire format understood)
  */
 
 
@@ -944,6 +1062,289 @@ static inline char* msg_parse_hello_gid(char *msg, u_int *gid) {
   return ptr ;
 }
 
+static inline char *msg_build_hello_wire_version(char *msg, u_int wire_version) {
+  char *ptr = msg ;
+  
+  put32(ptr, (unsigned int)wire_version); ptr += 4 ;
+  
+  return ptr ;
+}
+
+static inline char *msg_parse_hello_wire_version(char *msg, u_int *wire_version) {
+  char *ptr = msg ;
+  
+  *wire_version = get32(ptr); ptr += 4 ;
+  
+  return ptr ;
+}
+
+/*
+ * Hello digest message format, multicast instead of the HELLO once all the
+ * known hosts understand WIRE_VERSION_HELLO_DIGEST:
+ *       4    bytes     type        (message type - MSG_HELLO_DIGEST)
+ *       4    bytes     hello_seq
+ *       4    bytes     local_groups_list_seq
+ *       8    bytes     epoch timestamp
+ *       4    bytes     groups_count
+ *       8    bytes     digest      (hello_digest_add() of the gids)
+ *       4    bytes     wire_version
+ *
+ * Hello request message format, sent back by a host that does not know
+ * that digest. It is answered by a unicast HELLO:
+ *       4    bytes     type        (message type - MSG_HELLO_REQUEST)
+ */
+
+#define HELLO_DIGEST_LEN (9*4)
+#define HELLO_REQUEST_LEN 4
+
+/* hello_digest_add - adds a gid to the digest of a set of groups. The
+ digest is a sum of mixed gids, it does not depend on their order. */
+static inline u_int64_t hello_digest_add(u_int64_t digest, u_int gid) {
+  u_int64_t z = (u_int64_t)gid + 0x9e3779b97f4a7c15ULL ;
+  
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL ;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL ;
+  return digest + (z ^ (z >> 31)) ;
+}
+
+static inline char *msg_build_hello_digest(char *msg, unsigned int hello_seq,
+  unsigned int local_groups_list_seq,
+  struct timeval *epoch,
+  unsigned int groups_count,
+  u_int64_t digest,
+  u_int wire_version) {
+  char *ptr = msg ;
+  
+  put32(ptr, (unsigned int)MSG_HELLO_DIGEST) ; ptr += 4 ;
+  put32(ptr, (unsigned int)hello_seq) ; ptr += 4 ;
+  put32(ptr, (unsigned int)local_groups_list_seq); ptr += 4 ;
+  put32(ptr, (unsigned int)epoch->tv_sec); ptr += 4 ;
+  put32(ptr, (unsigned int)epoch->tv_usec); ptr += 4 ;
+  put32(ptr, (unsigned int)groups_count) ; ptr += 4 ;
+  put32(ptr, (unsigned int)(digest >> 32)) ; ptr += 4 ;
+  put32(ptr, (unsigned int)digest) ; ptr += 4 ;
+  put32(ptr, (unsigned int)wire_version) ; ptr += 4 ;
+  
+  return ptr ;
+}
+
+static inline char *msg_parse_hello_digest(char *msg, unsigned int *hello_seq,
+  unsigned int *local_groups_list_seq,
+  struct timeval *epoch,
+  unsigned int *groups_count,
+  u_int64_t *digest,
+  u_int *wire_version) {
+  char *ptr = msg + 4 ;
+  
+  *hello_seq = get32(ptr) ; ptr += 4 ;
+  *local_groups_list_seq = get32(ptr) ; ptr += 4 ;
+  epoch->tv_sec = get32(ptr); ptr += 4 ;
+  epoch->tv_usec = get32(ptr); ptr += 4 ;
+  *groups_count = get32(ptr) ; ptr += 4 ;
+  *digest = (u_int64_t)get32(ptr) << 32 ; ptr += 4 ;
+  *digest |= get32(ptr) ; ptr += 4 ;
+  *wire_version = get32(ptr) ; ptr += 4 ;
+  
+  return ptr ;
+}
+
+static inline char *msg_build_hello_request(char *msg) {
+  char *ptr = msg ;
+  
+  put32(ptr, (unsigned int)MSG_HELLO_REQUEST) ; ptr += 4 ;
+  
+  return ptr ;
+}
+
+/*
+ * Report fragment message format (all fields are network byte order).
+ * A report (fixed or compact) longer than MAX_MSG_LEN is cut in
+ * frag_count pieces of REP_FRAG_PAYLOAD bytes (the last one shorter).
+ * Each fragment repeats what the receiver needs to count the report as an
+ * alive even when some of the other fragments are lost.
+ *	4    bytes  type	    (message type - MSG_REPORT_FRAG)
+ *	4    bytes  seq		    (seq number of the report)
+ *	4    bytes  frag_index
+ *	4    bytes  frag_count
+ *	4    bytes  report_len	    (length of the whole report)
+ *	8    bytes  sending_ts
+ *	8    bytes  epoch	    (epoch timestamp of local host start)
+ *	8    bytes  remote_epoch    (epoch timestamp of the remote host)
+ *	4    bytes  local_sendint   (sending interval of the local host)
+ *	     bytes  the piece of the report
+ */
+
+#define REP_FRAG_HEAD_LEN (12*4)
+#define REP_FRAG_PAYLOAD (MAX_MSG_LEN - REP_FRAG_HEAD_LEN)
+#define REP_MAX_LEN (REP_MAX_FRAGS * REP_FRAG_PAYLOAD)
+
+static inline char *msg_build_rep_frag_head(char *msg, u_int seq,
+  u_int frag_index, u_int frag_count, u_int report_len,
+  struct timeval *tv, struct timeval *local_epoch,
+  struct timeval *remote_epoch, u_int local_sendint) {
+  char *ptr = msg ;
+  
+  put32(ptr, (unsigned int)MSG_REPORT_FRAG) ; ptr += 4 ;
+  put32(ptr, (unsigned int)seq); ptr += 4 ;
+  put32(ptr, (unsigned int)frag_index); ptr += 4 ;
+  put32(ptr, (unsigned int)frag_count); ptr += 4 ;
+  put32(ptr, (unsigned int)report_len); ptr += 4 ;
+  put32(ptr, (unsigned int)tv->tv_sec); ptr += 4 ;
+  put32(ptr, (unsigned int)tv->tv_usec); ptr += 4 ;
+  put32(ptr, (unsigned int)local_epoch->tv_sec); ptr += 4 ;
+  put32(ptr, (unsigned int)local_epoch->tv_usec); ptr += 4 ;
+  put32(ptr, (unsigned int)remote_epoch->tv_sec); ptr += 4 ;
+  put32(ptr, (unsigned int)remote_epoch->tv_usec); ptr += 4 ;
+  put32(ptr, (unsigned int)local_sendint); ptr += 4 ;
+  
+  return ptr ;
+}
+
+static inline char *msg_parse_rep_frag_head(char *msg, u_int *seq,
+  u_int *frag_index, u_int *frag_count, u_int *report_len,
+  struct timeval *tv, struct timeval *remote_epoch,
+  struct timeval *local_epoch, u_int *remote_sendint) {
+  char *ptr = msg + 4 ;
+  
+  *seq = get32(ptr); ptr += 4 ;
+  *frag_index = get32(ptr); ptr += 4 ;
+  *frag_count = get32(ptr); ptr += 4 ;
+  *report_len = get32(ptr); ptr += 4 ;
+  tv->tv_sec = get32(ptr); ptr += 4 ;
+  tv->tv_usec = get32(ptr); ptr += 4 ;
+  remote_epoch->tv_sec = get32(ptr); ptr += 4 ;
+  remote_epoch->tv_usec = get32(ptr); ptr += 4 ;
+  local_epoch->tv_sec = get32(ptr); ptr += 4 ;
+  local_epoch->tv_usec = get32(ptr); ptr += 4 ;
+  *remote_sendint = get32(ptr); ptr += 4 ;
+  
+  return ptr ;
+}
+
+/*
+ * Alive multicast message format (all fields are network byte order).
+ * The part shared by all the receivers is the one of a report: the local
+ * groups and the localvars. Each receiver then finds in its own section
+ * the per host fields of the report header.
+ * head
+ *	4    bytes  type	             (message type - MSG_ALIVE_MULTICAST)
+ *	8    bytes  sending_ts	             (sending timestamp)
+ *	8    bytes  epoch	             (epoch timestamp of local host start)
+ *      4    bytes  local_groups_list_seq  (seq. nb. of the list of local groups,
+ *                                          its own: not the one of the reports)
+ *      4    bytes  local_groups_count      (number of local groups that are sent)
+ *      4    bytes  local_groups_len        (length of the list of local groups)
+ *      4    bytes  localvars_count         (nb of localvars of processes)
+ *      4    bytes  sections_count          (number of receivers sections)
+ *
+ * local groups list: as in the report message
+ * localvars list: as in the report message
+ *
+ * receivers sections:
+ *    sections_count times
+ *          4    bytes  host                   (IP address of the receiver)
+ *          4    bytes  seq                    (report seq. nb. for that host)
+ *          4    bytes  local_sendint          (sending interval to that host)
+ *          4    bytes  remote_needed_sendint  (sendint needed from that host)
+ *          8    bytes  remote_epoch           (epoch timestamp of that host)
+ *          8    bytes  remote_largest_group_ts(largest group ts received from it)
+ */
+
+#define ALIVE_MULTICAST_SECTION_LEN (8*4)
+
+static inline char *msg_skip_alive_multicast_head(char *msg) {
+  return msg + 10*4 ;
+}
+
+static inline char *msg_build_alive_multicast_head(char *msg,
+  struct timeval *tv,
+  struct timeval *local_epoch,
+  u_int local_groups_list_seq,
+  u_int local_groups_count,
+  u_int local_groups_len,
+  u_int localvars_count,
+  u_int sections_count) {
+  char *ptr = msg ;
+  
+  put32(ptr, (unsigned int)MSG_ALIVE_MULTICAST) ; ptr += 4 ;
+  put32(ptr, (unsigned int)tv->tv_sec); ptr += 4 ;
+  put32(ptr, (unsigned int)tv->tv_usec); ptr += 4 ;
+  put32(ptr, (unsigned int)local_epoch->tv_sec); ptr += 4 ;
+  put32(ptr, (unsigned int)local_epoch->tv_usec); ptr += 4 ;
+  put32(ptr, (unsigned int)local_groups_list_seq); ptr += 4 ;
+  put32(ptr, (unsigned int)local_groups_count); ptr += 4 ;
+  put32(ptr, (unsigned int)local_groups_len); ptr += 4 ;
+  put32(ptr, (unsigned int)localvars_count); ptr += 4 ;
+  put32(ptr, (unsigned int)sections_count); ptr += 4 ;
+  
+  return ptr ;
+}
+
+static inline char *msg_parse_alive_multicast_head(char *msg,
+  struct timeval *tv,
+  struct timeval *remote_epoch,
+  u_int *remote_groups_list_seq,
+  u_int *remote_groups_count,
+  u_int *remote_groups_len,
+  u_int *remotevars_count,
+  u_int *sections_count) {
+  char *ptr = msg + 4 ;
+  
+  tv->tv_sec = get32(ptr); ptr += 4 ;
+  tv->tv_usec = get32(ptr); ptr += 4 ;
+  remote_epoch->tv_sec = get32(ptr); ptr += 4 ;
+  remote_epoch->tv_usec = get32(ptr); ptr += 4 ;
+  *remote_groups_list_seq = get32(ptr); ptr += 4 ;
+  *remote_groups_count = get32(ptr); ptr += 4 ;
+  *remote_groups_len = get32(ptr); ptr += 4 ;
+  *remotevars_count = get32(ptr); ptr += 4 ;
+  *sections_count = get32(ptr); ptr += 4 ;
+  
+  return ptr ;
+}
+
+static inline char *msg_build_alive_multicast_section(char *msg,
+  struct sockaddr_in *addr,
+  u_int seq,
+  u_int local_sendint,
+  u_int remote_needed_sendint,
+  struct timeval *remote_epoch,
+  struct timeval *remote_largest_group_ts) {
+  char *ptr = msg ;
+  
+  put32(ptr, (unsigned int)ntohl(addr->sin_addr.s_addr)); ptr += 4 ;
+  put32(ptr, (unsigned int)seq); ptr += 4 ;
+  put32(ptr, (unsigned int)local_sendint); ptr += 4 ;
+  put32(ptr, (unsigned int)remote_needed_sendint); ptr += 4 ;
+  put32(ptr, (unsigned int)remote_epoch->tv_sec); ptr += 4 ;
+  put32(ptr, (unsigned int)remote_epoch->tv_usec); ptr += 4 ;
+  put32(ptr, (unsigned int)remote_largest_group_ts->tv_sec); ptr += 4 ;
+  put32(ptr, (unsigned int)remote_largest_group_ts->tv_usec); ptr += 4 ;
+  
+  return ptr ;
+}
+
+static inline char *msg_parse_alive_multicast_section(char *msg,
+  struct sockaddr_in *addr,
+  u_int *seq,
+  u_int *remote_sendint,
+  u_int *local_needed_sendint,
+  struct timeval *local_epoch,
+  struct timeval *local_largest_group_ts) {
+  char *ptr = msg ;
+  
+  addr->sin_addr.s_addr = htonl(get32(ptr)); ptr += 4 ;
+  *seq = get32(ptr); ptr += 4 ;
+  *remote_sendint = get32(ptr); ptr += 4 ;
+  *local_needed_sendint = get32(ptr); ptr += 4 ;
+  local_epoch->tv_sec = get32(ptr); ptr += 4 ;
+  local_epoch->tv_usec = get32(ptr); ptr += 4 ;
+  local_largest_group_ts->tv_sec = get32(ptr); ptr += 4 ;
+  local_largest_group_ts->tv_usec = get32(ptr); ptr += 4 ;
+  
+  return ptr ;
+}
+
 /* INITIAL_ED message format
  *        4   bytes  type   (message type - MSG_INITIAL_ED)
  *        4   bytes  seq
@@ -26,6 +26,18 @@
 #define INITIAL_LOSS_PROBABILITY  0.01
 
 #define AVERAGE_DELAY_MAX_SAMPLES 128
+
+/* the INITIAL_ED stage stops before AVERAGE_DELAY_MAX_SAMPLES samples once
+ the confidence interval of the delay is within INITIAL_ED_TOLERANCE units
+ of it (an absolute bound, the delay includes the clock offset when the
+ clocks are not synchronized) and the standard error of its variance,
+ estimated from the fourth moment of the samples, within
+ INITIAL_VD_TOLERANCE of it (or INITIAL_VD_MIN_TOLERANCE units^2) */
+#define INITIAL_MIN_SAMPLES       16
+#define INITIAL_CONFIDENCE_Z      1.96 /* 95% */
+#define INITIAL_ED_TOLERANCE      2.0
+#define INITIAL_VD_TOLERANCE      0.25
+#define INITIAL_VD_MIN_TOLERANCE  1.0
 #define DELAYS_PERIOD_RECOMPUT    20
 
 #define MAX_LOSS_PROBABILITY 0.9
@@ -36,6 +48,17 @@
 
 #define ED_HALF_LIFE 4*UNITS_PER_SEC
 
+/* the phi accrual detector (DETECTOR_PHI): the inter-arrival times of the
+ messages of a host, in sendints announced by the host, are averaged over
+ the first PHI_SAMPLES of them, then weighted by 1/PHI_SAMPLES. A group
+ is suspected once phi exceeds
+ log10(TmrL / mean inter-arrival), kept within the bounds below. */
+#define PHI_SAMPLES               32
+#define PHI_MIN_SAMPLES           4
+#define PHI_MIN_DEVIATION         20.0  /* units */
+#define PHI_MIN_THRESHOLD         1.0
+#define PHI_MAX_THRESHOLD         12.0
+
 static void inline safety_increment(unsigned int *seq) {
   if(*seq != (unsigned int)(-1))
     (*seq)++ ;
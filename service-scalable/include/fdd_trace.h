@@ -0,0 +1,151 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_trace.h - binary event trace ring */
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <time.h>
+
+#define FDD_TRACE_FILE "/tmp/ddO_fdd-trace" /* the mmap'd trace ring */
+
+#define TRACE_MAGIC   0x46445454 /* "FDTT" */
+#define TRACE_VERSION 1
+
+#define TRACE_RING_RECORDS 65536 /* must be a power of two */
+
+/* event types */
+#define TRACE_REPORT_SENT    1  /* a: seq, b: msg len, c: local_needed_sendint */
+#define TRACE_REPORT_RCVD    2  /* a: seq, b: msg len, c: remote sendint */
+#define TRACE_REPORT_OOO     3  /* a: seq, b: last seq */
+#define TRACE_ESTIMATE       4  /* f: pl, e_d, v_d after a new sample */
+#define TRACE_SENDINT        5  /* a: old, b: new, c: TRACE_SENDINT_* */
+#define TRACE_HOST_SUSPECT   6  /* a: remote epoch sec */
+#define TRACE_NOTIFY         7  /* a: pid, b: gid (0 pt. to pt.), c: notif type */
+#define TRACE_LEADER_CHANGE  8  /* a: gid, b: pid, c: stable */
+
+#define TRACE_SENDINT_LOCAL_NEEDED  0 /* sendint the remote host needs from us */
+#define TRACE_SENDINT_REMOTE_NEEDED 1 /* sendint we need from the remote host */
+
+/* One fixed size record. The seq field is written last and holds the
+ ring position + 1, so a reader can tell a complete record from a
+ record that is being overwritten. */
+struct trace_record {
+  u_int64_t ts_ns ;           /* CLOCK_MONOTONIC */
+  u_int32_t seq ;
+  u_int16_t type ;
+  u_int16_t pad ;
+  u_int32_t addr ;            /* network order IPv4 address, 0 if none */
+  union {
+    u_int32_t u ;
+    float f ;
+  } arg[3] ;
+} ;
+
+/* Head of the mmap'd file, followed by TRACE_RING_RECORDS records */
+struct trace_ring {
+  u_int32_t magic ;
+  u_int32_t version ;
+  u_int32_t nb_records ;
+  u_int32_t record_size ;
+  int64_t realtime_offset_ns ; /* CLOCK_REALTIME - CLOCK_MONOTONIC at init */
+  volatile u_int64_t head ;    /* number of records ever written */
+  struct trace_record rec[0] ;
+} ;
+
+#define TRACE_RING_SIZE (sizeof(struct trace_ring) + \
+TRACE_RING_RECORDS * sizeof(struct trace_record))
+
+#ifdef TRACE
+
+extern struct trace_ring *trace_ring ;
+
+extern int trace_init(void) ;
+extern void trace_cleanup(void) ;
+
+static inline u_int64_t trace_now_ns(void) {
+  struct timespec ts ;
+  clock_gettime(CLOCK_MONOTONIC, &ts) ;
+  return (u_int64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec ;
+}
+
+/* Claims the next slot of the ring. There is a single writer (the select
+ loop), so no lock is needed: the record is filled, then published by
+ storing its seq after a barrier. */
+static inline struct trace_record *trace_begin(u_int16_t type,
+  struct sockaddr_in *addr) {
+  struct trace_record *rec ;
+  u_int64_t pos ;
+  
+  if(!trace_ring)
+    return NULL ;
+  pos = trace_ring->head ;
+  rec = &trace_ring->rec[pos & (TRACE_RING_RECORDS - 1)] ;
+  rec->seq = 0 ;
+  __sync_synchronize() ;
+  rec->ts_ns = trace_now_ns() ;
+  rec->type = type ;
+  rec->addr = addr ? addr->sin_addr.s_addr : 0 ;
+  return rec ;
+}
+
+static inline void trace_commit(struct trace_record *rec) {
+  u_int64_t pos = trace_ring->head ;
+  __sync_synchronize() ;
+  rec->seq = (u_int32_t)(pos + 1) ;
+  trace_ring->head = pos + 1 ;
+}
+
+static inline void trace_event(u_int16_t type, struct sockaddr_in *addr,
+  u_int32_t a, u_int32_t b, u_int32_t c) {
+  struct trace_record *rec = trace_begin(type, addr) ;
+  if(!rec)
+    return ;
+  rec->arg[0].u = a ;
+  rec->arg[1].u = b ;
+  rec->arg[2].u = c ;
+  trace_commit(rec) ;
+}
+
+static inline void trace_event_f(u_int16_t type, struct sockaddr_in *addr,
+  float a, float b, float c) {
+  struct trace_record *rec = trace_begin(type, addr) ;
+  if(!rec)
+    return ;
+  rec->arg[0].f = a ;
+  rec->arg[1].f = b ;
+  rec->arg[2].f = c ;
+  trace_commit(rec) ;
+}
+
+#else
+
+#define trace_init() (0)
+#define trace_cleanup() do { } while(0)
+#define trace_event(type, addr, a, b, c) do { } while(0)
+#define trace_event_f(type, addr, a, b, c) do { } while(0)
+
+#endif /* TRACE */
+
+#endif /* _TRACE_H */
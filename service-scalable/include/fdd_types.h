@@ -25,7 +25,9 @@
 #ifndef _TYPES_H
 #define _TYPES_Hlocal_proc
 
+#include <sys/types.h>
 #include "list.h"
+#include "fdd_gset.h"
 
 /* The Instantaneous stuff works only for the synchronized clocks */
 #ifndef SYNCH_CLOCKS
@@ -34,9 +36,30 @@
 #endif
 #endif
 
+/* Internal time: nanoseconds of CLOCK_MONOTONIC. Used for the event queue
+ and the report schedule of each host, so that steps of the wall clock
+ (NTP, date) don't stall or rush events. Wall clock timevals are kept
+ where they go on the wire or are compared with remote ones: the report
+ timestamps and delays of fdd_stats.c and the omega accusationTime and
+ startTime. The deadlines derived from them (suspicions, multicast) are
+ converted with wall2mono_ns() when queued, so a step only shifts the ones
+ computed across it. */
+typedef int64_t fdd_ns_t ;
+
 /* FIXME: make this dynamic? */
 #define MAX_MSG_LEN 1024
 
+/* reports longer than MAX_MSG_LEN are sent in at most REP_MAX_FRAGS
+ fragments, see MSG_REPORT_FRAG */
+#define REP_MAX_FRAGS 256
+
+/* the lists of processes of a report that can be left out once the
+ receiver acknowledged them, see the report delta trailer */
+#define REP_LIST_SERVERS 0 /* the local servers */
+#define REP_LIST_GROUPS  1
+#define REP_LIST_CLIENTS 2 /* the remote servers */
+#define REP_LISTS        3
+
 /* The carracteristics of the network */
 struct stats_est_struct {
   double e_d ; /* delay estimation */
@@ -50,14 +73,6 @@ struct link_failure_struct {
   struct timeval end_next_lf;
 } ;
 
-struct average_lost_struct {
-  unsigned int seq ;
-  //  struct timeval sending_ts ;
-  struct timeval arrival_ts ;
-  struct list_head lost_msg_list ;
-} ;
-
-
 #ifndef INSTANT_LOSS_PROBABILITY_OFF
 struct instant_lost_interval_struct {
   struct timeval begin_interval_ts ;
@@ -94,6 +109,11 @@ struct instant_delay_struct {
 /*  } ; */
 
 
+/* The sequence numbers received from a host and not yet taken into account
+ in its loss probability are kept in a sliding window of LOSS_WINDOW_BITS
+ bits, starting after last_average_seq. A power of two, multiple of 64. */
+#define LOSS_WINDOW_BITS      1024
+
 #define FINISHED_UNKNOWN      0
 #define FINISHED_YES          1
 #define FINISHED_NO           2
@@ -102,7 +122,9 @@ struct stats_struct {
 #ifndef INSTANT_LOSS_PROBABILITY_OFF
   struct list_head intervals_head ;
 #endif
-  struct list_head average_lost_head ;
+  u_int64_t average_window[LOSS_WINDOW_BITS / 64] ; /* bit seq % LOSS_WINDOW_BITS */
+  u_int average_arrival[LOSS_WINDOW_BITS] ;  /* arrival of the seqs in the window, in units */
+  unsigned int nb_average_pending ;          /* number of bits set in the window */
   unsigned int last_interval_length ;
   unsigned int current_interval_length ;
   
@@ -124,9 +146,53 @@ struct stats_struct {
   unsigned int nb_average_delay_msg ;
   int nb_average_recompute_period ;
   
+  /* inter-arrival times of the messages, for the phi detector */
+  struct timeval last_arrival_ts ;
+  unsigned int nb_interarrival ;
+  double interarrival_mean ;  /* in remote sendints */
+  double interarrival_var ;
+  unsigned int interarrival_sendint ; /* last remote sendint, units */
+  
+#ifndef SYNCH_CLOCKS
+  /* sums over the samples of average_delay_msg_head, kept as they enter
+   and leave it for recompute_expected_arrival(). The rank of a sample is
+   the number of samples with a smaller seq. */
+  unsigned int delay_base_seq ;     /* smallest seq of the samples */
+  long long sum_delay_arrival ;     /* arrival_ts, in usecs */
+  long long sum_delay_sendint ;     /* remote_sendint */
+  long long sum_delay_rank_sendint ; /* rank times remote_sendint */
+  long long sum_delay_seq ;         /* seq - delay_base_seq */
+#endif
+  
   struct stats_est_struct est ;
 } ;
 
+/* an omega accusation waiting to be sent to a host */
+struct accusation_struct {
+  unsigned int gid ;
+  struct timeval startTime ; /* startTime of the accused process */
+  struct list_head accusation_list ;
+} ;
+
+/* a fragmented report being reassembled */
+struct frag_struct {
+  unsigned int seq ;         /* seq number of the report */
+  unsigned int frag_count ;
+  unsigned int frags_rcvd ;
+  unsigned int len ;         /* length of the whole report */
+  u_int32_t rcvd[REP_MAX_FRAGS / 32] ; /* bitmap of the fragments received */
+  
+  /* enough of the report header to count it as an alive if it can't
+   be completed */
+  struct timeval sending_ts ;
+  struct timeval remote_epoch ;
+  struct timeval thought_local_epoch ;
+  unsigned int sendint ;
+  struct timeval arrival_ts ; /* arrival of the first fragment */
+  
+  char *msg ;
+} ;
+
 struct host_struct {
   struct sockaddr_in addr ;
   struct timeval remote_epoch ; /* timestamp of the starting remote host */
@@ -144,12 +210,18 @@ struct host_struct {
   
   unsigned int hello_seq ;      /* seq number of the last hello multicast
    msg received from this host */
+  struct list_head hello_groups_head ; /* the groups of its last HELLO */
+  u_int64_t hello_digest ;      /* their digest */
+  struct timeval hello_digest_ts ; /* last HELLO or HELLO digest that
+   confirmed them, cleared while they are not known */
   
   /*    unsigned int seq ;		 *//* seq number of last report */
   unsigned int local_seq ;      /* local seq at the last report time */
   
-  struct timeval last_report_ts ; /* timestamp of last sent report */
-  struct timeval next_report_ts ; /* timestamp of next report */
+  fdd_ns_t last_report_ns ; /* monotonic time of last sent report */
+  fdd_ns_t next_report_ns ; /* monotonic time of next report */
+  struct event_struct *report_event ; /* its EVENT_REPORT in the event
+   list, NULL if none is pending */
   
   struct timeval local_largest_group_ts_rcvd; /* The largest local group
    timestamp received from that host. */
@@ -160,6 +232,29 @@ struct host_struct {
   unsigned int remote_needed_sendint ;
   unsigned int local_needed_sendint ;
   
+  unsigned int wire_version ; /* most recent wire format it understands */
+  
+  struct frag_struct *frag ; /* report being reassembled, NULL if none */
+  
+  /* accusations for it, sent with the next report or after
+   ACCUSATION_FLUSH_DELAY, see local_queue_accusation() */
+  struct list_head accusations_head ;
+  unsigned int accusations_count ;
+  
+  int mcast_covered ; /* 1 if our alives reach it through the group
+   alive multicast, see local_send_alive_multicast() */
+  
+  /* lists of processes left out of the reports, indexed by REP_LIST_* */
+  unsigned int lists_seq[REP_LISTS] ; /* our list seq of our last lists */
+  unsigned int lists_digest[REP_LISTS] ; /* digest of our last lists */
+  unsigned int lists_changed_seq[REP_LISTS] ; /* our report seq when they
+   last changed */
+  unsigned int lists_acked_seq[REP_LISTS] ; /* our report seq of the
+   lists it last applied */
+  unsigned int lists_applied_seq[REP_LISTS] ; /* its report seq of its
+   lists we last applied */
+  struct timeval last_snapshot_ts ; /* last report with all the lists */
+  
   struct list_head remote_host_list ;
   
   /* list of remote servers last received from that host */
@@ -171,6 +266,7 @@ struct host_struct {
   
   /* list of jointly groups between the local host and this host */
   struct list_head jointly_groups_head ;
+  struct gset jointly_groups_set ; /* the same groups, as a set */
   /* list of non_jointly_groups between the local host and this host */
   struct list_head remote_all_groups_head ;
   /* list of the remote processes last received, that are in the jointly groups */
@@ -190,6 +286,7 @@ struct host_struct {
   
   unsigned int remote_groups_list_seq ; /* seq. nb. of the remote groups list */
   unsigned int remote_groups_multicast_list_seq ;
+  unsigned int remote_groups_alive_list_seq ; /* of its alive multicast */
 } ;
 
 /* generic list of u_int values */
@@ -243,8 +340,11 @@ struct procqos_struct {
 struct groupqos_struct {
   unsigned int gid ;
   unsigned int int_type ;
+  unsigned int detector ;  /* DETECTOR_CHEN or DETECTOR_PHI */
   struct qos_struct *qos ; /* when qos == NULL is not monitoring */
   struct list_head gqlist ;
+  struct localproc_struct *lproc ; /* the process in the group */
+  struct list_head members_list ; /* in local_group_members(gid) */
 } ;
 
 struct procgroup_struct {
@@ -266,6 +366,10 @@ struct trust_struct {
 #define INTERRUPT_ANY_CHANGE	1
 #define INT_SET_FAIL	        2
 
+/* how the freshness points of the processes of a group are computed */
+#define DETECTOR_CHEN           0  /* expected arrival and wei_sendint margin */
+#define DETECTOR_PHI            1  /* phi accrual, see phi_fresh_point() */
+
 struct localproc_struct {
   unsigned int pid ;
   struct list_head pqlist_head ;  /* remote processes interested in this process */
@@ -288,6 +392,8 @@ struct delay_struct {
 #define EVENT_HELLO         4
 #define EVENT_INITIAL_ED    5
 #define EVENT_SUSPECT_GROUP 6
+#define EVENT_MCAST_ALIVE   7
+#define EVENT_ACCUSATIONS   8
 
 struct event_struct {
   int type ;
@@ -296,7 +402,7 @@ struct event_struct {
   struct delay_struct *delay ;
   struct host_struct *host ;
   struct uint_struct *remote_group ;
-  struct timeval tv ;
+  fdd_ns_t due_ns ; /* monotonic time at which the event must run */
   struct list_head event_list ;
 };
 
@@ -0,0 +1,43 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+/* fdd_vis.h - set of the (pid, gid) pairs in which a local process is
+ visible, mirroring visibility_list_head for constant time lookups */
+#ifndef _VIS_H
+#define _VIS_H
+
+#include <sys/types.h>
+
+#define VIS_MIN_SLOTS 256 /* initial size of the table, a power of two */
+
+/* vis_test results, as is_in_ordered_visibility_list used to return */
+#define VIS_ABSENT    -1 /* the process has no visibility entry */
+#define VIS_INVISIBLE  0
+#define VIS_VISIBLE    1
+
+extern int vis_add_proc(u_int pid) ;
+extern void vis_del_proc(u_int pid) ;
+extern int vis_add(u_int pid, u_int gid) ;
+extern void vis_del(u_int pid, u_int gid) ;
+extern int vis_test(u_int pid, u_int gid) ;
+extern void vis_cleanup(void) ;
+
+#endif /* _VIS_H */
@@ -0,0 +1,83 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_warm.h - network estimates of the hosts kept across restarts */
+#ifndef _WARM_H
+#define _WARM_H
+
+#include <sys/types.h>
+#include <sys/time.h>
+
+#define FDD_WARM_FILE "/tmp/ddO_fdd-warm" /* the mmap'd estimates */
+
+#define WARM_MAGIC   0x46445757 /* "FDWW" */
+#define WARM_VERSION 1
+
+#define WARM_ENTRIES 1024 /* must be a power of two */
+#define WARM_PROBES  8    /* slots looked at for a host */
+
+#define WARM_MAX_AGE     3600 /* seconds: older estimates are not used */
+#define WARM_VAR_INFLATE 4.0  /* the delay variance of a restarted host is
+ overestimated until enough new samples are received */
+
+/* the last estimates of a host, updated with every new sample */
+struct warm_entry {
+  u_int32_t addr ;      /* network order IPv4 address, 0 if free */
+  u_int32_t saved_sec ; /* wall clock of the last update */
+  double e_d ;
+  double v_d ;
+  double pl ;
+} ;
+
+/* Head of the mmap'd file, followed by WARM_ENTRIES entries */
+struct warm_file {
+  u_int32_t magic ;
+  u_int32_t version ;
+  u_int32_t nb_entries ;
+  u_int32_t entry_size ;
+  struct warm_entry ent[0] ;
+} ;
+
+#define WARM_FILE_SIZE (sizeof(struct warm_file) + \
+WARM_ENTRIES * sizeof(struct warm_entry))
+
+struct host_struct ;
+
+#ifdef WARM_START
+
+extern int warm_init(void) ;
+extern void warm_cleanup(void) ;
+extern int warm_seed(struct host_struct *host, struct timeval *now) ;
+extern void warm_save(struct host_struct *host, struct timeval *now) ;
+
+#else
+
+#define warm_init() (0)
+#define warm_cleanup() do { } while(0)
+static inline int warm_seed(struct host_struct *host, struct timeval *now) {
+  return 0 ;
+}
+#define warm_save(host, now) do { } while(0)
+
+#endif /* WARM_START */
+
+#endif /* _WARM_H */
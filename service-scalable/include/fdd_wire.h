@@ -0,0 +1,94 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_wire.h - compact wire format of the report messages */
+#ifndef _WIRE_H
+#define _WIRE_H
+
+#include <sys/types.h>
+#include <sys/time.h>
+
+/* wire format versions. A host receives compact reports only once it
+ advertised WIRE_VERSION_COMPACT in its HELLO, or sent a compact report,
+ reports leaving out the lists it acked once it advertised
+ WIRE_VERSION_DELTA, HELLO digests once every known host advertised
+ WIRE_VERSION_HELLO_DIGEST, and the omega accusations in the reports once
+ it advertised WIRE_VERSION_ACCUSATIONS. */
+#define WIRE_VERSION_FIXED   0
+#define WIRE_VERSION_COMPACT 1
+#define WIRE_VERSION_DELTA   2
+#define WIRE_VERSION_HELLO_DIGEST 3
+#define WIRE_VERSION_ACCUSATIONS 4
+#define WIRE_VERSION WIRE_VERSION_ACCUSATIONS
+
+#define WIRE_NSECS_PER_SEC  1000000000LL
+#define WIRE_NSECS_PER_USEC 1000LL
+
+/* put_varint - LEB128 encoding: 7 bits per byte, least significant first */
+static inline unsigned char *put_varint(unsigned char *ptr, u_int64_t val) {
+  while(val >= 0x80) {
+    *ptr++ = (unsigned char)(val | 0x80) ;
+    val >>= 7 ;
+  }
+  *ptr++ = (unsigned char)val ;
+  return ptr ;
+}
+
+/* get_varint - returns NULL if the value does not end before end */
+static inline unsigned char *get_varint(unsigned char *ptr, unsigned char *end,
+  u_int64_t *val) {
+  int shift = 0 ;
+  
+  *val = 0 ;
+  while(ptr < end && shift < 64) {
+    *val |= (u_int64_t)(*ptr & 0x7f) << shift ;
+    if(!(*ptr++ & 0x80))
+      return ptr ;
+    shift += 7 ;
+  }
+  return NULL ;
+}
+
+/* zigzag - maps small negative values on small unsigned ones */
+static inline u_int64_t zigzag(int64_t val) {
+  return ((u_int64_t)val << 1) ^ (u_int64_t)(val >> 63) ;
+}
+
+static inline int64_t unzigzag(u_int64_t val) {
+  return (int64_t)(val >> 1) ^ -(int64_t)(val & 1) ;
+}
+
+/* timestamps travel as nanoseconds, the fixed format has 32 bits seconds */
+static inline int64_t wire_tv2ns(struct timeval *tv) {
+  return (int64_t)(unsigned int)tv->tv_sec * WIRE_NSECS_PER_SEC +
+  (int64_t)(unsigned int)tv->tv_usec * WIRE_NSECS_PER_USEC ;
+}
+
+static inline void wire_ns2tv(int64_t ns, struct timeval *tv) {
+  tv->tv_sec = ns / WIRE_NSECS_PER_SEC ;
+  tv->tv_usec = (ns % WIRE_NSECS_PER_SEC) / WIRE_NSECS_PER_USEC ;
+}
+
+extern int msg_compact_report(char *msg, int msg_len, char *out, int out_len) ;
+extern int msg_expand_report(char *msg, int msg_len, char *out, int out_len) ;
+
+#endif
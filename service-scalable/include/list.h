@@ -253,7 +253,11 @@ for (pos = (head)->prev ; pos != (head) ; pos = pos->prev)
   list_for_each(tmp_vis, &visibility_list_head) {									  \
     pid_gid = list_entry(tmp_vis, struct pid_gid_visibility_struct, pid_list_head);   \
     if (pid == pid_gid->pid) {														  \
+      struct list_head *tmp_gcell;                                                  \
+      list_for_each(tmp_gcell, &pid_gid->gid_list_head)                             \
+        vis_del(pid, list_entry(tmp_gcell, struct glist_struct, gcell)->gid);       \
       visibility_list_groups_free(&pid_gid->gid_list_head);						  \
+      vis_del_proc(pid);                                                            \
       list_del(&pid_gid->pid_list_head);                                            \
       free(pid_gid);																  \
       break;																		  \
@@ -285,6 +289,7 @@ for (pos = (head)->prev ; pos != (head) ; pos = pos->prev)
       list_for_each(tmp_gid, &pid_gid->gid_list_head) {									    \
         gid_struct = list_entry(tmp_gid, struct glist_struct, gcell);    			        \
         if (gid_struct->gid == gid) {													    \
+          vis_del(pid, gid);																\
           list_del(tmp_gid);																\
           free(gid_struct);														        \
           break;																			\
@@ -43,6 +43,9 @@
 #define INTERRUPT_NONE	        0
 #define INTERRUPT_ANY_CHANGE	1
 
+#define DETECTOR_CHEN           0
+#define DETECTOR_PHI            1
+
 
 extern inline int sockaddr_smaller(struct sockaddr_in *a, struct sockaddr_in *b);
 extern inline int sockaddr_eq(struct sockaddr_in *a, struct sockaddr_in *b);
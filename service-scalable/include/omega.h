@@ -47,6 +47,8 @@ extern struct sockaddr_in omega_localaddr;
 extern int omega_fifo_fd ;
 extern struct list_head localregistered_proc_head;
 extern void omega_local_init();
+extern void omega_local_cleanup(void);
+extern struct list_head *omega_group_notifs(unsigned int gid);
 extern void check_omega_fifo(fd_set *active, fd_set *dset, struct timeval *now);
 extern void omega_local_check_pipes(fd_set *active, fd_set *dset, struct timeval *now);
 
@@ -63,6 +65,7 @@ extern void omega_fifo_cleanup(void);
 /* Omega remote module */
 extern int omega_udp_socket;
 extern void check_omega_socket(fd_set *active, struct timeval *now);
+extern void send_accusation_msg(struct sockaddr_in *raddr, char *msg, int msg_len);
 extern void send_accusation(struct sockaddr_in *raddr, u_int gid, struct timeval *startTime);
 extern void accusation_merge(char *msg, int msg_len, struct sockaddr_in *cliAddr, struct timeval *now);
 
@@ -77,9 +80,11 @@ extern inline int add_proc_in_localContenders_set(struct sockaddr_in *addr, u_in
 extern inline int remove_proc_from_localContenders_set(struct sockaddr_in *addr, u_int pid, u_int gid);
 extern inline int add_proc_in_globalContenders_set(struct sockaddr_in *addr, u_int pid, u_int gid);
 extern inline int remove_proc_from_globalContenders_set(struct sockaddr_in *addr, u_int pid, u_int gid);
+extern void contenders_release_class(struct contenders_struct *contenders);
 extern inline int updateLocalLeader(unsigned int gid, struct timeval *now);
 extern inline int updateGlobalLeader(unsigned int gid, struct timeval *now);
-extern int updateGlobalLeaders(struct timeval *now);
+extern int mark_global_leader_dirty(unsigned int gid);
+extern int updateDirtyGlobalLeaders(struct timeval *now);
 extern inline void doUponSuspected(struct sockaddr_in *addr, u_int pid, u_int gid, struct timeval *now);
 extern inline void doUponReceivedAccusation(u_int gid, struct timeval *startTime, struct timeval *now);
 
@@ -90,16 +95,20 @@ extern int fdd_init();
 extern void terminate_fdd();
 extern void check_fd_socket(fd_set *active, struct timeval *now);
 extern void fd_sched_run(struct timeval *timeout, struct timeval *now);
+extern void fdd_poll(struct timeval *now);
 
 /* Failure detector local module */
 extern int isalive(unsigned int pid);
 extern int fdd_local_reg(unsigned int pid, struct timeval *now);
 extern int fdd_local_unreg(unsigned int pid, struct timeval *now);
+extern int local_queue_accusation(struct sockaddr_in *addr, u_int gid,
+  struct timeval *startTime, struct timeval *now);
 extern int do_join_group(unsigned int pid, unsigned int gid, struct timeval *now);
 extern int do_join_group_invisible(unsigned int pid, unsigned int gid, int candidate, struct timeval *now);
 extern int do_leave_group(unsigned int pid, unsigned int gid, struct timeval *now);
 extern int do_monitor_group(unsigned int pid, unsigned int gid, unsigned int int_type, unsigned int TdU,
 unsigned int TmU, unsigned int TmrL, struct timeval *now);
 extern int do_stop_monitor_group(unsigned int pid, unsigned int gid, struct timeval *now);
+extern int do_set_group_detector(unsigned int pid, unsigned int gid, unsigned int detector);
 extern int do_stop_sending_alives(unsigned int pid, unsigned int gid, struct timeval *now);
 extern int do_restart_sending_alives(unsigned int pid, unsigned int gid, struct timeval *now);
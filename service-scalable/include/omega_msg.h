@@ -49,6 +49,8 @@
 #define MSG_OMEGA_RESULT 28
 #define MSG_OMEGA_EXT_RESULT 29
 
+#define MSG_OMEGA_DETECTOR_MODE 31
+
 /****************************************/
 /* messages going through network links */
 /****************************************/
@@ -166,6 +168,29 @@ static inline char *msg_omega_parse_int(char *msg, int *notif_type, u_int *gid)
 }
 
 
+/*
+ * DETECTOR MODE message format (all fields are network byte order):
+ *	4    bytes  type	(message type - MSG_OMEGA_DETECTOR_MODE)
+ *  4 	 bytes  detector  (OMEGA_DETECTOR_CHEN or OMEGA_DETECTOR_PHI)
+ *	4    bytes  gid		(group ID)
+ */
+
+static inline char *msg_omega_build_detector(char *msg, int detector, u_int gid) {
+  char *ptr = msg;
+  put32(ptr, (unsigned int)MSG_OMEGA_DETECTOR_MODE); ptr += 4;
+  put32(ptr, (unsigned int)detector); ptr += 4;
+  put32(ptr, (unsigned int)gid); ptr += 4;
+  return ptr;
+}
+
+static inline char *msg_omega_parse_detector(char *msg, int *detector, u_int *gid) {
+  char *ptr = msg + 4;
+  *detector = get32(ptr); ptr += 4;
+  *gid = get32(ptr); ptr += 4;
+  return ptr;
+}
+
+
 /*
  * Notification message format (all fields are network byte order):
  *	4    bytes  type	(message type - MSG_OMEGA_NOTIFY)
@@ -281,25 +306,37 @@ static inline char *msg_omega_parse_ext_res(char *msg, int *result, struct socka
 
 /*
  * Accusation message format (all fields are network byte order):
- *	4    bytes  type	(message type - MSG_OMEGA_EXT_RESULT)
+ *	4    bytes  type	(message type - MSG_OMEGA_ACCUSATION)
+ *   1 to OMEGA_MAX_ACCUSATIONS times (up to the end of the message):
  *  4	 byte   gid
  *	4    bytes  startTime.tv_sec
  *  4    bytes  startTime.tv_usec
  */
 
-static inline char *msg_omega_build_accusation(char *msg, u_int gid, struct timeval *startTime) {
+/* OMEGA_ACCUSATION_LEN and OMEGA_MAX_ACCUSATIONS are in omega_remote.h */
+
+static inline char *msg_omega_build_accusation_entry(char *msg, u_int gid, struct timeval *startTime) {
   char *ptr = msg;
-  put32(ptr, (unsigned int)MSG_OMEGA_ACCUSATION); ptr += 4;
   put32(ptr, (unsigned int)gid); ptr += 4;
   put32(ptr, (unsigned int)startTime->tv_sec); ptr += 4;
   put32(ptr, (unsigned int)startTime->tv_usec); ptr += 4;
   return ptr;
 }
 
-static inline char *msg_omega_parse_accusation(char *msg, u_int *gid, struct timeval *startTime) {
-  char *ptr = msg + 4;
+static inline char *msg_omega_build_accusation(char *msg, u_int gid, struct timeval *startTime) {
+  char *ptr = msg;
+  put32(ptr, (unsigned int)MSG_OMEGA_ACCUSATION); ptr += 4;
+  return msg_omega_build_accusation_entry(ptr, gid, startTime);
+}
+
+static inline char *msg_omega_parse_accusation_entry(char *msg, u_int *gid, struct timeval *startTime) {
+  char *ptr = msg;
   *gid = get32(ptr); ptr += 4;
   startTime->tv_sec = get32(ptr); ptr += 4;
   startTime->tv_usec = get32(ptr); ptr += 4;
   return ptr;
 }
+
+static inline char *msg_omega_parse_accusation(char *msg, u_int *gid, struct timeval *startTime) {
+  return msg_omega_parse_accusation_entry(msg + 4, gid, startTime);
+}
@@ -25,7 +25,9 @@
 
 #include <netinet/in.h>
 
-#define OMEGA_UDP_MSG_LEN 16
+#define OMEGA_ACCUSATION_LEN (3*4)
+#define OMEGA_MAX_ACCUSATIONS 64 /* per accusation message */
+#define OMEGA_UDP_MSG_LEN (4 + OMEGA_MAX_ACCUSATIONS*OMEGA_ACCUSATION_LEN)
 
 /* The server socket file descriptor */
 int omega_udp_socket;
@@ -34,13 +34,18 @@
 #define NOT_CANDIDATE 0
 #define CANDIDATE 1
 
+#define OMEGA_DETECTOR_CHEN	0
+#define OMEGA_DETECTOR_PHI	1
+
 
 struct notif_type_struct {
   int notif_type;
   unsigned int gid;
   int already_notified;    /* says if the process has already been notified for a particular group */
   int candidate;   /* tells if the process is a candidate for the leadership of group gid. */
+  struct localregistered_proc_struct *rproc;  /* the process owning the entry */
   struct list_head notif_type_list;
+  struct list_head group_list;  /* the entries of the group gid, see omega_group_notifs() */
 } ;
 
 
@@ -51,14 +56,43 @@ struct proc_struct {
   struct list_head proc_list;
 } ;
 
+/* A contender of a class, see struct contender_class */
+struct class_proc_struct {
+  struct sockaddr_in addr;
+  unsigned int pid;
+  int local;        /* 1 if addr is the local address */
+} ;
+
+/* The groups whose global contenders set holds the same processes share a
+ class: the contenders are resolved once for all of them and only the
+ accusationTimes are read per group. The processes are sorted by address,
+ then pid. */
+struct contender_class {
+  u_int32_t sig;    /* hash of the processes, to tell classes apart quickly */
+  int nb_procs;
+  int nb_remote;    /* number of contenders that are not local */
+  int refcount;     /* number of contenders sets of the class */
+  struct class_proc_struct *procs;
+  struct list_head class_list;
+} ;
+
 /* A struct storing a list of processes for each group */
 struct contenders_struct {
   unsigned int gid;
   struct list_head procs_list;
+  struct contender_class *cclass;  /* global contenders only, NULL until needed */
   struct list_head contenders_list;
 } ;
 
 
+/* A struct storing the gid of a group whose global leader has to be
+ recomputed at the end of the current loop iteration. */
+struct dirty_group_struct {
+  unsigned int gid;
+  struct list_head dirty_list;
+} ;
+
+
 /* A struct storing leaders of groups. A leader is composed of
  an address and a pid. */
 struct leaders_struct {
@@ -32,6 +32,9 @@
 #define NOT_CANDIDATE 0
 #define CANDIDATE 1
 
+#define OMEGA_DETECTOR_CHEN	0
+#define OMEGA_DETECTOR_PHI	1
+
 struct omega_proc_struct {
   struct sockaddr_in addr;
   unsigned int pid;
@@ -51,3 +54,4 @@ extern int omega_parse_notify(int omega_int, struct omega_proc_struct *leader);
 extern int omega_getleader(int omega_int, unsigned int gid, struct omega_proc_struct *leader);
 extern int omega_interrupt_any_change(int omega_int, unsigned int gid);
 extern int omega_interrupt_none(int omega_int, unsigned int gid);
+extern int omega_detector_mode(int omega_int, unsigned int gid, int detector);
@@ -39,7 +39,8 @@ struct vars_struct {
 } ;
 
 
-/* A struct containing the variable of a remote process */
+/* A struct containing the variable of a remote process, for the remotevars
+ lists built by the utilities procedures */
 struct remotevars_struct {
   struct sockaddr_in addr;       /* The adress of the computer thas maintains these vars */
   struct list_head vars_head;    /* The list of vars_struct (one struct per group) */
@@ -47,21 +48,45 @@ struct remotevars_struct {
 } ;
 
 
+/* The variables of the remote processes are kept in an open addressing
+ table keyed by (IPv4 address, gid). The slots of a host are chained, so
+ that they are dropped without looking at the other hosts. */
+struct remotevars_slot {
+  u_int32_t addr;               /* network order IPv4 address */
+  u_int gid;
+  int state;                    /* RVARS_FREE, RVARS_USED or RVARS_DELETED */
+  int next;                     /* next slot of the same host, -1 if none */
+  struct timeval accusationTime;
+  struct timeval startTime;
+} ;
+
+/* The head of the chain of the slots of a host */
+struct remotevars_host {
+  u_int32_t addr;
+  int state;
+  int first;                    /* first slot of the host, -1 if none */
+} ;
+
+#define RVARS_FREE    0
+#define RVARS_USED    1
+#define RVARS_DELETED 2
+
+#define RVARS_MIN_SLOTS 64      /* initial size of the tables, a power of two */
+
+
 /* The list of variables of local processes */
 struct list_head localvars_head;
 
-/* The list of variables of remote processes */
-struct list_head remotevars_head;
-
 
 int exchange_vars_init();
+void exchange_vars_cleanup();
 
 
 /*****************************************************************************/
 /* The following procedures are utilities procedures that deal with          */
 /* remotevars lists (not the global variable!)                               */
 /*****************************************************************************/
-inline int insert_remotevars_in_list(struct sockaddr_in *addr, u_int gid, struct timeval *accusationTime,
+int insert_remotevars_in_list(struct sockaddr_in *addr, u_int gid, struct timeval *accusationTime,
 struct timeval *startTime, struct list_head *remotevars);
 void print_remotvars_list(FILE *stream, struct list_head *remotevars_list);
 void free_remotevars_list(struct list_head *remotevars_list);
@@ -76,7 +101,7 @@ void free_remotevars_list(struct list_head *remotevars_list);
 /* The following procedures procedures deal with the localvars list          */
 /*****************************************************************************/
 
-inline int create_localvars(unsigned int gid);
+int create_localvars(unsigned int gid);
 inline void remove_localvars(unsigned int gid);
 inline int localvars_exist(unsigned int gid);
 inline int getlocalvars(unsigned int gid, struct timeval *accusationTime, struct timeval *startTime);
@@ -94,12 +119,12 @@ inline int set_local_startTime(unsigned int gid);
 /* The following procedures deal with the remotevars list                    */
 /*****************************************************************************/
 
-inline int get_accusationTime_of_remoteprocess(struct sockaddr_in *addr, u_int gid,
+int get_accusationTime_of_remoteprocess(struct sockaddr_in *addr, u_int gid,
 struct timeval *accusationTime);
-inline int get_startTime_of_remoteprocess(struct sockaddr_in *addr, u_int gid,
+int get_startTime_of_remoteprocess(struct sockaddr_in *addr, u_int gid,
 struct timeval *startTime);
-inline int get_remote_vars_of_group(u_int gid, struct list_head *remotevars);
-inline int insert_in_remotevars(struct sockaddr_in *addr, unsigned int gid,
+int get_remote_vars_of_group(u_int gid, struct list_head *remotevars);
+int insert_in_remotevars(struct sockaddr_in *addr, unsigned int gid,
 struct timeval *accusationTime, struct timeval *startTime);
 int free_host_in_remotevars_list(struct sockaddr_in *addr);
 
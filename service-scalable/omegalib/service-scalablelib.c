@@ -389,3 +389,31 @@ extern int omega_interrupt_none(int omega_int, u_int gid) {
   return omega_interrupt_generic(omega_int, OMEGA_INTERRUPT_NONE, gid) ;
 }
 
+
+/* selects how the failure detector suspects the processes of the group
+ gid, OMEGA_DETECTOR_CHEN or OMEGA_DETECTOR_PHI. omega must have been
+ started in the group. */
+extern int omega_detector_mode(int omega_int, u_int gid, int detector) {
+  
+  struct registeredproc_struct *rproc;
+  char msg[OMEGA_FIFO_MSG_LEN];
+  int retval;
+  
+  pthread_mutex_lock(&registeredproc_list_mutex);
+  rproc = lookup_rproc(omega_int);
+  retval = -EINVAL;
+  if (rproc == NULL)
+    goto out;
+  
+  msg_omega_build_detector(msg, detector, gid);
+  retval = write_msg(rproc->omega_cmd_fd, msg, OMEGA_FIFO_MSG_LEN);
+  if (retval < 0) {
+    fprintf(stdout, "omega_detector_mode: write cmd pipe error\n") ;
+    goto out;
+  }
+  retval = omega_wait_for_result(rproc, NULL);
+  
+  out:
+  pthread_mutex_unlock(&registeredproc_list_mutex);
+  return retval;
+}
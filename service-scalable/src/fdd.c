@@ -67,6 +67,13 @@ void terminate_fdd() {
   struct timeval now ;
   
   comm_cleanup();
+  trace_cleanup();
+  warm_cleanup();
+  local_cleanup();
+  remote_cleanup();
+  gset_cleanup();
+  vis_cleanup();
+  metrics_cleanup();
   
   if(gettimeofday(&now, NULL) < 0)
     perror("gettimeofday") ;
@@ -121,36 +128,40 @@ char* getNameFile() {
 }
 
 
-/* check_fd_socket - reads a remote report from the UDP socket */
-void check_fd_socket(fd_set *active, struct timeval *now) {
-  char msg[SAFE_MSG_LEN] ;
-  int msg_len ;
-  struct sockaddr_in raddr;
-  
-  if(!FD_ISSET(fd_udp_socket, active))
-    goto out;
-  
-  msg_len = comm_recv(msg, MAX_MSG_LEN, &raddr);
-  if(msg_len < 0) {
-    fprintf(stderr, "fdd: comm_recv() failed:%s\n", strerror(-msg_len));
-    goto out ;
-  }
-  
-  if(sockaddr_eq(&raddr, &fdd_local_addr)) { /* my message */
-    goto out ;
-  }
-  
+/* fd_dispatch_msg - hands a received message to its module */
+static void fd_dispatch_msg(char *msg, int msg_len, struct sockaddr_in *raddr,
+  struct timeval *now) {
   switch (msg_type(msg)) {
     case MSG_REPORT:
-    remote_merge(msg, msg_len, &raddr, now);
+    remote_merge(msg, msg_len, raddr, now);
+    break ;
+    
+    case MSG_REPORT_FRAG:
+    remote_frag_merge(msg, msg_len, raddr, now);
+    break ;
+    
+    case MSG_REPORT_COMPACT:
+    remote_compact_merge(msg, msg_len, raddr, now);
     break ;
     
     case MSG_HELLO:
-      hello_multicast_merge(msg, msg_len, &raddr, now) ;
+      hello_multicast_merge(msg, msg_len, raddr, now) ;
+    break ;
+    
+    case MSG_HELLO_DIGEST:
+      hello_digest_merge(msg, msg_len, raddr, now) ;
+    break ;
+    
+    case MSG_HELLO_REQUEST:
+      hello_request_merge(msg, msg_len, raddr, now) ;
     break ;
     
     case MSG_INITIAL_ED:
-    initial_ed_merge(msg, msg_len, &raddr, now) ;
+    initial_ed_merge(msg, msg_len, raddr, now) ;
+    break ;
+    
+    case MSG_ALIVE_MULTICAST:
+    remote_alive_multicast_merge(msg, msg_len, raddr, now) ;
     break ;
     
     default:
@@ -158,11 +169,57 @@ void check_fd_socket(fd_set *active, struct timeval *now) {
     msg_type(msg));
     break;
   }
+}
+
+
+/* check_fd_socket - reads the remote reports queued on the UDP socket,
+ at most FDD_RECV_BATCH of them, so that a wake up of the select loop
+ is not paid for every single datagram. now is updated for each one. */
+void check_fd_socket(fd_set *active, struct timeval *now) {
+  char msg[SAFE_MSG_LEN] ;
+  int msg_len ;
+  int n ;
+  struct sockaddr_in raddr;
+  
+  if(!FD_ISSET(fd_udp_socket, active))
+    goto out;
+  
+  for(n = 0 ; n < FDD_RECV_BATCH ; n++) {
+    msg_len = comm_recv(msg, MAX_MSG_LEN, &raddr);
+    if(msg_len == -EAGAIN || msg_len == -EWOULDBLOCK)
+      break ;
+    if(msg_len < 0) {
+      fprintf(stderr, "fdd: comm_recv() failed:%s\n", strerror(-msg_len));
+      break ;
+    }
+    if(n)
+      gettimeofday(now, NULL) ;
+    
+    if(sockaddr_eq(&raddr, &fdd_local_addr)) /* my message */
+      continue ;
+    
+    fd_dispatch_msg(msg, msg_len, &raddr, now) ;
+  }
   out:
   return;
 }
 
 
+/* fdd_poll - gives the failure detector a chance to run while the omega
+ layer is busy with client commands: reads the pending datagrams without
+ blocking, then executes the due events. now is updated. */
+extern void fdd_poll(struct timeval *now) {
+  fd_set active ;
+  
+  FD_ZERO(&active) ;
+  FD_SET(fd_udp_socket, &active) ;
+  gettimeofday(now, NULL) ;
+  check_fd_socket(&active, now) ;
+  gettimeofday(now, NULL) ;
+  fd_sched_run(NULL, now) ;
+}
+
+
 /* fdd_init - calls all initialization functions, returns the fd udp socket file
  descriptor */
 extern int fdd_init() {
@@ -226,6 +283,14 @@ extern int fdd_init() {
   fprintf(flog, "fdd: port %u\n", ntohs(saddr.sin_port));
 #endif
   
+  /* the trace ring is optional: run without it if it can't be mapped */
+  if(trace_init() < 0)
+    fprintf(stderr, "fdd: trace_init() failed, tracing disabled.\n");
+  
+  /* likewise for the estimates kept across restarts */
+  if(warm_init() < 0)
+    fprintf(stderr, "fdd: warm_init() failed, warm start disabled.\n");
+  
   /* open a socket for the broadcast communication. */
   if( (fd_udp_socket = comm_init(&saddr)) < 0 ) {
     fprintf(stderr, "fdd: comm_init() failed.\n");
@@ -0,0 +1,52 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+/* fdd_arena.c - bump allocator for the data living as long as one
+ * message: a report is parsed without a malloc() per process and what
+ * was parsed goes away in one step. */
+#include <errno.h>
+#include <stdlib.h>
+#include "fdd_arena.h"
+
+/* arena_reserve - makes room for size bytes, of which ARENA_ALIGN - 1
+ may be lost per allocation. Only for an arena with nothing allocated.
+ Returns 0 on success, -ENOMEM on failure. */
+extern int arena_reserve(struct arena *a, size_t size) {
+  char *base ;
+  
+  a->used = 0 ;
+  if(size <= a->size)
+    return 0 ;
+  
+  base = realloc(a->base, size) ;
+  if(base == NULL)
+    return -ENOMEM ;
+  a->base = base ;
+  a->size = size ;
+  return 0 ;
+}
+
+extern void arena_free(struct arena *a) {
+  free(a->base) ;
+  a->base = NULL ;
+  a->size = 0 ;
+  a->used = 0 ;
+}
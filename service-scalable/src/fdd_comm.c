@@ -113,7 +113,8 @@ extern int comm_recv(char *buf, int len, struct sockaddr_in *raddr) {
   int rsize = sizeof(*raddr) ;
   int bytes = 0 ;
   
-  bytes = recvfrom(fd_udp_socket, buf, len, 0, (struct sockaddr *)raddr, &rsize) ;
+  bytes = recvfrom(fd_udp_socket, buf, len, MSG_DONTWAIT,
+  (struct sockaddr *)raddr, &rsize) ;
   if(bytes == -1)
     return -errno ;
   return bytes ;
@@ -0,0 +1,221 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+/* fdd_gset.c - sets of groups, as bitsets over interned group indices.
+ * Every gid seen gets the next free index, kept for the life of the
+ * daemon: the intersection of two sets is then a word-wise AND. */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fdd.h"
+#include "fdd_gset.h"
+#include "misc.h"
+
+/* open addressing table gid -> index */
+struct gset_slot {
+  u_int gid ;
+  int idx ; /* -1 if the slot is free */
+} ;
+
+static struct gset_slot *gset_slots = NULL ;
+static unsigned int gset_nb_slots = 0 ;
+static unsigned int gset_nb_groups = 0 ;
+
+static inline unsigned int gset_hash(u_int gid, unsigned int nb_slots) {
+  return (gid * 2654435761u) & (nb_slots - 1) ;
+}
+
+/* doubles the table, the indices are kept */
+static int gset_grow(void) {
+  struct gset_slot *slots ;
+  unsigned int nb_slots, i, h ;
+  
+  nb_slots = gset_nb_slots ? 2 * gset_nb_slots : GSET_MIN_SLOTS ;
+  slots = malloc(nb_slots * sizeof(*slots)) ;
+  if(slots == NULL)
+    return -ENOMEM ;
+  for(i = 0 ; i < nb_slots ; i++)
+    slots[i].idx = -1 ;
+  
+  for(i = 0 ; i < gset_nb_slots ; i++) {
+    if(gset_slots[i].idx < 0)
+      continue ;
+    h = gset_hash(gset_slots[i].gid, nb_slots) ;
+    while(slots[h].idx >= 0)
+      h = (h + 1) & (nb_slots - 1) ;
+    slots[h] = gset_slots[i] ;
+  }
+  
+  free(gset_slots) ;
+  gset_slots = slots ;
+  gset_nb_slots = nb_slots ;
+  return 0 ;
+}
+
+/* gset_lookup - returns the index of gid, -1 if it was never interned */
+extern int gset_lookup(u_int gid) {
+  unsigned int h ;
+  
+  if(gset_nb_slots == 0)
+    return -1 ;
+  for(h = gset_hash(gid, gset_nb_slots) ; gset_slots[h].idx >= 0 ;
+    h = (h + 1) & (gset_nb_slots - 1)) {
+    if(gset_slots[h].gid == gid)
+      return gset_slots[h].idx ;
+  }
+  return -1 ;
+}
+
+/* gset_intern - returns the index of gid, given one if it has none yet,
+ -ENOMEM on failure */
+extern int gset_intern(u_int gid) {
+  unsigned int h ;
+  int idx ;
+  
+  idx = gset_lookup(gid) ;
+  if(idx >= 0)
+    return idx ;
+  
+  /* keep the table at most half full */
+  if(2 * (gset_nb_groups + 1) > gset_nb_slots && gset_grow() < 0)
+    return -ENOMEM ;
+  
+  h = gset_hash(gid, gset_nb_slots) ;
+  while(gset_slots[h].idx >= 0)
+    h = (h + 1) & (gset_nb_slots - 1) ;
+  gset_slots[h].gid = gid ;
+  gset_slots[h].idx = gset_nb_groups++ ;
+  return gset_slots[h].idx ;
+}
+
+extern void gset_cleanup(void) {
+  free(gset_slots) ;
+  gset_slots = NULL ;
+  gset_nb_slots = 0 ;
+  gset_nb_groups = 0 ;
+}
+
+/* makes room in the set for nwords words */
+static int gset_reserve(struct gset *set, unsigned int nwords) {
+  u_int64_t *bits ;
+  
+  if(nwords <= set->nwords)
+    return 0 ;
+  bits = realloc(set->bits, nwords * sizeof(*bits)) ;
+  if(bits == NULL)
+    return -ENOMEM ;
+  memset(bits + set->nwords, 0, (nwords - set->nwords) * sizeof(*bits)) ;
+  set->bits = bits ;
+  set->nwords = nwords ;
+  return 0 ;
+}
+
+/* gset_add - adds gid to the set. Returns 0 on success, -ENOMEM
+ otherwise */
+extern int gset_add(struct gset *set, u_int gid) {
+  int idx ;
+  
+  idx = gset_intern(gid) ;
+  if(idx < 0)
+    return idx ;
+  if(gset_reserve(set, idx / GSET_WORD_BITS + 1) < 0)
+    return -ENOMEM ;
+  set->bits[idx / GSET_WORD_BITS] |= (u_int64_t)1 << (idx % GSET_WORD_BITS) ;
+  return 0 ;
+}
+
+extern void gset_del(struct gset *set, u_int gid) {
+  int idx = gset_lookup(gid) ;
+  
+  if(idx >= 0 && (unsigned int)idx / GSET_WORD_BITS < set->nwords)
+    set->bits[idx / GSET_WORD_BITS] &= ~((u_int64_t)1 << (idx % GSET_WORD_BITS)) ;
+}
+
+/* gset_and - dst = a AND b. Returns 0 on success, -ENOMEM otherwise */
+extern int gset_and(struct gset *dst, struct gset *a, struct gset *b) {
+  unsigned int nwords = min(a->nwords, b->nwords) ;
+  unsigned int i ;
+  
+  if(gset_reserve(dst, nwords) < 0)
+    return -ENOMEM ;
+  for(i = 0 ; i < nwords ; i++)
+    dst->bits[i] = a->bits[i] & b->bits[i] ;
+  for( ; i < dst->nwords ; i++)
+    dst->bits[i] = 0 ;
+  return 0 ;
+}
+
+extern int gset_equal(struct gset *a, struct gset *b) {
+  unsigned int nwords = min(a->nwords, b->nwords) ;
+  unsigned int i ;
+  
+  if(nwords && memcmp(a->bits, b->bits, nwords * sizeof(*a->bits)))
+    return 0 ;
+  for(i = nwords ; i < a->nwords ; i++)
+    if(a->bits[i])
+      return 0 ;
+  for(i = nwords ; i < b->nwords ; i++)
+    if(b->bits[i])
+      return 0 ;
+  return 1 ;
+}
+
+/* gtable_create - returns the list of the group gid, created empty if it
+ has none, NULL on failure */
+extern struct list_head *gtable_create(struct gtable *table, u_int gid) {
+  struct list_head **heads ;
+  unsigned int nb_heads ;
+  int idx ;
+  
+  idx = gset_intern(gid) ;
+  if(idx < 0)
+    return NULL ;
+  
+  if((unsigned int)idx >= table->nb_heads) {
+    nb_heads = max(2 * table->nb_heads, (unsigned int)idx + 1) ;
+    heads = realloc(table->heads, nb_heads * sizeof(*heads)) ;
+    if(heads == NULL)
+      return NULL ;
+    memset(heads + table->nb_heads, 0,
+    (nb_heads - table->nb_heads) * sizeof(*heads)) ;
+    table->heads = heads ;
+    table->nb_heads = nb_heads ;
+  }
+  
+  if(table->heads[idx] == NULL) {
+    table->heads[idx] = malloc(sizeof(struct list_head)) ;
+    if(table->heads[idx] == NULL)
+      return NULL ;
+    INIT_LIST_HEAD(table->heads[idx]) ;
+  }
+  return table->heads[idx] ;
+}
+
+/* gtable_free - frees the lists of the table, not their entries */
+extern void gtable_free(struct gtable *table) {
+  unsigned int i ;
+  
+  for(i = 0 ; i < table->nb_heads ; i++)
+    free(table->heads[i]) ;
+  free(table->heads) ;
+  table->heads = NULL ;
+  table->nb_heads = 0 ;
+}
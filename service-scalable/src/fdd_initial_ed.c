@@ -52,7 +52,7 @@ extern void send_initial_ed_msg(struct host_struct *host,
   }
   /* lock the FINISHED_YES value for the initial of the local host */
   if( host->stats.local_initial_finished == FINISHED_NO &&
-    host->stats.nb_average_delay_msg >= AVERAGE_DELAY_MAX_SAMPLES ) {
+    initial_delays_converged(&host->stats) ) {
     host->stats.local_initial_finished = FINISHED_YES ;
     one_finished_now++ ;
   }
@@ -86,23 +86,35 @@ extern void stop_initial(struct host_struct *host, struct timeval *now) {
   
   double pl;
   double floor;
+  double n;
   
   host->stats.remote_initial_finished = FINISHED_YES ;
-  /* compute the first value of the standard deviation */
-  host->stats.est.e_d = compute_average_delays(&host->stats) ;
   
-  /* compute the loss probability */
-  pl =
-  1.0 - ((double) AVERAGE_DELAY_MAX_SAMPLES) / ((double) host->remote_initial_ed_seq);
-  
-  /* Since we only received AVERAGE_DELAY_MAX_SAMPLES msgs, we cannot
-  estimate loss probabilities less than 1/AVERAGE_DELAY_MAX_SAMPLES.
-   Consequently pl is computed so as to be at least 1/AVERAGE_DELAY_MAX_SAMPLES. */
-  floor = 1.0 / ((double) AVERAGE_DELAY_MAX_SAMPLES);
-  host->stats.est.pl = max(floor, pl);
+  /* a host started with the estimates kept by warm_seed() has no samples
+   of its own: the estimates are kept */
+  if(host->stats.nb_average_delay_msg > 0) {
+    n = host->stats.nb_average_delay_msg ;
+    
+    /* compute the first value of the standard deviation */
+    host->stats.est.e_d = compute_average_delays(&host->stats) ;
+    
+    /* the stage may have stopped before AVERAGE_DELAY_MAX_SAMPLES samples:
+     start with the upper bounds of the confidence intervals, the margin
+     shrinks with the number of samples. The reports replace them. */
+    host->stats.est.e_d += INITIAL_CONFIDENCE_Z * sqrt(host->stats.est.v_d / n) ;
+    host->stats.est.v_d *= 1.0 + INITIAL_CONFIDENCE_Z * sqrt(2.0 / max(n - 1.0, 1.0)) ;
+    
+    /* compute the loss probability */
+    pl = 1.0 - n / ((double) host->remote_initial_ed_seq);
+    
+    /* Since we only received n msgs, we cannot estimate loss
+     probabilities less than 1/n. Consequently pl is computed so as to
+     be at least 1/n. */
+    floor = 1.0 / n;
+    host->stats.est.pl = max(floor, pl);
+  }
   
-  list_free(&host->stats.average_delay_msg_head, struct average_delay_struct, delay_list) ;
-  host->stats.nb_average_delay_msg = 0 ;
+  clear_average_delays(&host->stats) ;
   
   recalc_needed_sendint(host, now) ;
   
@@ -126,7 +138,7 @@ extern void initial_ed_merge(char *msg, int msg_len, struct sockaddr_in *raddr,
   if( NULL == host )
     goto out ;
   
-  if (host->stats.nb_average_delay_msg < AVERAGE_DELAY_MAX_SAMPLES)
+  if (host->stats.local_initial_finished == FINISHED_NO)
     host->remote_initial_ed_seq = initial_ed_seq;
   
   /* immediatly send back an other initial type message */
@@ -38,6 +38,11 @@
 /* exported stuff */
 struct list_head local_procs_list_head ; /* list of local processes */
 struct list_head local_groups_list_head ; /* list of local groups */
+struct gset local_groups_set = GSET_INIT ; /* the same groups, as a set */
+/* the groupqos_struct of the local processes, by group and ordered by pid */
+static struct gtable local_group_members_table = GTABLE_INIT ;
+/* the groups monitored by at least one local process */
+struct gset local_monitored_groups_set = GSET_INIT ;
 
 /* Added for Omega */
 /* List containing for all the group g of all the local processes p if p
@@ -56,6 +61,15 @@ struct timeval local_epoch ;
 
 unsigned int local_groups_list_seq ;
 unsigned int local_groups_multicast_list_seq ;
+/* seq. nb. of the groups list of the alive multicast: all the local groups,
+ unlike the jointly groups list of the unicast reports */
+unsigned int local_groups_alive_list_seq ;
+
+/* the local groups of the alive multicast, rebuilt when
+ local_groups_multicast_list_seq moves */
+static struct list_head alive_groups_list ;
+static unsigned int alive_groups_seq ;
+static int alive_groups_built ;
 
 static struct timeval last_report_ts, next_report_ts ;
 
@@ -237,6 +251,66 @@ static void unreg_lproc_from_related_hosts(unsigned int pid,
   }
 }
 
+extern void local_cleanup(void) {
+  list_free(&alive_groups_list, struct uint_struct, uint_list) ;
+  alive_groups_built = 0 ;
+  gtable_free(&local_group_members_table) ;
+  gset_free(&local_monitored_groups_set) ;
+}
+
+/* local_group_members - returns the list of the groupqos_struct of the
+ local processes in the group gid, through members_list and ordered by
+ pid */
+extern struct list_head *local_group_members(unsigned int gid) {
+  static LIST_HEAD(no_members) ;
+  struct list_head *members ;
+  
+  members = gtable_lookup(&local_group_members_table, gid) ;
+  return members ? members : &no_members ;
+}
+
+/* adds the group of a local process to local_group_members() */
+static int local_group_add_member(struct groupqos_struct *gqos,
+  struct localproc_struct *lproc) {
+  struct list_head *head, *tmp ;
+  struct groupqos_struct *member ;
+  
+  head = gtable_create(&local_group_members_table, gqos->gid) ;
+  if(head == NULL)
+    return -ENOMEM ;
+  
+  gqos->lproc = lproc ;
+  list_for_each(tmp, head) {
+    member = list_entry(tmp, struct groupqos_struct, members_list) ;
+    if(member->lproc->pid > lproc->pid)
+      break ;
+  }
+  list_add_tail(&gqos->members_list, tmp) ;
+  return 0 ;
+}
+
+/* keeps local_monitored_groups_set up to date after the qos of a local
+ process in the group gid changed */
+static void local_update_monitored(unsigned int gid) {
+  struct list_head *tmp ;
+  struct groupqos_struct *member ;
+  
+  list_for_each(tmp, local_group_members(gid)) {
+    member = list_entry(tmp, struct groupqos_struct, members_list) ;
+    if(member->qos != NULL) {
+      gset_add(&local_monitored_groups_set, gid) ;
+      return ;
+    }
+  }
+  gset_del(&local_monitored_groups_set, gid) ;
+}
+
+static void local_group_del_member(struct groupqos_struct *gqos) {
+  list_del(&gqos->members_list) ;
+  if(gqos->qos != NULL)
+    local_update_monitored(gqos->gid) ;
+}
+
 /* check if the given group is in the list of ordered group IDs */
 static int is_in_ordered_gqlist(unsigned gid, struct list_head *gqolist) {
   
@@ -353,16 +427,7 @@ static int remove_group_ts(unsigned int gid) {
 
 /* check if there is any local process who joined the group gid */
 static int exists_group(unsigned int gid) {
-  struct list_head *tmp_lproc ;
-  struct localproc_struct *lproc = NULL;
-  
-  list_for_each(tmp_lproc, &local_procs_list_head) {
-    lproc = list_entry(tmp_lproc, struct localproc_struct, local_procs_list) ;
-    
-    if(is_in_ordered_gqlist(gid, &lproc->gqlist_head))
-      return 1 ;
-  }
-  return 0 ;
+  return !list_empty(local_group_members(gid)) ;
 }
 
 /* a processes leaves a group */
@@ -382,6 +447,7 @@ static int proc_quit_group(struct localproc_struct *lproc,
     int found ;
     list_remove_ordered(gid, val, &local_groups_list_head, struct uint_struct,
     uint_list, <) ;
+    gset_del(&local_groups_set, gid) ;
     
     if (remove_group_ts(gid) < 0)
       fprintf(stderr, "fdd: Error in proc_quit_group, group timestamp not found\n");
@@ -395,6 +461,7 @@ static int proc_quit_group(struct localproc_struct *lproc,
   
   local_groups_list_seq++ ;
   local_groups_multicast_list_seq++ ;
+  local_groups_alive_list_seq++ ;
   
   {
     struct list_head *tmp ;
@@ -403,7 +470,7 @@ static int proc_quit_group(struct localproc_struct *lproc,
     list_for_each(tmp, &remote_host_list_head) {
       host = list_entry(tmp, struct host_struct, remote_host_list) ;
       
-      if(is_in_ordered_list(gid, &host->jointly_groups_head)) {
+      if(gset_test(&host->jointly_groups_set, gid)) {
         build_jointly_groups_list(host, &host->remote_all_groups_head) ;
         recalc_needed_sendint(host, now) ;
         local_sched_report_sooner(host->local_needed_sendint, now, host) ;
@@ -433,6 +500,7 @@ static void proc_quit_all_groups(struct localproc_struct *lproc, struct timeval
     tmp_gqos = tmp_gqos->prev ;
     
     list_del(&gqos->gqlist) ;
+    local_group_del_member(gqos) ;
     proc_quit_group(lproc, gqos->gid, now) ;
     free_gqos(gqos) ;
   }
@@ -1009,37 +1077,84 @@ fprintf(flog, "fdd: send_result_failed\n");
 }
  }*/
 
-/* build  the list of jointly groups between the remote host and the local */
+/* build  the list of jointly groups between the remote host and the local.
+ The jointly groups are the AND of the set of the remote groups with
+ local_groups_set; the list is only touched for the groups that come and
+ go. all_remote_groups is ordered. */
 extern int build_jointly_groups_list(struct host_struct  *host,
   struct list_head *all_remote_groups) {
   
-  struct list_head *tmp ;
-  struct uint_struct *group ;
-  struct list_head jointly_groups ;
+  struct list_head *tmp, *tmp_new ;
+  struct uint_struct *group, *group_new ;
+  struct list_head new_groups ;
+  struct gset remote_groups = GSET_INIT ;
+  struct gset jointly_groups = GSET_INIT ;
   
   int retval ;
-  int entry_exists ;
-  struct uint_struct *entry_ptr ;
   
-  INIT_LIST_HEAD(&jointly_groups) ;
+  INIT_LIST_HEAD(&new_groups) ;
   
   retval = -ENOMEM ;
   list_for_each(tmp, all_remote_groups) {
     group = list_entry(tmp, struct uint_struct, uint_list) ;
-    if(is_in_ordered_list(group->val, &local_groups_list_head)) {
-      entry_ptr = NULL ;
-      list_insert_ordered(group->val, val, &jointly_groups,
-      struct uint_struct, uint_list, <) ;
-      if(entry_ptr == NULL)
-        goto out ;
+    if(gset_add(&remote_groups, group->val) < 0)
+      goto out ;
+  }
+  if(gset_and(&jointly_groups, &remote_groups, &local_groups_set) < 0)
+    goto out ;
+  
+  retval = 0 ;
+  if(gset_equal(&jointly_groups, &host->jointly_groups_set))
+    goto out ;
+  
+  /* allocate the groups that join first, in order, so that a failure
+   leaves the list as it was */
+  retval = -ENOMEM ;
+  list_for_each(tmp, all_remote_groups) {
+    group = list_entry(tmp, struct uint_struct, uint_list) ;
+    if(!gset_test(&jointly_groups, group->val) ||
+      gset_test(&host->jointly_groups_set, group->val))
+      continue ;
+    group_new = malloc(sizeof(*group_new)) ;
+    if(group_new == NULL)
+      goto out ;
+    group_new->val = group->val ;
+    list_add_tail(&group_new->uint_list, &new_groups) ;
+  }
+  
+  /* drop the groups that left and merge the new ones in */
+  tmp_new = new_groups.next ;
+  list_for_each(tmp, &host->jointly_groups_head) {
+    group = list_entry(tmp, struct uint_struct, uint_list) ;
+    while(tmp_new != &new_groups) {
+      group_new = list_entry(tmp_new, struct uint_struct, uint_list) ;
+      if(group_new->val > group->val)
+        break ;
+      tmp_new = tmp_new->next ;
+      list_del(&group_new->uint_list) ;
+      list_add_tail(&group_new->uint_list, tmp) ;
     }
+    if(!gset_test(&jointly_groups, group->val)) {
+      tmp = tmp->prev ;
+      list_del(&group->uint_list) ;
+      free(group) ;
+    }
+  }
+  while(!list_empty(&new_groups)) {
+    tmp_new = new_groups.next ;
+    list_del(tmp_new) ;
+    list_add_tail(tmp_new, &host->jointly_groups_head) ;
   }
+  
+  gset_free(&host->jointly_groups_set) ;
+  host->jointly_groups_set = jointly_groups ;
+  gset_init(&jointly_groups) ;
   retval = 0 ;
-  out:
-  if( !(retval < 0) )
-    list_swap(&jointly_groups, &host->jointly_groups_head) ;
   
-  list_free(&jointly_groups, struct uint_struct, uint_list) ;
+  out:
+  list_free(&new_groups, struct uint_struct, uint_list) ;
+  gset_free(&remote_groups) ;
+  gset_free(&jointly_groups) ;
   
   return retval ;
 }
@@ -1064,7 +1179,14 @@ static int proc_join_group(struct localproc_struct *lproc, unsigned int gid,
     if( entry_ptr == NULL )
       goto out ;
     
+    if( !entry_exists && local_group_add_member(entry_ptr, lproc) < 0 ) {
+      list_del(&entry_ptr->gqlist) ;
+      free(entry_ptr) ;
+      goto out ;
+    }
+    
     entry_ptr->qos = NULL ;
+    entry_ptr->detector = DETECTOR_CHEN ;
     
     entry_ptr_gqos = entry_ptr ;
   }
@@ -1083,10 +1205,17 @@ static int proc_join_group(struct localproc_struct *lproc, unsigned int gid,
     
     group_already_existed_localy = entry_exists;
     entry_ptr_uint = entry_ptr ;
+    
+    if(gset_add(&local_groups_set, gid) < 0) {
+      if(!group_already_existed_localy)
+        goto free_uint ;
+      goto free_gqos ;
+    }
   }
   
   local_groups_list_seq++ ;
   local_groups_multicast_list_seq++ ;
+  local_groups_alive_list_seq++ ;
   
   {
     struct list_head *tmp ;
@@ -1118,6 +1247,7 @@ static int proc_join_group(struct localproc_struct *lproc, unsigned int gid,
   free(entry_ptr_uint) ;
   free_gqos:
   list_del(&entry_ptr_gqos->gqlist) ;
+  local_group_del_member(entry_ptr_gqos) ;
   free(entry_ptr_gqos) ;
   
   out:
@@ -1132,7 +1262,7 @@ static void recalc_needed_sendint_jointly_hosts(unsigned int gid, struct timeval
   
   list_for_each(tmp, &remote_host_list_head) {
     host = list_entry(tmp, struct host_struct, remote_host_list) ;
-    if(is_in_ordered_list(gid, &host->jointly_groups_head)) {
+    if(gset_test(&host->jointly_groups_set, gid)) {
       recalc_needed_sendint(host, now) ;
       local_sched_report_sooner(host->local_needed_sendint, now, host) ;
     }
@@ -1158,6 +1288,7 @@ extern int do_stop_monitor_group(unsigned int pid, unsigned int gid, struct time
   
   free(gqos->qos) ;
   gqos->qos = NULL ;
+  local_update_monitored(gid) ;
   
   recalc_needed_sendint_jointly_hosts(gid, now) ;
   
@@ -1175,6 +1306,42 @@ extern int do_stop_monitor_group(unsigned int pid, unsigned int gid, struct time
 }
 
 
+/* set how the processes of a monitored group are suspected, DETECTOR_CHEN
+ or DETECTOR_PHI. The next reports of the hosts use it. */
+extern int do_set_group_detector(unsigned int pid, unsigned int gid, unsigned int detector) {
+  
+  struct groupqos_struct *gqos ;
+  int retval ;
+  struct localproc_struct *lproc = NULL;
+  int found;
+  
+  lproc = find_lproc(pid, &found);
+  if (!found)
+    return -1;
+  
+  retval = -EINVAL ;
+  gqos = locate_gqos(lproc, gid) ;
+  if(NULL == gqos || NULL == gqos->qos)
+    goto out ;
+  if(detector != DETECTOR_CHEN && detector != DETECTOR_PHI)
+    goto out ;
+  
+  gqos->detector = detector ;
+  
+  retval = 0 ;
+  out:
+  if(retval < 0) {
+#ifdef OUTPUT
+    fprintf(stdout, "Error in set group detector\n") ;
+#endif
+#ifdef LOG
+    fprintf(flog, "Error in set group detector\n") ;
+#endif
+  }
+  return retval;
+}
+
+
 /* Added for Omega */
 /*stop sending alive messages */
 extern int do_stop_sending_alives(unsigned int pid, unsigned int gid, struct timeval *now) {
@@ -1193,6 +1360,7 @@ extern int do_stop_sending_alives(unsigned int pid, unsigned int gid, struct tim
   visibility_list_group_free(pid, gid);
   
   local_groups_list_seq++;
+  local_groups_alive_list_seq++;
   
   
   /* Added for Omega */
@@ -1251,7 +1419,16 @@ extern int do_restart_sending_alives(unsigned int pid, unsigned int gid, struct
   if (entry_ptr == NULL)
     goto out;
   
+  if (vis_add(pid, gid) < 0) {
+    if (!entry_exists) {
+      list_del(&entry_ptr->gcell);
+      free(entry_ptr);
+    }
+    goto out;
+  }
+  
   local_groups_list_seq++ ;
+  local_groups_alive_list_seq++ ;
   
   /* Added for Omega */
   /* Update the group ts. */
@@ -1313,6 +1490,11 @@ static int set_gqos(struct localproc_struct *lproc, unsigned int gid,
     gqos->qos = malloc(sizeof(*(gqos->qos))) ;
     if(NULL == gqos->qos)
       goto out ;
+    if(gset_add(&local_monitored_groups_set, gid) < 0) {
+      free(gqos->qos) ;
+      gqos->qos = NULL ;
+      goto out ;
+    }
     local_trust_group(lproc, gid, now) ;
   }
   
@@ -1355,7 +1537,7 @@ extern int do_monitor_group(unsigned int pid, unsigned int gid, unsigned int int
    equal to gid. */
   list_for_each(tmp_host, &remote_host_list_head) {
     host = list_entry(tmp_host, struct host_struct, remote_host_list);
-    if (is_in_ordered_list(gid, &host->jointly_groups_head)) {
+    if (gset_test(&host->jointly_groups_set, gid)) {
       if ((host->stats.local_initial_finished == FINISHED_YES) &&
         (host->stats.remote_initial_finished == FINISHED_YES)) {
 #ifdef OUTPUT
@@ -1443,6 +1625,14 @@ extern int do_join_group(unsigned int pid, unsigned int gid, struct timeval *now
     
     if (entry_ptr == NULL)
       goto out;
+    
+    if (vis_add(lproc->pid, gid) < 0) {
+      if (!entry_exists) {
+        list_del(&entry_ptr->gcell);
+        free(entry_ptr);
+      }
+      goto out;
+    }
   }
   
   retval = notify_local_group(lproc->pid, gid, TRUST_NOTIF, now) ;
@@ -1533,6 +1723,7 @@ extern int do_leave_group(unsigned int pid, unsigned int gid, struct timeval *no
     goto out ;
   
   list_del(&gqos->gqlist) ;
+  local_group_del_member(gqos) ;
   proc_quit_group(lproc, gqos->gid, now) ;
   free_gqos(gqos) ;
   
@@ -1682,6 +1873,10 @@ extern void local_init(void) {
   
   local_groups_list_seq = 0 ;
   local_groups_multicast_list_seq = 0 ;
+  local_groups_alive_list_seq = 0 ;
+  
+  INIT_LIST_HEAD(&alive_groups_list) ;
+  alive_groups_built = 0 ;
   
   create_fdd_proc_group(&local_epoch) ;
   
@@ -1749,7 +1944,7 @@ extern void local_untrust_host(struct localproc_struct *lproc,
     tmp = tmp->prev ;
     list_del(&tproc->trust_list) ;
     if(remove_list != NULL)
-      list_add(&tproc->trust_list, remove_list) ;
+      list_add_tail(&tproc->trust_list, remove_list) ;
     else
       free_trust(tproc) ;
   }
@@ -1797,6 +1992,11 @@ extern int fdd_local_reg(unsigned int pid, struct timeval *reg_ts) {
       goto error;
     
     INIT_LIST_HEAD(&(entry_ptr->gid_list_head));
+    if (vis_add_proc(pid) < 0) {
+      list_del(&entry_ptr->pid_list_head);
+      free(entry_ptr);
+      goto error;
+    }
   }
   
   
@@ -1844,37 +2044,280 @@ extern int fdd_local_reg(unsigned int pid, struct timeval *reg_ts) {
 }
 
 
-/* Added for Omega */
-/* Checks if the group gid is in the visibility for process pid */
-static int is_in_ordered_visibility_list(u_int pid, u_int gid) {
-  
-  struct list_head *tmp_visibility;
-  struct pid_gid_visibility_struct *pid_gid;
-  struct list_head *tmp_gid;
-  struct glist_struct *gid_struct;
+/* adds to the report message ending at msg_end, at ptr, the group gid with
+ the local processes visible in it. The group is flagged as received by the remote
+ if its ts is not greater than largest_group_ts_rcvd, or always if
+ largest_group_ts_rcvd is NULL. Returns the end of the group in the
+ message, NULL if it does not fit. */
+static char *local_build_rep_group(char *msg_end, char *ptr, unsigned int gid,
+  struct timeval *largest_group_ts_rcvd, int *groups_count) {
+  struct list_head *tmp_lprocs = NULL ;
+  struct localproc_struct *lproc = NULL ;
+  char *ptr_ghead = ptr ;
+  unsigned int procs_count = 0 ;
+  int exists_inv_proc_in_group = 0 ;
+  struct list_head *members = local_group_members(gid) ;
   
-  list_for_each(tmp_visibility, &visibility_list_head) {
-    pid_gid = list_entry(tmp_visibility, struct pid_gid_visibility_struct, pid_list_head);
-    if (pid_gid->pid < pid)
-      continue;
-    if (pid_gid->pid == pid) {
-      list_for_each(tmp_gid, &pid_gid->gid_list_head) {
-        gid_struct = list_entry(tmp_gid, struct glist_struct, gcell);
-        if (gid_struct->gid < gid)
-          continue;
-        if (gid_struct->gid == gid) {
-          return 1;
-        }
-        break;
+  list_for_each(tmp_lprocs, members) {
+    lproc = list_entry(tmp_lprocs, struct groupqos_struct, members_list)->lproc ;
+    
+    /* Added for Omega */
+    /* Checks if we are invisible in group gid */
+    if (gid != 0) {
+      int found = vis_test(lproc->pid, gid) ;
+      if (found == VIS_INVISIBLE) {
+        exists_inv_proc_in_group = 1;
+        continue ;
+      }
+      else if (found == VIS_ABSENT)
+        continue ;
+    }
+    
+    if(!procs_count) { /* first proc added --> skip the group head */
+      ptr = msg_skip_rep_ghead(ptr) ;
+      if(ptr > msg_end) {
+        fprintf(stderr, "local_send_report: fatal buffer overflow error\n");
+        return NULL ;
       }
-      return 0;
     }
-    break;
+    procs_count++ ;
+    
+    ptr = msg_build_rep_pid(ptr, lproc->pid) ;
+    if(ptr > msg_end) {
+      fprintf(stderr, "local_send_report: fatal buffer overflow error\n");
+      return NULL ;
+    }
   }
-  return -1;
+  if(procs_count) {
+    struct timeval group_ts;
+    unsigned int eta_rcvd;
+    
+    if (get_group_ts(gid, &group_ts) < 0) {
+      fprintf(stderr, "fdd: Error in local_send_report, impossible to get group ts of: %u\n",
+      gid);
+      return NULL ;
+    }
+    
+    eta_rcvd = (NULL == largest_group_ts_rcvd) ||
+    timercmp(largest_group_ts_rcvd, &group_ts, ==) ||
+    timercmp(largest_group_ts_rcvd, &group_ts, >);
+    
+    msg_build_rep_ghead(ptr_ghead, gid, &group_ts, eta_rcvd, procs_count) ;
+    (*groups_count)++ ;
+  }
+  /* Modified for Omega */
+  /* We include a group g even if there is no visible process in g. */
+  else if(exists_inv_proc_in_group) {
+    struct timeval group_ts;
+    unsigned int eta_rcvd = 0;
+    
+    /* If there is no group ts for gid, we assign zero to group_ts. */
+    if (get_group_ts(gid, &group_ts) < 0)
+      timerclear(&group_ts);
+    
+    /* We build the group head without any process in it. */
+    ptr = msg_build_rep_ghead(ptr_ghead, gid, &group_ts, eta_rcvd, procs_count) ;
+    (*groups_count)++ ;
+  }
+  return ptr ;
+}
+
+/* Added for Omega */
+/* adds to the report message, at ptr, the variables accusationTime and
+ startTime of the group gid if a local process is visible in it */
+static char *local_build_rep_localvars(char *ptr, unsigned int gid,
+  unsigned int *localvars_count) {
+  struct list_head *tmp_lprocs = NULL ;
+  struct localproc_struct *lproc = NULL ;
+  struct timeval accusationTime, startTime;
+  struct list_head *members = local_group_members(gid) ;
+  
+  if(gid == 0)
+    return ptr ;
+  list_for_each(tmp_lprocs, members) {
+    lproc = list_entry(tmp_lprocs, struct groupqos_struct, members_list)->lproc ;
+    /* as before, a process without visibility entry counts as visible */
+    if(vis_test(lproc->pid, gid) != VIS_INVISIBLE) {
+      if (getlocalvars(gid, &accusationTime, &startTime) == 0) {
+        ptr = msg_build_rep_localvars(ptr, gid, &accusationTime, &startTime);
+        (*localvars_count)++;
+        break;   /* There is only one set of localvars per group */
+      }
+    }
+  }
+  return ptr ;
 }
 
 
+/* drops the accusations queued for the host, once they are sent */
+static void local_drop_accusations(struct host_struct *host) {
+  list_free(&host->accusations_head, struct accusation_struct,
+  accusation_list) ;
+  host->accusations_count = 0 ;
+  remove_accusations_event(host) ;
+}
+
+/* local_queue_accusation - queues an omega accusation of the process of
+ group gid started at startTime on the host addr. The accusations for a
+ host go with the next report to it if it understands
+ WIRE_VERSION_ACCUSATIONS, or in one datagram ACCUSATION_FLUSH_DELAY after
+ the first one was queued. The ones already queued are not repeated. */
+extern int local_queue_accusation(struct sockaddr_in *addr, u_int gid,
+  struct timeval *startTime,
+  struct timeval *now) {
+  struct host_struct *host = NULL ;
+  struct list_head *tmp = NULL ;
+  struct accusation_struct *accusation = NULL ;
+  int retval = 0 ;
+  
+  host = locate_host(addr) ;
+  if(host == NULL) {
+    send_accusation(addr, gid, startTime) ;
+    goto out ;
+  }
+  
+  list_for_each(tmp, &host->accusations_head) {
+    accusation = list_entry(tmp, struct accusation_struct, accusation_list) ;
+    if(accusation->gid == gid && timercmp(&accusation->startTime, startTime, ==))
+      goto out ;
+  }
+  
+  accusation = malloc(sizeof(*accusation)) ;
+  retval = -ENOMEM ;
+  if(accusation == NULL)
+    goto out ;
+  accusation->gid = gid ;
+  memcpy(&accusation->startTime, startTime, sizeof(accusation->startTime)) ;
+  list_add_tail(&accusation->accusation_list, &host->accusations_head) ;
+  host->accusations_count++ ;
+  
+  retval = 0 ;
+  if(host->accusations_count >= OMEGA_MAX_ACCUSATIONS)
+    local_flush_accusations(host) ;
+  else if(host->accusations_count == 1)
+    retval = sched_accusations(host, now) ;
+  
+  out:
+  return retval ;
+}
+
+/* local_flush_accusations - sends the accusations queued for the host in
+ one datagram */
+extern void local_flush_accusations(struct host_struct *host) {
+  char msg[OMEGA_UDP_MSG_LEN] ;
+  char *ptr = msg ;
+  struct list_head *tmp = NULL ;
+  struct accusation_struct *accusation = NULL ;
+  
+  list_for_each(tmp, &host->accusations_head) {
+    accusation = list_entry(tmp, struct accusation_struct, accusation_list) ;
+    if(ptr == msg)
+      ptr = msg_omega_build_accusation(ptr, accusation->gid,
+      &accusation->startTime) ;
+    else
+      ptr = msg_omega_build_accusation_entry(ptr, accusation->gid,
+      &accusation->startTime) ;
+  }
+  
+  if(ptr != msg)
+    send_accusation_msg(&host->addr, msg, ptr - msg) ;
+  local_drop_accusations(host) ;
+}
+
+/* adds to the report message, at ptr, the accusations queued for the
+ host if it understands them and they fit before end */
+static char *local_build_rep_accusations(struct host_struct *host,
+  char *ptr, char *end) {
+  struct list_head *tmp = NULL ;
+  struct accusation_struct *accusation = NULL ;
+  
+  if(host->accusations_count == 0 ||
+    host->wire_version < WIRE_VERSION_ACCUSATIONS ||
+    ptr + 4 + host->accusations_count * REP_ACCUSATION_LEN > end)
+    return ptr ;
+  
+  ptr = msg_build_rep_accusations_count(ptr, host->accusations_count) ;
+  list_for_each(tmp, &host->accusations_head) {
+    accusation = list_entry(tmp, struct accusation_struct, accusation_list) ;
+    ptr = msg_build_rep_accusation(ptr, accusation->gid,
+    &accusation->startTime) ;
+  }
+  return ptr ;
+}
+
+/* sends the report msg of msg_len bytes to the host, in fragments if it
+ does not fit in a datagram. Returns the result of the last comm_send(). */
+static int local_send_report_msg(struct host_struct *host, char *msg,
+  int msg_len, struct timeval *sending_ts) {
+  char frag[SAFE_MSG_LEN] ;
+  char *ptr ;
+  unsigned int frag_count, i ;
+  int len ;
+  int retval ;
+  
+  if(msg_len <= MAX_MSG_LEN)
+    return comm_send(msg, msg_len, &host->addr) ;
+  
+  frag_count = (msg_len + REP_FRAG_PAYLOAD - 1) / REP_FRAG_PAYLOAD ;
+  retval = -EMSGSIZE ;
+  for(i = 0 ; i < frag_count ; i++) {
+    len = min(REP_FRAG_PAYLOAD, msg_len - i * REP_FRAG_PAYLOAD) ;
+    ptr = msg_build_rep_frag_head(frag, host->local_seq, i, frag_count,
+      msg_len, sending_ts, &local_epoch, &host->remote_epoch,
+    host->local_needed_sendint) ;
+    memcpy(ptr, msg + i * REP_FRAG_PAYLOAD, len) ;
+    
+    retval = comm_send(frag, REP_FRAG_HEAD_LEN + len, &host->addr) ;
+    if(retval < 0)
+      break ;
+  }
+  return retval ;
+}
+
+/* decides which lists of a report to the given host are left out: the
+ ones the host acked a report for since they last changed. A list changed
+ when its list seq moved, its digest is only an extra check for what the
+ seq does not follow (dead processes, group timestamps). The lists are
+ given by their place and length in the message being built, that will
+ have seq host->local_seq + 1. A report with all the lists is sent at
+ least every DELTA_SNAPSHOT_INT, it refreshes what the host derives from
+ them. Returns the bitmap of the lists left out. */
+static u_int local_omit_lists(struct host_struct *host, char **list,
+  int *len, struct timeval *sending_ts) {
+  struct timeval since ;
+  u_int omitted = 0 ;
+  u_int seq[REP_LISTS] ;
+  u_int digest ;
+  int i ;
+  
+  if(host->wire_version < WIRE_VERSION_DELTA)
+    return 0 ;
+  
+  seq[REP_LIST_SERVERS] = host->local_servers_list_seq ;
+  seq[REP_LIST_GROUPS] = local_groups_list_seq ;
+  seq[REP_LIST_CLIENTS] = host->local_clients_list_seq ;
+  
+  for(i = 0 ; i < REP_LISTS ; i++) {
+    digest = msg_digest(list[i], len[i]) ;
+    if(seq[i] != host->lists_seq[i] || digest != host->lists_digest[i] ||
+      host->lists_changed_seq[i] == 0) {
+      host->lists_seq[i] = seq[i] ;
+      host->lists_digest[i] = digest ;
+      host->lists_changed_seq[i] = host->local_seq + 1 ;
+    }
+    if(!greater_than(host->lists_changed_seq[i], host->lists_acked_seq[i]))
+      omitted |= 1 << i ;
+  }
+  
+  timersub(sending_ts, &host->last_snapshot_ts, &since) ;
+  if(since.tv_sec < 0 || timer2unit(&since) >= DELTA_SNAPSHOT_INT)
+    omitted = 0 ;
+  
+  if(!omitted)
+    memcpy(&host->last_snapshot_ts, sending_ts, sizeof(*sending_ts)) ;
+  return omitted ;
+}
+
 /* sends a report message to the given host timestamped with the given sending_ts
  * the report message has two main components:
  *  - the list of local servers. All the process servers requested from this host are in
@@ -1888,11 +2331,15 @@ static int is_in_ordered_visibility_list(u_int pid, u_int gid) {
 /* Also send in the message the host->remote_needed_sendints_list */
 extern void local_send_report_host(struct host_struct *host,
   struct timeval *sending_ts) {
-  char msg[SAFE_MSG_LEN] ;
+  /* reports can be longer than a datagram, see local_send_report_msg() */
+  static char msg[REP_MAX_LEN + 24] ;
+  static char compact_msg[REP_MAX_LEN + 24] ;
+  int msg_len ;
   char *ptr       = NULL ;
   char *ptr_head  = NULL ;
   char *ptr_ghead = NULL ;
   char *ptr_list  = NULL ;
+  char *ptr_accusations = NULL ;
   
   int local_servers_proc_count   = 0 ;
   int local_servers_list_len     = 0 ;
@@ -1908,41 +2355,28 @@ extern void local_send_report_host(struct host_struct *host,
   struct list_head *tmp          = NULL ;
   
   struct list_head *tmp_jointly_groups = NULL ;
-  struct list_head *tmp_lprocs = NULL ;
   
   struct uint_struct *jointly_group = NULL ;
-  struct localproc_struct *lproc = NULL ;
   
-  unsigned int procs_count ;
-  struct timeval accusationTime, startTime;
-  int exists_inv_proc_in_group;
+  char *list[REP_LISTS] ;
+  int len[REP_LISTS] ;
+  char *ptr_vars = NULL ;
+  u_int omitted = 0 ;
+  int i ;
   
   int retval ;
+  u_int64_t build_start_ns = metrics_now_ns() ;
   
   retval =  0 ;
   
   INIT_LIST_HEAD(&remote_servers_proc_head) ;
   
-#ifdef OUTPUT
-  fprintf(stdout, "SENDING REPORT seq=%u, local_needed_sendint=%u, "
-    "to %u.%u.%u.%u, TS=%ld.%ld\n",
-    host->local_seq+1, host->local_needed_sendint,
-    NIPQUAD(&host->addr),
-  sending_ts->tv_sec, sending_ts->tv_usec) ;
-#endif
-#ifdef LOG_EXTRA
-  fprintf(flog, "SENDING REPORT seq=%u, local_sendint=%u, "
-    "to %u.%u.%u.%u. TS=%ld.%ld\n",
-    host->local_seq+1, host->local_needed_sendint,
-    NIPQUAD(&host->addr),
-  sending_ts->tv_sec, sending_ts->tv_usec) ;
-#endif
   ptr = msg ;
   ptr_head = ptr ;
   
   /* skip the head of the message */
   retval = -EMSGSIZE ;
-  if((ptr = msg_skip_rep_head(ptr)) > msg + MAX_MSG_LEN) {
+  if((ptr = msg_skip_rep_head(ptr)) > msg + REP_MAX_LEN) {
 #ifdef OUTPUT
     fprintf(stderr, "Buffer overflow\n") ;
 #endif
@@ -1962,7 +2396,7 @@ extern void local_send_report_host(struct host_struct *host,
       continue ;
     }
     ptr = msg_build_rep_pid(ptr, proc_pid->val) ;
-    if(ptr > msg + MAX_MSG_LEN) {
+    if(ptr > msg + REP_MAX_LEN) {
 #ifdef OUTPUT
       fprintf(stderr, "Buffer overflow\n") ;
 #endif
@@ -1981,80 +2415,10 @@ extern void local_send_report_host(struct host_struct *host,
   retval = -EMSGSIZE ;
   list_for_each(tmp_jointly_groups, &host->jointly_groups_head) {
     jointly_group = list_entry(tmp_jointly_groups, struct uint_struct, uint_list) ;
-    procs_count = 0 ;
-    exists_inv_proc_in_group = 0;
-    ptr_ghead = ptr ;
-    
-    list_for_each(tmp_lprocs, &local_procs_list_head) {
-      lproc = list_entry(tmp_lprocs, struct localproc_struct, local_procs_list);
-      
-      if(is_in_ordered_gqlist(jointly_group->val, &lproc->gqlist_head)) {
-        /* Added for Omega */
-        /* Checks if we are invisible in group gid */
-        if (jointly_group->val != 0) {
-          int found = is_in_ordered_visibility_list(lproc->pid, jointly_group->val);
-          if (found == 0) {
-            exists_inv_proc_in_group = 1;
-            continue ;
-          }
-          else if (found == -1)
-            continue;
-        }
-        
-        if(!procs_count) { /* first proc added --> skip the group head */
-          ptr = msg_skip_rep_ghead(ptr) ;
-          if(ptr > msg + MAX_MSG_LEN) {
-            fprintf(stderr, "local_send_report: fatal buffer overflow error\n");
-            goto out ;
-          }
-        }
-        procs_count++ ;
-        
-        ptr = msg_build_rep_pid(ptr, lproc->pid) ;
-        if(ptr > msg + MAX_MSG_LEN) {
-          fprintf(stderr, "local_send_report: fatal buffer overflow error\n");
-          goto out ;
-        }
-      }
-    }
-    if(procs_count) {
-      char *tmp_ptr;
-      struct timeval group_ts;
-      unsigned int eta_rcvd;
-      
-      if (get_group_ts(jointly_group->val, &group_ts) < 0) {
-        fprintf(stderr, "fdd: Error in local_send_report, impossible to get group ts of: %u\n",
-        jointly_group->val);
-        goto out;
-      }
-      
-      eta_rcvd = timercmp(&host->local_largest_group_ts_rcvd, &group_ts, ==) ||
-      timercmp(&host->local_largest_group_ts_rcvd, &group_ts, >);
-      
-      tmp_ptr = msg_build_rep_ghead(ptr_ghead, jointly_group->val,
-      &group_ts, eta_rcvd, procs_count) ;
-      local_servers_groups_count++ ;
-    }
-    /* Modified for Omega */
-    /* We include a group g even if there is no visible process in g. */
-    else if(exists_inv_proc_in_group) {
-      char *tmp_ptr;
-      struct timeval group_ts;
-      unsigned int eta_rcvd = 0;
-      
-      /* If there is no group ts for jointly_group->val, we assign
-       zero to group_ts. */
-      if (get_group_ts(jointly_group->val, &group_ts) < 0)
-        timerclear(&group_ts);
-      
-      tmp_ptr = msg_build_rep_ghead(ptr_ghead, jointly_group->val,
-      &group_ts, eta_rcvd, procs_count) ;
-      local_servers_groups_count++ ;
-      
-      /* We built the group head without any process in it.
-       We must therefore update the ptr var. */
-      ptr = tmp_ptr;
-    }
+    ptr = local_build_rep_group(msg + REP_MAX_LEN, ptr, jointly_group->val,
+    &host->local_largest_group_ts_rcvd, &local_servers_groups_count) ;
+    if(NULL == ptr)
+      goto out ;
   }
   
   local_servers_list_len = ptr-ptr_list ;
@@ -2079,7 +2443,7 @@ extern void local_send_report_host(struct host_struct *host,
     free(proc_pid) ;
     
     retval = -EMSGSIZE ;
-    if(ptr > msg + MAX_MSG_LEN) {
+    if(ptr > msg + REP_MAX_LEN) {
 #ifdef OUTPUT
       fprintf(stderr, "Buffer overflow\n") ;
 #endif
@@ -2095,21 +2459,60 @@ extern void local_send_report_host(struct host_struct *host,
   
   /* Added for Omega */
   /* Add the variables accusationTime and startTime of processes belonging to the jointly groups */
+  retval = -EMSGSIZE ;
   list_for_each(tmp_jointly_groups, &host->jointly_groups_head) {
     jointly_group = list_entry(tmp_jointly_groups, struct uint_struct, uint_list) ;
-    list_for_each(tmp_lprocs, &local_procs_list_head) {
-      lproc = list_entry(tmp_lprocs, struct localproc_struct, local_procs_list);
-      if(is_in_ordered_gqlist(jointly_group->val, &lproc->gqlist_head) &&
-        is_in_ordered_visibility_list(lproc->pid, jointly_group->val) && (jointly_group->val != 0)) {
-        if (getlocalvars(jointly_group->val, &accusationTime, &startTime) == 0) {
-          ptr = msg_build_rep_localvars(ptr, jointly_group->val, &accusationTime, &startTime);
-          localvars_count++;
-          break;   /* There is only one set of localvars per group */
-        }
-      }
+    ptr = local_build_rep_localvars(ptr, jointly_group->val, &localvars_count) ;
+    if(ptr > msg + REP_MAX_LEN)
+      goto out ;
+  }
+  
+  /* leave out the lists the host already has */
+  list[REP_LIST_SERVERS] = msg_skip_rep_head(msg) ;
+  len[REP_LIST_SERVERS] = local_servers_proc_count * sizeof(int) ;
+  list[REP_LIST_GROUPS] = list[REP_LIST_SERVERS] + len[REP_LIST_SERVERS] ;
+  len[REP_LIST_GROUPS] = local_servers_list_len - len[REP_LIST_SERVERS] ;
+  list[REP_LIST_CLIENTS] = ptr_ghead ;
+  len[REP_LIST_CLIENTS] = remote_servers_list_len ;
+  
+  omitted = local_omit_lists(host, list, len, sending_ts) ;
+  if(omitted) {
+    ptr_list = list[REP_LIST_SERVERS] ;
+    for(i = 0 ; i < REP_LISTS ; i++) {
+      if(omitted & (1 << i))
+        continue ;
+      memmove(ptr_list, list[i], len[i]) ;
+      ptr_list += len[i] ;
+    }
+    ptr_vars = ptr_ghead + remote_servers_list_len ;
+    memmove(ptr_list, ptr_vars, ptr - ptr_vars) ;
+    ptr = ptr_list + (ptr - ptr_vars) ;
+    
+    if(omitted & (1 << REP_LIST_SERVERS)) {
+      local_servers_list_len -= local_servers_proc_count * sizeof(int) ;
+      local_servers_proc_count = 0 ;
+    }
+    if(omitted & (1 << REP_LIST_GROUPS)) {
+      local_servers_list_len -= len[REP_LIST_GROUPS] ;
+      local_servers_groups_count = 0 ;
+    }
+    if(omitted & (1 << REP_LIST_CLIENTS)) {
+      remote_servers_list_len = 0 ;
+      remote_servers_proc_count = 0 ;
     }
   }
   
+  if(host->wire_version >= WIRE_VERSION_DELTA) {
+    retval = -EMSGSIZE ;
+    if(ptr + REP_DELTA_LEN > msg + REP_MAX_LEN)
+      goto out ;
+    ptr = msg_build_rep_delta(ptr, omitted, host->lists_applied_seq) ;
+  }
+  
+  /* the omega accusations for the host go with the report */
+  ptr_accusations = ptr ;
+  ptr = local_build_rep_accusations(host, ptr, msg + REP_MAX_LEN) ;
+  
   host->local_seq++ ;
   
   msg_build_rep_head(ptr_head, sending_ts, host->local_seq,
@@ -2124,17 +2527,43 @@ extern void local_send_report_host(struct host_struct *host,
     remote_servers_proc_count, host->remote_needed_sendint,
   &host->remote_largest_group_ts_rcvd) ;
   
-  retval = comm_send(msg, ptr-msg, &host->addr) ;
-  
-  if (retval >= 0)
-    memcpy(&host->last_report_ts, sending_ts, sizeof(host->last_report_ts));
-  
-  if(host->local_needed_sendint)
-    unit2timer(host->local_needed_sendint, &host->next_report_ts) ;
+  /* hosts that understand it get the compact format, the fixed one is
+   kept if the conversion fails */
+  msg_len = -1 ;
+  if(host->wire_version >= WIRE_VERSION_COMPACT)
+    msg_len = msg_compact_report(msg, ptr-msg, compact_msg, REP_MAX_LEN) ;
+  if(msg_len > 0)
+    retval = local_send_report_msg(host, compact_msg, msg_len, sending_ts) ;
+  else {
+    msg_len = ptr-msg ;
+    retval = local_send_report_msg(host, msg, msg_len, sending_ts) ;
+  }
+  
+  metrics_hist_since(&metrics.report_build, build_start_ns) ;
+  if (retval >= 0) {
+    host->last_report_ns = wall2mono_ns(sending_ts) ;
+    if(ptr != ptr_accusations)
+      local_drop_accusations(host) ;
+    metrics.reports_sent++ ;
+    trace_event(TRACE_REPORT_SENT, &host->addr, host->local_seq, msg_len,
+    host->local_needed_sendint) ;
+  }
   else
+    metrics.reports_send_failed++ ;
+  
+  if(host->mcast_covered)
+    /* the alives go through the multicast, the report only keeps the
+     lists of processes up to date */
+    host->next_report_ns = host->last_report_ns +
+    unit2ns(max(host->local_needed_sendint, MCAST_UNICAST_SENDINT)) ;
+  else if(host->local_needed_sendint)
+    host->next_report_ns = host->last_report_ns +
+    unit2ns(host->local_needed_sendint) ;
+  else {
     fprintf(stderr, "Error: send interval to host: %u.%u.%u.%u is 0!\n", NIPQUAD(&host->addr));
+    host->next_report_ns = host->last_report_ns + unit2ns(MAX_SENDINT) ;
+  }
   
-  timeradd(&host->last_report_ts, &host->next_report_ts, &host->next_report_ts) ;
   sched_report(host) ;
   
   out:
@@ -2149,11 +2578,163 @@ extern void local_send_report_host(struct host_struct *host,
   }
 }
 
+/* a host is reached by the alive multicast once the initial estimation
+ is over in both directions and it knows all our processes in the jointly
+ groups: from then on the shared part of the report is the same for
+ every such host. */
+static int local_alive_multicast_covers(struct host_struct *host) {
+  struct timeval largest_jointly_group_ts ;
+  
+  if(host->stats.local_initial_finished != FINISHED_YES ||
+    host->stats.remote_initial_finished != FINISHED_YES)
+    return 0 ;
+  
+  if(get_largest_jointly_group_ts(host, &largest_jointly_group_ts) < 0)
+    return 0 ;
+  
+  return !timercmp(&host->local_largest_group_ts_rcvd,
+  &largest_jointly_group_ts, <) ;
+}
+
+/* completes the head of an alive multicast message ending at end and
+ sends it to the IP multicast group */
+static int local_multicast_alive_msg(char *msg, char *end,
+  struct timeval *sending_ts,
+  int groups_count, int groups_len,
+  unsigned int localvars_count,
+  int sections_count) {
+  int retval ;
+  
+  msg_build_alive_multicast_head(msg, sending_ts, &local_epoch,
+  local_groups_alive_list_seq, groups_count, groups_len,
+  localvars_count, sections_count) ;
+  
+  retval = comm_hello_multicast(msg, end-msg) ;
+  if(retval >= 0)
+    metrics.reports_sent++ ;
+  else
+    metrics.reports_send_failed++ ;
+  return retval ;
+}
+
+/* sends the alives of all the local groups once to the IP multicast group
+ instead of once per host. The groups and the localvars are shared by all
+ the receivers, followed by one section per covered host with the per host
+ fields of the report header (sections that do not fit are sent in further
+ datagrams). The covered hosts keep receiving unicast reports, at most
+ every MCAST_UNICAST_SENDINT, for the lists of processes. The multicast is
+ sent at the smallest sendint needed by a covered host. */
+extern void local_send_alive_multicast(struct timeval *sending_ts) {
+  char msg[SAFE_MSG_LEN] ;
+  char *ptr          = NULL ;
+  char *ptr_list     = NULL ;
+  char *ptr_sections = NULL ;
+  
+  struct list_head *tmp = NULL ;
+  struct uint_struct *group = NULL ;
+  struct host_struct *host = NULL ;
+  
+  int groups_count = 0 ;
+  int groups_len = 0 ;
+  unsigned int localvars_count = 0 ;
+  int sections_count = 0 ;
+  int covered ;
+  u_int sendint = 0 ;
+  int retval ;
+  
+  ptr = msg_skip_alive_multicast_head(msg) ;
+  ptr_list = ptr ;
+  
+  if(!alive_groups_built ||
+    alive_groups_seq != local_groups_multicast_list_seq) {
+    list_free(&alive_groups_list, struct uint_struct, uint_list) ;
+    alive_groups_built = 0 ;
+    retval = build_groups_list(&alive_groups_list) ;
+    if(retval < 0)
+      goto out ;
+    alive_groups_seq = local_groups_multicast_list_seq ;
+    alive_groups_built = 1 ;
+  }
+  
+  retval = -EMSGSIZE ;
+  list_for_each(tmp, &alive_groups_list) {
+    group = list_entry(tmp, struct uint_struct, uint_list) ;
+    ptr = local_build_rep_group(msg + MAX_MSG_LEN, ptr, group->val, NULL,
+    &groups_count) ;
+    if(NULL == ptr)
+      goto out ;
+  }
+  groups_len = ptr - ptr_list ;
+  
+  list_for_each(tmp, &alive_groups_list) {
+    group = list_entry(tmp, struct uint_struct, uint_list) ;
+    ptr = local_build_rep_localvars(ptr, group->val, &localvars_count) ;
+    if(ptr > msg + MAX_MSG_LEN)
+      goto out ;
+  }
+  
+  ptr_sections = ptr ;
+  if(ptr_sections + ALIVE_MULTICAST_SECTION_LEN > msg + MAX_MSG_LEN)
+    goto out ;
+  
+  retval = 0 ;
+  
+  out:
+  /* decide which hosts are reached by the multicast */
+  list_for_each(tmp, &remote_host_list_head) {
+    host = list_entry(tmp, struct host_struct, remote_host_list) ;
+    covered = (retval == 0) && local_alive_multicast_covers(host) ;
+    if(host->mcast_covered && !covered) {
+      /* back to the regular reports right away */
+      host->mcast_covered = 0 ;
+      local_sched_report_sooner(host->local_needed_sendint, sending_ts, host) ;
+    }
+    host->mcast_covered = covered ;
+    if(covered && (!sendint || host->local_needed_sendint < sendint))
+      sendint = host->local_needed_sendint ;
+  }
+  
+  if(retval < 0) {
+#ifdef OUTPUT
+    fprintf(stderr, "fdd: local_send_alive_multicast() failed\n");
+#endif
+#ifdef LOG
+    fprintf(flog, "fdd: local_send_alive_multicast() failed\n");
+#endif
+  }
+  
+  if(sendint) {
+    ptr = ptr_sections ;
+    list_for_each(tmp, &remote_host_list_head) {
+      host = list_entry(tmp, struct host_struct, remote_host_list) ;
+      if(!host->mcast_covered)
+        continue ;
+      if(ptr + ALIVE_MULTICAST_SECTION_LEN > msg + MAX_MSG_LEN) {
+        local_multicast_alive_msg(msg, ptr, sending_ts, groups_count,
+        groups_len, localvars_count, sections_count) ;
+        ptr = ptr_sections ;
+        sections_count = 0 ;
+      }
+      host->local_seq++ ;
+      ptr = msg_build_alive_multicast_section(ptr, &host->addr,
+        host->local_seq, sendint, host->remote_needed_sendint,
+      &host->remote_epoch, &host->remote_largest_group_ts_rcvd) ;
+      sections_count++ ;
+    }
+    if(sections_count)
+      local_multicast_alive_msg(msg, ptr, sending_ts, groups_count,
+      groups_len, localvars_count, sections_count) ;
+  }
+  else
+    sendint = MCAST_IDLE_SENDINT ;
+  
+  sched_alive_multicast(sending_ts, sendint) ;
+}
+
 /* make sure next report is send no later than sendint after the last one.
  if we are late, but put timestamp now */
 extern void local_sched_report_sooner(u_int sendint, struct timeval *now,
   struct host_struct *host) {
-  struct timeval tv ;
   
   /*
   if(!sendint)
@@ -2164,11 +2745,13 @@ extern void local_sched_report_sooner(u_int sendint, struct timeval *now,
   print_ts(now);
 #endif
   
-  unit2timer(sendint, &tv) ;
-  timeradd(&host->last_report_ts, &tv, &tv);
-  if(timercmp(&tv, &host->next_report_ts, <)) {
+  /* the multicast already carries what the host waits for */
+  if(host->mcast_covered && sendint < MCAST_UNICAST_SENDINT)
+    sendint = MCAST_UNICAST_SENDINT ;
+  
+  if(host->last_report_ns + unit2ns(sendint) < host->next_report_ns) {
     //    if(timercmp(&tv, now, <)) {
-    memcpy(&host->next_report_ts, now, sizeof(*now));
+    host->next_report_ns = wall2mono_ns(now) ;
     sched_report(host);
     //    }
   }
@@ -2203,6 +2786,9 @@ extern void local_change_notify(struct localproc_struct *lproc, int not_type,
 #endif
   retval = 0;
   
+  trace_event(TRACE_NOTIFY, tproc->host ? &tproc->host->addr : &fdd_local_addr,
+  tproc->pid, tproc->gid ? tproc->gid->val : 0, not_type) ;
+  
 #ifdef OUTTRUST
   printf("Notice %s to %u, for %u on ",
     not_type==TRUST_NOTIF?not_trust:not_type==SUSPECT_NOTIF?not_suspect:
@@ -0,0 +1,329 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_metrics.c - serves the runtime counters on a local unix socket */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "fdd.h"
+#include "fdd_metrics.h"
+#include "misc.h"
+
+/* exported stuff */
+struct fdd_metrics metrics ;
+
+/* imported stuff */
+extern struct list_head event_list_head ;
+
+/* local stuff */
+static int metrics_socket = -1 ;
+static char *metrics_buf = NULL ;
+static int metrics_size ;      /* allocated length of metrics_buf */
+static int metrics_len ;
+static int metrics_truncated ; /* a line did not fit, nothing more goes */
+
+/* the scrapes not sent whole yet, continued when their socket is writable */
+struct metrics_conn {
+  int fd ;             /* -1 if the slot is free */
+  char *buf ;
+  int len ;
+  int sent ;
+  u_int64_t deadline ; /* metrics_now_ns() after which the reader is dropped */
+} ;
+static struct metrics_conn metrics_conns[METRICS_MAX_CONNS] ;
+
+/* appends to the scrape buffer, growing it up to METRICS_BUF_MAX. What does
+ not fit is left out from the first line that is cut, the scrape then
+ ending with METRICS_TRUNCATED (room for it is kept) */
+static void metrics_printf(const char *fmt, ...) {
+  va_list ap ;
+  char *buf ;
+  int n, room, size ;
+  
+  if(metrics_truncated || metrics_buf == NULL)
+    return ;
+  for(;;) {
+    room = metrics_size - metrics_len - (int)sizeof(METRICS_TRUNCATED) ;
+    va_start(ap, fmt) ;
+    n = vsnprintf(metrics_buf + metrics_len, room > 0 ? room : 0, fmt, ap) ;
+    va_end(ap) ;
+    if(n < 0)
+      return ;
+    if(n < room) {
+      metrics_len += n ;
+      return ;
+    }
+    
+    size = metrics_size * 2 ;
+    buf = (size <= METRICS_BUF_MAX) ? realloc(metrics_buf, size) : NULL ;
+    if(buf == NULL)
+      break ;
+    metrics_buf = buf ;
+    metrics_size = size ;
+  }
+  
+  /* back to the end of the last whole line */
+  while(metrics_len > 0 && metrics_buf[metrics_len - 1] != '\n')
+    metrics_len-- ;
+  memcpy(metrics_buf + metrics_len, METRICS_TRUNCATED,
+  sizeof(METRICS_TRUNCATED) - 1) ;
+  metrics_len += sizeof(METRICS_TRUNCATED) - 1 ;
+  metrics_truncated = 1 ;
+}
+
+static void metrics_counter(const char *name, const char *help, u_int64_t val) {
+  metrics_printf("# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+  name, help, name, name, (unsigned long long)val) ;
+}
+
+static void metrics_histogram(const char *name, const char *help,
+  struct metrics_hist *hist) {
+  u_int64_t cumul = 0 ;
+  int i ;
+  
+  metrics_printf("# HELP %s %s\n# TYPE %s histogram\n", name, help, name) ;
+  for(i = 0 ; i < METRICS_HIST_BUCKETS - 1 ; i++) {
+    cumul += hist->bucket[i] ;
+    metrics_printf("%s_bucket{le=\"%g\"} %llu\n", name,
+    (double)(1u << i) / 1000000.0, (unsigned long long)cumul) ;
+  }
+  metrics_printf("%s_bucket{le=\"+Inf\"} %llu\n", name,
+  (unsigned long long)hist->count) ;
+  metrics_printf("%s_sum %.9f\n%s_count %llu\n", name,
+    (double)hist->sum_ns / 1000000000.0, name,
+  (unsigned long long)hist->count) ;
+}
+
+/* builds the Prometheus text exposition of all the metrics */
+static void metrics_build(void) {
+  struct list_head *tmp = NULL ;
+  struct host_struct *host = NULL ;
+  unsigned int queue_depth = 0 ;
+  
+  metrics_len = 0 ;
+  metrics_truncated = 0 ;
+  
+  list_for_each(tmp, &event_list_head)
+    queue_depth++ ;
+  
+  metrics_counter("fdd_loop_iterations_total", "Iterations of the select loop.",
+  metrics.loop_iterations) ;
+  metrics_counter("fdd_reports_sent_total", "Report messages sent.",
+  metrics.reports_sent) ;
+  metrics_counter("fdd_reports_send_failed_total", "Report messages that could not be sent.",
+  metrics.reports_send_failed) ;
+  metrics_counter("fdd_reports_received_total", "Report messages received.",
+  metrics.reports_rcvd) ;
+  metrics_counter("fdd_reports_out_of_order_total", "Report messages received out of order.",
+  metrics.reports_out_of_order) ;
+  metrics_counter("fdd_host_suspects_total", "Remote hosts suspected.",
+  metrics.host_suspects) ;
+  metrics_counter("fdd_leader_changes_total", "Changes of a group global leader.",
+  metrics.leader_changes) ;
+  metrics_counter("fdd_events_dispatched_total", "Scheduled events executed.",
+  metrics.events_dispatched) ;
+  
+  metrics_printf("# HELP fdd_event_queue_depth Events in the schedule queue.\n"
+  "# TYPE fdd_event_queue_depth gauge\nfdd_event_queue_depth %u\n", queue_depth) ;
+  
+  metrics_histogram("fdd_report_build_seconds", "Time to build and send a report.",
+  &metrics.report_build) ;
+  metrics_histogram("fdd_sched_run_seconds", "Time spent in fd_sched_run.",
+  &metrics.sched_run) ;
+  metrics_histogram("fdd_sched_lateness_seconds", "Delay between an event time and its execution.",
+  &metrics.sched_lateness) ;
+  metrics_histogram("fdd_dispatch_seconds", "Time from select wake up to the end of dispatch.",
+  &metrics.dispatch) ;
+  metrics_histogram("fdd_leader_update_seconds", "Time spent in updateGlobalLeader.",
+  &metrics.leader_update) ;
+  
+  metrics_printf("# TYPE fdd_host_pl gauge\n# TYPE fdd_host_e_d_ms gauge\n"
+    "# TYPE fdd_host_v_d_ms gauge\n# TYPE fdd_host_local_needed_sendint_ms gauge\n"
+  "# TYPE fdd_host_remote_needed_sendint_ms gauge\n") ;
+  list_for_each(tmp, &remote_host_list_head) {
+    host = list_entry(tmp, struct host_struct, remote_host_list) ;
+    metrics_printf("fdd_host_pl{host=\"%u.%u.%u.%u\"} %f\n"
+      "fdd_host_e_d_ms{host=\"%u.%u.%u.%u\"} %f\n"
+      "fdd_host_v_d_ms{host=\"%u.%u.%u.%u\"} %f\n"
+      "fdd_host_local_needed_sendint_ms{host=\"%u.%u.%u.%u\"} %u\n"
+      "fdd_host_remote_needed_sendint_ms{host=\"%u.%u.%u.%u\"} %u\n",
+      NIPQUAD(&host->addr), host->stats.est.pl,
+      NIPQUAD(&host->addr), host->stats.est.e_d,
+      NIPQUAD(&host->addr), host->stats.est.v_d,
+      NIPQUAD(&host->addr), host->local_needed_sendint,
+    NIPQUAD(&host->addr), host->remote_needed_sendint) ;
+  }
+}
+
+/* metrics_init - opens the unix metrics socket, returns its file descriptor
+ or -1 (the daemon then runs without the endpoint) */
+extern int metrics_init(void) {
+  struct sockaddr_un saddr ;
+  int i ;
+  
+  memset(&metrics, 0, sizeof(metrics)) ;
+  
+  metrics_buf = malloc(METRICS_BUF_LEN) ;
+  if(metrics_buf == NULL) {
+    perror("fdd: cannot allocate the metrics buffer") ;
+    return -1 ;
+  }
+  metrics_size = METRICS_BUF_LEN ;
+  for(i = 0 ; i < METRICS_MAX_CONNS ; i++)
+    metrics_conns[i].fd = -1 ;
+  
+  metrics_socket = socket(AF_UNIX, SOCK_STREAM, 0) ;
+  if(metrics_socket < 0) {
+    perror("fdd: cannot open the metrics socket") ;
+    return -1 ;
+  }
+  
+  memset(&saddr, 0, sizeof(saddr)) ;
+  saddr.sun_family = AF_UNIX ;
+  strncpy(saddr.sun_path, FDD_METRICS_SOCK, sizeof(saddr.sun_path) - 1) ;
+  (void)unlink(FDD_METRICS_SOCK) ;
+  
+  if(bind(metrics_socket, (struct sockaddr *)&saddr, sizeof(saddr)) < 0 ||
+    listen(metrics_socket, 4) < 0 ||
+  fcntl(metrics_socket, F_SETFL, O_NONBLOCK) < 0) {
+    perror("fdd: cannot bind the metrics socket") ;
+    close(metrics_socket) ;
+    metrics_socket = -1 ;
+    return -1 ;
+  }
+  return metrics_socket ;
+}
+
+static void metrics_conn_close(struct metrics_conn *conn) {
+  close(conn->fd) ;
+  free(conn->buf) ;
+  conn->fd = -1 ;
+  conn->buf = NULL ;
+}
+
+extern void metrics_cleanup(void) {
+  int i ;
+  
+  for(i = 0 ; i < METRICS_MAX_CONNS ; i++)
+    if(metrics_conns[i].fd >= 0)
+      metrics_conn_close(&metrics_conns[i]) ;
+  free(metrics_buf) ;
+  metrics_buf = NULL ;
+  if(metrics_socket < 0)
+    return ;
+  close(metrics_socket) ;
+  (void)unlink(FDD_METRICS_SOCK) ;
+  metrics_socket = -1 ;
+}
+
+/* sends what the socket takes of the scrape without blocking. Returns 1
+ once it is sent whole, 0 if there is more to send, -1 on error */
+static int metrics_send(int fd, char *buf, int len, int *sent) {
+  int n ;
+  
+  while(*sent < len) {
+    n = send(fd, buf + *sent, len - *sent, MSG_DONTWAIT | MSG_NOSIGNAL) ;
+    if(n < 0) {
+      if(errno == EINTR)
+        continue ;
+      if(errno == EAGAIN || errno == EWOULDBLOCK)
+        return 0 ;
+      perror("fdd: send on the metrics socket") ;
+      return -1 ;
+    }
+    *sent += n ;
+  }
+  return 1 ;
+}
+
+/* metrics_wset - adds to wset the sockets of the scrapes still being sent */
+extern void metrics_wset(fd_set *wset) {
+  int i ;
+  
+  for(i = 0 ; i < METRICS_MAX_CONNS ; i++)
+    if(metrics_conns[i].fd >= 0)
+      FD_SET(metrics_conns[i].fd, wset) ;
+}
+
+/* check_metrics_socket - answers a scrape: what the socket takes of the
+ exposition is sent without blocking, the rest is kept and sent when the
+ socket is writable again (see metrics_wset()). The connection is closed
+ once the scrape is sent, or after METRICS_CONN_TIMEOUT. */
+extern void check_metrics_socket(fd_set *active, fd_set *writable) {
+  struct metrics_conn *conn ;
+  u_int64_t now_ns = metrics_now_ns() ;
+  int fd, sent, retval, i ;
+  
+  for(i = 0 ; i < METRICS_MAX_CONNS ; i++) {
+    conn = &metrics_conns[i] ;
+    if(conn->fd < 0)
+      continue ;
+    retval = 0 ;
+    if(FD_ISSET(conn->fd, writable))
+      retval = metrics_send(conn->fd, conn->buf, conn->len, &conn->sent) ;
+    if(retval != 0 || now_ns > conn->deadline)
+      metrics_conn_close(conn) ;
+  }
+  
+  if(metrics_socket < 0 || !FD_ISSET(metrics_socket, active))
+    goto out ;
+  
+  fd = accept(metrics_socket, NULL, NULL) ;
+  if(fd < 0) {
+    if(errno != EAGAIN && errno != EWOULDBLOCK)
+      perror("fdd: accept on the metrics socket") ;
+    goto out ;
+  }
+  
+  metrics_build() ;
+  sent = 0 ;
+  if(metrics_send(fd, metrics_buf, metrics_len, &sent) != 0) {
+    close(fd) ;
+    goto out ;
+  }
+  
+  /* keep the rest for when the reader takes it */
+  for(i = 0 ; i < METRICS_MAX_CONNS && metrics_conns[i].fd >= 0 ; i++)
+    ;
+  if(i == METRICS_MAX_CONNS ||
+    (metrics_conns[i].buf = malloc(metrics_len - sent)) == NULL) {
+    fprintf(stderr, "fdd: metrics scrape dropped, too many slow readers\n") ;
+    close(fd) ;
+    goto out ;
+  }
+  conn = &metrics_conns[i] ;
+  memcpy(conn->buf, metrics_buf + sent, metrics_len - sent) ;
+  conn->len = metrics_len - sent ;
+  conn->sent = 0 ;
+  conn->deadline = now_ns + METRICS_CONN_TIMEOUT ;
+  conn->fd = fd ;
+  
+  out:
+  return ;
+}
@@ -31,12 +31,14 @@
 #include "variables_exchange.h"
 #include "misc.h"
 #include "omega.h"
+#include "fdd_arena.h"
 #include <pthread.h>
 
 
 /* imported stuff */
 extern struct list_head local_procs_list_head ;
 extern struct list_head local_groups_list_head ;
+extern struct gset local_groups_set ;
 extern struct timeval local_epoch ;
 extern unsigned int local_groups_list_seq ;
 
@@ -46,6 +48,48 @@ extern FILE *flog ;
 
 LIST_HEAD(remote_host_list_head) ;
 
+/* the processes of a list of a report, sorted and without duplicates */
+struct pid_view {
+  u_int *pids ;
+  unsigned int count ;
+} ;
+
+/* a process of a group of a report */
+struct pg_pair {
+  u_int gid ;
+  u_int pid ;
+  u_int eta_rcvd ;
+} ;
+
+/* the processes of the groups of a report, sorted by group then by pid
+ and without duplicates */
+struct pg_view {
+  struct pg_pair *pairs ;
+  unsigned int count ;
+} ;
+
+/* the views of the report being merged, given back when remote_merge()
+ returns */
+static struct arena merge_arena = ARENA_INIT ;
+
+/* each pid of a report of len bytes is parsed at most once in a pid_view
+ or a pg_pair, in 3 allocations */
+#define MERGE_ARENA_SIZE(len) ((len) / REP_PID_LEN * \
+(sizeof(u_int) + sizeof(struct pg_pair)) + 3 * ARENA_ALIGN)
+
+extern void remote_cleanup(void) {
+  arena_free(&merge_arena) ;
+}
+
+/* drops the report of host being reassembled, if any */
+static void frag_free(struct host_struct *host) {
+  if(host->frag) {
+    free(host->frag->msg) ;
+    free(host->frag) ;
+    host->frag = NULL ;
+  }
+}
+
 /* frees all the allocation of memory to a host */
 static void free_host(struct host_struct *host) {
   
@@ -53,15 +97,14 @@ static void free_host(struct host_struct *host) {
   list_free(&host->local_clients_proc_head, struct uint_struct, uint_list) ;
   list_free(&host->local_servers_proc_head, struct uint_struct, uint_list) ;
   list_free(&host->jointly_groups_head, struct uint_struct, uint_list) ;
+  gset_free(&host->jointly_groups_set) ;
   list_free(&host->remote_all_groups_head, struct uint_struct, uint_list) ;
+  list_free(&host->hello_groups_head, struct uint_struct, uint_list) ;
   list_free(&host->remote_all_groups_procs_head, struct procgroup_struct,
   pglist) ;
   list_free(&host->list_remote_procs_in_groups_to_calc_eta, struct procgroup_struct,
   pglist);
   
-  list_free(&host->stats.average_lost_head, struct average_lost_struct,
-  lost_msg_list) ;
-  
 #ifndef INSTANT_EXPECTED_DELAY_OFF
   list_free(&host->stats.instant_delay_msg_head, struct instant_delay_struct,
   instant_delay_list) ;
@@ -70,8 +113,13 @@ static void free_host(struct host_struct *host) {
   list_free(&host->stats.average_delay_msg_head, struct average_delay_struct,
   delay_list) ;
   
+  list_free(&host->accusations_head, struct accusation_struct,
+  accusation_list) ;
+  
   list_del(&host->remote_host_list);
   
+  frag_free(host) ;
+  
   /* Added for Omega */
   /* When we delete a host, we also have to delete its corresponding entry in
    remotevars list (if it exists). */
@@ -160,11 +208,13 @@ static struct host_struct *create_host(struct sockaddr_in *addr,
   /* assume to be now the moment of the last_sending of the remote,
    last_report sent and next_report */
   memcpy(&host->sending_ts, now, sizeof(host->sending_ts)) ;
-  memcpy(&host->last_report_ts, now, sizeof(host->last_report_ts)) ;
-  memcpy(&host->next_report_ts, now, sizeof(host->next_report_ts)) ;
+  host->last_report_ns = host->next_report_ns = wall2mono_ns(now) ;
   
   /* init the statistics */
   stats_init(&host->stats) ;
+  /* with recent estimates of that address no INITIAL_ED stage is needed
+   on our side */
+  warm_seed(host, now) ;
   
   timerclear(&host->sim_lf.next_lf);
   timerclear(&host->sim_lf.end_next_lf);
@@ -173,6 +223,8 @@ static struct host_struct *create_host(struct sockaddr_in *addr,
   host->remote_initial_ed_seq = 0;
   
   host->hello_seq = 0 ;
+  host->hello_digest = 0 ;
+  timerclear(&host->hello_digest_ts) ;
   host->stats.last_seq = seq ;
   host->local_seq = 0 ;
   host->last_local_clients_list_seq = 0 ;
@@ -182,11 +234,25 @@ static struct host_struct *create_host(struct sockaddr_in *addr,
   host->remote_servers_list_seq = 0 ;
   host->remote_groups_list_seq = 0 ;
   host->remote_groups_multicast_list_seq = 0 ;
+  host->remote_groups_alive_list_seq = 0 ;
   
   host->remote_actual_sendint = MAX_SENDINT ;
   host->remote_needed_sendint = MAX_SENDINT ;
   host->local_needed_sendint = MAX_SENDINT ;
   
+  host->wire_version = WIRE_VERSION_FIXED ;
+  host->frag = NULL ;
+  host->report_event = NULL ;
+  host->mcast_covered = 0 ;
+  host->accusations_count = 0 ;
+  
+  memset(host->lists_seq, 0, sizeof(host->lists_seq)) ;
+  memset(host->lists_digest, 0, sizeof(host->lists_digest)) ;
+  memset(host->lists_changed_seq, 0, sizeof(host->lists_changed_seq)) ;
+  memset(host->lists_acked_seq, 0, sizeof(host->lists_acked_seq)) ;
+  memset(host->lists_applied_seq, 0, sizeof(host->lists_applied_seq)) ;
+  memcpy(&host->last_snapshot_ts, now, sizeof(host->last_snapshot_ts)) ;
+  
   timerclear(&host->local_largest_group_ts_rcvd);
   timerclear(&host->remote_largest_group_ts_rcvd);
   
@@ -194,7 +260,10 @@ static struct host_struct *create_host(struct sockaddr_in *addr,
   INIT_LIST_HEAD(&host->local_clients_proc_head) ;
   INIT_LIST_HEAD(&host->remote_servers_proc_head) ;
   INIT_LIST_HEAD(&host->jointly_groups_head) ;
+  gset_init(&host->jointly_groups_set) ;
   INIT_LIST_HEAD(&host->remote_all_groups_head) ;
+  INIT_LIST_HEAD(&host->hello_groups_head) ;
+  INIT_LIST_HEAD(&host->accusations_head) ;
   INIT_LIST_HEAD(&host->remote_all_groups_procs_head) ;
   INIT_LIST_HEAD(&host->list_remote_procs_in_groups_to_calc_eta);
   
@@ -254,7 +323,7 @@ static struct host_struct *create_host(struct sockaddr_in *addr,
 
 /* parse the list of processes received in a report message
  from a remote host */
-extern char *parse_proc_list(char *msg, char *ptr_start, int pcount,
+extern char *parse_proc_list(char *msg_end, char *ptr_start, int pcount,
   struct list_head *list, int *retval) {
   int i ;
   char *ptr = ptr_start ;
@@ -271,7 +340,7 @@ extern char *parse_proc_list(char *msg, char *ptr_start, int pcount,
     ptr = msg_parse_rep_pid(ptr, &pid) ;
     
     *retval = -EMSGSIZE ;
-    if (ptr > msg + MAX_MSG_LEN)
+    if (ptr > msg_end)
       goto out ;
     
     entry_ptr = NULL ;
@@ -288,9 +357,278 @@ extern char *parse_proc_list(char *msg, char *ptr_start, int pcount,
   return ptr ;
 }
 
+static int pid_cmp(const void *a, const void *b) {
+  u_int x = *(const u_int *)a ;
+  u_int y = *(const u_int *)b ;
+  
+  return (x > y) - (x < y) ;
+}
+
+static int pg_pair_cmp(const void *a, const void *b) {
+  const struct pg_pair *x = a ;
+  const struct pg_pair *y = b ;
+  
+  if(x->gid != y->gid)
+    return (x->gid > y->gid) - (x->gid < y->gid) ;
+  return (x->pid > y->pid) - (x->pid < y->pid) ;
+}
+
+/* sort the view and drop its duplicates. The reports are built in
+ order, so the sort is seldom needed */
+static void pid_view_normalize(struct pid_view *view) {
+  unsigned int i, n ;
+  
+  for(i = 1 ; i < view->count ; i++)
+    if(view->pids[i - 1] >= view->pids[i])
+      break ;
+  if(i >= view->count)
+    return ;
+  
+  qsort(view->pids, view->count, sizeof(*view->pids), pid_cmp) ;
+  for(i = 1, n = 1 ; i < view->count ; i++)
+    if(view->pids[i] != view->pids[n - 1])
+      view->pids[n++] = view->pids[i] ;
+  view->count = n ;
+}
+
+/* same for the processes of the groups, a process is taken as sent with
+ its eta if one of its duplicates is */
+static void pg_view_normalize(struct pg_view *view) {
+  unsigned int i, n ;
+  
+  for(i = 1 ; i < view->count ; i++)
+    if(pg_pair_cmp(&view->pairs[i - 1], &view->pairs[i]) >= 0)
+      break ;
+  if(i >= view->count)
+    return ;
+  
+  qsort(view->pairs, view->count, sizeof(*view->pairs), pg_pair_cmp) ;
+  for(i = 1, n = 1 ; i < view->count ; i++) {
+    if(pg_pair_cmp(&view->pairs[i], &view->pairs[n - 1]) == 0)
+      view->pairs[n - 1].eta_rcvd |= view->pairs[i].eta_rcvd ;
+    else
+      view->pairs[n++] = view->pairs[i] ;
+  }
+  view->count = n ;
+}
+
+/* parse the list of pcount processes received in a report message in
+ view, from merge_arena */
+static char *parse_pid_view(char *msg_end, char *ptr_start,
+  unsigned int pcount, struct pid_view *view, int *retval) {
+  unsigned int i ;
+  char *ptr = ptr_start ;
+  
+  view->count = 0 ;
+  *retval = -EMSGSIZE ;
+  if(ptr > msg_end || pcount > (unsigned int)((msg_end - ptr) / REP_PID_LEN))
+    goto out ;
+  
+  *retval = -ENOMEM ;
+  view->pids = arena_alloc(&merge_arena, pcount * sizeof(*view->pids)) ;
+  if(view->pids == NULL)
+    goto out ;
+  
+  for(i = 0 ; i < pcount ; i++)
+    ptr = msg_parse_rep_pid(ptr, &view->pids[i]) ;
+  view->count = pcount ;
+  pid_view_normalize(view) ;
+  *retval = 0 ;
+  out:
+  return ptr ;
+}
+
+/* parse the pcount processes of the group gid of a received report,
+ appending them to view which has room for them */
+static char *parse_group_procs_list(char *msg_end, char *ptr_start,
+  struct sockaddr_in *addr, unsigned int gid,
+  unsigned int pcount, struct pg_view *view, unsigned int eta_rcvd,
+  int *retval, struct timeval *arrival_ts) {
+  unsigned int i ;
+  char *ptr = ptr_start ;
+  unsigned int pid ;
+  
+  struct pg_pair *pair ;
+  struct timeval accusationTime ;
+  
+  *retval = -EMSGSIZE ;
+  if(ptr > msg_end || pcount > (unsigned int)((msg_end - ptr) / REP_PID_LEN))
+    goto out ;
+  
+  for(i = 0 ; i < pcount ; i++) {
+    ptr = msg_parse_rep_pid(ptr, &pid) ;
+    
+    pair = &view->pairs[view->count++] ;
+    pair->gid = gid ;
+    pair->pid = pid ;
+    pair->eta_rcvd = eta_rcvd ;
+    
+    /* Added for Omega */
+    /* Upon received alive */
+    if (omega_group_exists_locally(gid, NOT_CANDIDATE) && eta_rcvd) {
+      switch (add_proc_in_globalContenders_set(addr, pid, gid)) {
+        case -1:
+          fprintf(stderr, "omega error: upon receiving alive msg from: %u.%u.%u.%u impossible\n",  NIPQUAD(addr));
+          fprintf(stderr, "to add proc: %u in contenders set of group: %u\n", pid, gid);
+        break;
+        case 1:
+          /* new contender: re-elect if its variables are already known,
+           otherwise this is done when they are received */
+          if (get_accusationTime_of_remoteprocess(addr, gid, &accusationTime) == 0)
+            mark_global_leader_dirty(gid);
+        break;
+      }
+    }
+    
+  }
+  *retval = 0 ;
+  out:
+  return ptr ;
+}
+
+/* number of processes of view missing from the ordered list */
+static unsigned int pid_list_missing(struct list_head *list,
+  struct pid_view *view) {
+  struct list_head *tmp = list->next ;
+  unsigned int i, missing = 0 ;
+  
+  for(i = 0 ; i < view->count ; i++) {
+    while(tmp != list &&
+      list_entry(tmp, struct uint_struct, uint_list)->val < view->pids[i])
+    tmp = tmp->next ;
+    if(tmp == list ||
+      list_entry(tmp, struct uint_struct, uint_list)->val != view->pids[i])
+    missing++ ;
+  }
+  return missing ;
+}
+
+/* make the ordered list hold the processes of view: the entries of the
+ processes gone are freed, the new ones are taken from spare */
+static void pid_list_sync(struct list_head *list, struct pid_view *view,
+  struct list_head *spare) {
+  struct list_head *tmp = list->next, *next ;
+  struct uint_struct *entry ;
+  unsigned int i = 0 ;
+  
+  while(tmp != list || i < view->count) {
+    entry = (tmp != list) ? list_entry(tmp, struct uint_struct, uint_list) : NULL ;
+    if(entry != NULL && (i == view->count || entry->val < view->pids[i])) {
+      next = tmp->next ;
+      list_del(tmp) ;
+      free(entry) ;
+      tmp = next ;
+    }
+    else if(entry != NULL && entry->val == view->pids[i]) {
+      tmp = tmp->next ;
+      i++ ;
+    }
+    else {
+      entry = list_entry(spare->next, struct uint_struct, uint_list) ;
+      list_del(&entry->uint_list) ;
+      entry->val = view->pids[i++] ;
+      list_add_tail(&entry->uint_list, tmp) ;
+    }
+  }
+}
+
+/* the next process of view from i on, only the ones sent with their eta
+ if eta_only */
+static inline unsigned int pg_view_next(struct pg_view *view, unsigned int i,
+  int eta_only) {
+  while(i < view->count && eta_only && !view->pairs[i].eta_rcvd)
+    i++ ;
+  return i ;
+}
+
+static inline int pg_entry_cmp(struct procgroup_struct *entry,
+  struct pg_pair *pair) {
+  if(entry->gid != pair->gid)
+    return (entry->gid > pair->gid) - (entry->gid < pair->gid) ;
+  return (entry->pid > pair->pid) - (entry->pid < pair->pid) ;
+}
+
+/* number of processes of view missing from the list ordered by group
+ then by pid */
+static unsigned int pg_list_missing(struct list_head *list,
+  struct pg_view *view, int eta_only) {
+  struct list_head *tmp = list->next ;
+  unsigned int i, missing = 0 ;
+  
+  for(i = pg_view_next(view, 0, eta_only) ; i < view->count ;
+  i = pg_view_next(view, i + 1, eta_only)) {
+    while(tmp != list && pg_entry_cmp(list_entry(tmp, struct procgroup_struct,
+      pglist), &view->pairs[i]) < 0)
+    tmp = tmp->next ;
+    if(tmp == list || pg_entry_cmp(list_entry(tmp, struct procgroup_struct,
+      pglist), &view->pairs[i]) != 0)
+    missing++ ;
+  }
+  return missing ;
+}
+
+/* make the list ordered by group then by pid hold the processes of view,
+ as pid_list_sync() */
+static void pg_list_sync(struct list_head *list, struct pg_view *view,
+  int eta_only, struct list_head *spare) {
+  struct list_head *tmp = list->next, *next ;
+  struct procgroup_struct *entry ;
+  unsigned int i = pg_view_next(view, 0, eta_only) ;
+  int cmp ;
+  
+  while(tmp != list || i < view->count) {
+    entry = (tmp != list) ? list_entry(tmp, struct procgroup_struct, pglist) : NULL ;
+    cmp = (entry == NULL) ? 1 :
+    (i == view->count) ? -1 : pg_entry_cmp(entry, &view->pairs[i]) ;
+    if(cmp < 0) {
+      next = tmp->next ;
+      list_del(tmp) ;
+      free(entry) ;
+      tmp = next ;
+    }
+    else if(cmp == 0) {
+      tmp = tmp->next ;
+      i = pg_view_next(view, i + 1, eta_only) ;
+    }
+    else {
+      entry = list_entry(spare->next, struct procgroup_struct, pglist) ;
+      list_del(&entry->pglist) ;
+      entry->gid = view->pairs[i].gid ;
+      entry->pid = view->pairs[i].pid ;
+      list_add_tail(&entry->pglist, tmp) ;
+      i = pg_view_next(view, i + 1, eta_only) ;
+    }
+  }
+}
+
+/* allocate n entries in spare, for the *_list_sync() that can't fail */
+static int spare_uints(struct list_head *spare, unsigned int n) {
+  struct uint_struct *entry ;
+  
+  while(n-- > 0) {
+    entry = malloc(sizeof(*entry)) ;
+    if(entry == NULL)
+      return -ENOMEM ;
+    list_add(&entry->uint_list, spare) ;
+  }
+  return 0 ;
+}
+
+static int spare_procgroups(struct list_head *spare, unsigned int n) {
+  struct procgroup_struct *entry ;
+  
+  while(n-- > 0) {
+    entry = malloc(sizeof(*entry)) ;
+    if(entry == NULL)
+      return -ENOMEM ;
+    list_add(&entry->pglist, spare) ;
+  }
+  return 0 ;
+}
+
 /* Added for Omega*/
 /* Parse the remotevars list received and insert them in the remotevars list */
-static char *parse_and_insert_remotevars_list(char *msg, char *ptr_start, unsigned int remotevars_count,
+static char *parse_and_insert_remotevars_list(char *msg_end, char *ptr_start, unsigned int remotevars_count,
   struct sockaddr_in *addr, int *retval) {
   int i;
   char *ptr = ptr_start ;
@@ -301,12 +639,19 @@ static char *parse_and_insert_remotevars_list(char *msg, char *ptr_start, unsign
     ptr = msg_parse_rep_localvars(ptr, &gid, &accusationTime, &startTime);
     
     *retval = -EMSGSIZE ;
-    if (ptr > msg + MAX_MSG_LEN)
+    if (ptr > msg_end)
       goto out ;
     
     if (omega_group_exists_locally(gid, NOT_CANDIDATE)) {
-      if (insert_in_remotevars(addr, gid, &accusationTime, &startTime) < 0)
-        fprintf(stderr, "Couldn't allocate new memory when receiving remote variables in an alive message\n");
+      switch (insert_in_remotevars(addr, gid, &accusationTime, &startTime)) {
+        case -1:
+          fprintf(stderr, "Couldn't allocate new memory when receiving remote variables in an alive message\n");
+        break;
+        case 1: /* only re-elect the groups whose variables changed */
+          if (mark_global_leader_dirty(gid) < 0)
+            fprintf(stderr, "Couldn't mark the leader of group: %u for recomputation\n", gid);
+        break;
+      }
     }
   }
   *retval = 0 ;
@@ -368,7 +713,7 @@ static int build_proc_trust_list(struct localproc_struct *lproc,
     trust_proc->host = rhost ;
     memcpy(&trust_proc->fresh, &fresh, sizeof(fresh)) ;
     
-    list_add(&trust_proc->trust_list, &lproc->tmp_tlist_head) ;
+    list_add_tail(&trust_proc->trust_list, &lproc->tmp_tlist_head) ;
   }
   
   retval = 0 ;
@@ -411,52 +756,22 @@ static int build_trust_lists(struct host_struct *rhost,
   return retval ;
 }
 
-/* parse a received report message and builds a list of remote
- processes and their groups to which they belong */
-static char *parse_group_procs_list(char *msg, char *ptr_start,
-  struct sockaddr_in *addr, unsigned int gid,
-  int pcount, struct list_head *list, unsigned int eta_rcvd,
-  int *retval, struct timeval *arrival_ts) {
-  int i ;
-  char *ptr = ptr_start ;
-  unsigned int pid ;
-  
-  struct procgroup_struct *entry_ptr ;
-  int entry_exists ;
-  
-  INIT_LIST_HEAD(list) ;
-  
-  for(i = 0 ; i < pcount ; i++) {
-    ptr = msg_parse_rep_pid(ptr, &pid) ;
-    
-    *retval = -EMSGSIZE ;
-    if(ptr > msg + MAX_MSG_LEN)
-      goto out ;
-    
-    
-    entry_ptr = NULL ;
-    list_insert_ordered(pid, pid, list, struct procgroup_struct, pglist, <) ;
-    *retval = -ENOMEM ;
-    if( entry_ptr == NULL )
-      goto out ;
-    
-    entry_ptr->gid = gid ;
-    
-    /* Added for Omega */
-    /* Upon received alive */
-    if (omega_group_exists_locally(gid, NOT_CANDIDATE) && eta_rcvd) {
-      if (add_proc_in_globalContenders_set(addr, pid, gid) < 0) {
-        fprintf(stderr, "omega error: upon receiving alive msg from: %u.%u.%u.%u impossible\n",  NIPQUAD(addr));
-        fprintf(stderr, "to add proc: %u in contenders set of group: %u\n", pid, gid);
-      }
-    }
-    
+/* the processes of the groups left out of a report are contenders again,
+ as if the unchanged groups had been parsed */
+static void refresh_group_contenders(struct host_struct *rhost) {
+  struct list_head *tmp = NULL ;
+  struct procgroup_struct *pg = NULL ;
+  struct timeval accusationTime ;
+  
+  list_for_each(tmp, &rhost->remote_all_groups_procs_head) {
+    pg = list_entry(tmp, struct procgroup_struct, pglist) ;
+    if (!omega_group_exists_locally(pg->gid, NOT_CANDIDATE))
+      continue ;
+    if (add_proc_in_globalContenders_set(&rhost->addr, pg->pid, pg->gid) == 1 &&
+      get_accusationTime_of_remoteprocess(&rhost->addr, pg->gid,
+      &accusationTime) == 0)
+      mark_global_leader_dirty(pg->gid);
   }
-  *retval = 0 ;
-  out:
-  if(*retval < 0)
-    list_free(list, struct procgroup_struct, pglist) ;
-  return ptr ;
 }
 
 /* build the trust list for a local process and the servers belonging
@@ -484,22 +799,27 @@ static int build_proc_trust_list_group(unsigned int gid,
     return 0 ;
   
   /* find out all the remote processes in the list belonging to the
-   given group */
+   given group, the list is ordered by group */
   list_for_each(tmp_pg, procgroup_list) {
     remote_procgroup = list_entry(tmp_pg, struct procgroup_struct, pglist) ;
     
-    if(remote_procgroup->gid != gid)
+    if(remote_procgroup->gid < gid)
       continue ;
+    if(remote_procgroup->gid > gid)
+      break ;
     
+    /* set the next freshness point for the suspicion of the process */
+    if(gqos->detector != DETECTOR_PHI ||
+      phi_fresh_point(gqos->qos, &rhost->stats, arrival_ts, &fresh) < 0) {
 #ifdef SYNCH_CLOCKS
-    unit2timer(gqos->qos->TdU, &fresh) ;
-    timeradd(sending_ts, &fresh, &fresh) ;
+      unit2timer(gqos->qos->TdU, &fresh) ;
+      timeradd(sending_ts, &fresh, &fresh) ;
 #else
-    /* set the next freshness point for the suspicion of the process */
-    alfa = gqos->qos->TdU - wei_sendint(gqos->qos, &rhost->stats) ;
-    unit2timer(alfa, &fresh) ;
-    timeradd(&rhost->stats.expected_arrival_ts, &fresh, &fresh) ;
+      alfa = gqos->qos->TdU - wei_sendint(gqos->qos, &rhost->stats) ;
+      unit2timer(alfa, &fresh) ;
+      timeradd(&rhost->stats.expected_arrival_ts, &fresh, &fresh) ;
 #endif
+    }
     
     trust_proc = malloc(sizeof(*trust_proc)) ;
     
@@ -520,7 +840,7 @@ static int build_proc_trust_list_group(unsigned int gid,
     trust_proc->host = rhost ;
     memcpy(&trust_proc->fresh, &fresh, sizeof(fresh)) ;
     
-    list_add(&trust_proc->trust_list, &lproc->tmp_tlist_head) ;
+    list_add_tail(&trust_proc->trust_list, &lproc->tmp_tlist_head) ;
   }
   retval = 0 ;
   out:
@@ -572,78 +892,123 @@ build_all_procs_trust_lists_all_groups(struct host_struct *rhost,
   return retval ;
 }
 
-/* does not compare hosts, already guaranteed to be the same
- * gid is also the same (not even present in trust_struct */
-static int trust_member(struct trust_struct *tproc,
-  struct list_head *trust_list) {
-  struct list_head *tmp ;
-  struct trust_struct *entry ;
-  
-  list_for_each(tmp, trust_list) {
-    entry = list_entry(tmp, struct trust_struct, trust_list) ;
-    if(entry->pid == tproc->pid) {
-      if(entry->gid == NULL || tproc->gid == NULL) {
-        if( entry->gid == tproc->gid )
-          return 1 ;
-      }
-      else {
-        if( (entry->gid->val) == (tproc->gid->val) )
-          return 1 ;
-      }
-    }
+/* does not compare hosts, already guaranteed to be the same. The trusts
+ of a local process for a host are kept in this order: the point to point
+ ones (no gid) first, then by group and by pid */
+static int trust_cmp(struct trust_struct *a, struct trust_struct *b) {
+  u_int gid_a, gid_b ;
+  
+  if(a->gid == NULL || b->gid == NULL) {
+    if(a->gid != b->gid)
+      return (a->gid == NULL) ? -1 : 1 ;
   }
+  else {
+    gid_a = a->gid->val ;
+    gid_b = b->gid->val ;
+    if(gid_a != gid_b)
+      return (gid_a > gid_b) - (gid_a < gid_b) ;
+  }
+  return (a->pid > b->pid) - (a->pid < b->pid) ;
+}
+
+/* sort a trust list with trust_cmp(). The lists are built in order, this
+ only costs a pass over them */
+static void trust_list_sort(struct list_head *list) {
+  struct list_head *tmp, *next, *pos ;
+  struct trust_struct *trust ;
+  
+  for(tmp = list->next ; tmp != list && tmp->next != list ; tmp = next) {
+    next = tmp->next ;
+    trust = list_entry(next, struct trust_struct, trust_list) ;
+    if(trust_cmp(list_entry(tmp, struct trust_struct, trust_list), trust) <= 0)
+      continue ;
+    
+    /* out of order: insert it back further up */
+    list_del(next) ;
+    for(pos = tmp->prev ; pos != list &&
+      trust_cmp(list_entry(pos, struct trust_struct, trust_list), trust) > 0 ;
+    pos = pos->prev) ;
+    list_add(next, pos) ;
+    next = tmp ;
+  }
+}
+
+/* a trust which could not be scheduled is dropped, as if it was suspected */
+static int commit_trust(struct localproc_struct *lproc,
+  struct trust_struct *trust, struct list_head *committed) {
+  if(sched_suspect(lproc, trust, &trust->fresh) < 0) {
+#ifdef OUTPUT
+    fprintf(stderr, "fdd: scheduling suspect event failed.") ;
+#endif
+    
+#ifdef LOG
+    fprintf(flog, "fdd: scheduling suspect event failed.") ;
+#endif
+    return -1 ;
+  }
+  list_add_tail(&trust->trust_list, committed) ;
   return 0 ;
 }
 
 /* commit the trust list. since now they were only temporar */
+/* The new trusts are merged with the ones of the remote host in order:
+ only the processes that came or went are notified, the others keep
+ their trust_struct with the new freshness point. */
 static void commit_proc_trust_list(struct localproc_struct *lproc,
   struct host_struct *rhost,
   struct timeval *arrival_ts) {
-  struct list_head *tmp_trust    = NULL ;
+  struct trust_struct *old_trust = NULL ;
   struct trust_struct *trust     = NULL ;
   struct list_head remove_list          ;
-  int error ;
+  struct list_head committed            ;
+  int cmp ;
+  
+  INIT_LIST_HEAD(&committed) ;
   
   /* move all the trust processes of the remote host in the remove_list */
   local_untrust_host(lproc, rhost, &remove_list);
-  
-  list_for_each(tmp_trust, &remove_list) {
-    trust = list_entry(tmp_trust, struct trust_struct, trust_list);
-    /* for each process which was trusted send a CRASH notification if
-     it does not pertain to the new list of trusted processes */
-    if(INTERRUPT_ANY_CHANGE == trust->int_type &&
-      !trust_member(trust, &lproc->tmp_tlist_head)) {
-      local_change_notify(lproc, CRASHED_NOTIF, trust, arrival_ts);
-    }
-  }
-  
-  while(!list_empty(&lproc->tmp_tlist_head)) {
-    trust = list_entry(lproc->tmp_tlist_head.next, struct trust_struct,
-    trust_list) ;
-    list_del(&trust->trust_list) ;
+  trust_list_sort(&remove_list) ;
+  trust_list_sort(&lproc->tmp_tlist_head) ;
+  
+  while(!list_empty(&remove_list) || !list_empty(&lproc->tmp_tlist_head)) {
+    old_trust = list_empty(&remove_list) ? NULL :
+    list_entry(remove_list.next, struct trust_struct, trust_list) ;
+    trust = list_empty(&lproc->tmp_tlist_head) ? NULL :
+    list_entry(lproc->tmp_tlist_head.next, struct trust_struct, trust_list) ;
     
-    /* schedule a suspect event for each nearly trusted remote process */
-    error = sched_suspect(lproc, trust, &trust->fresh) ;
+    cmp = (old_trust == NULL) ? 1 : (trust == NULL) ? -1 :
+    trust_cmp(old_trust, trust) ;
     
-    if(error < 0) {
-#ifdef OUTPUT
-      fprintf(stderr, "fdd: scheduling suspect event failed.") ;
-#endif
-      
-#ifdef LOG
-      fprintf(flog, "fdd: scheduling suspect event failed.") ;
-#endif
-      if(INTERRUPT_ANY_CHANGE == trust->int_type &&
-      trust_member(trust, &remove_list))
-      local_change_notify(lproc, CRASHED_NOTIF, trust, arrival_ts) ;
+    if(cmp < 0) {
+      /* it does not pertain to the new list of trusted processes:
+       send a CRASH notification */
+      list_del(&old_trust->trust_list) ;
+      if(INTERRUPT_ANY_CHANGE == old_trust->int_type)
+        local_change_notify(lproc, CRASHED_NOTIF, old_trust, arrival_ts);
+      free_trust(old_trust) ;
+    }
+    else if(cmp == 0) {
+      /* still trusted: only its freshness point moves */
+      list_del(&old_trust->trust_list) ;
+      list_del(&trust->trust_list) ;
+      old_trust->int_type = trust->int_type ;
+      memcpy(&old_trust->fresh, &trust->fresh, sizeof(trust->fresh)) ;
       free_trust(trust) ;
+      
+      if(commit_trust(lproc, old_trust, &committed) < 0) {
+        if(INTERRUPT_ANY_CHANGE == old_trust->int_type)
+          local_change_notify(lproc, CRASHED_NOTIF, old_trust, arrival_ts) ;
+        free_trust(old_trust) ;
+      }
     }
     else {
       /* this process was not in the previous list of trusted processes:
        send a TRUST notification to the client */
-      list_add(&trust->trust_list, &lproc->trust_list_head) ;
-      if( INTERRUPT_ANY_CHANGE == trust->int_type &&
-        !trust_member(trust, &remove_list) ) {
+      list_del(&trust->trust_list) ;
+      if(commit_trust(lproc, trust, &committed) < 0) {
+        free_trust(trust) ;
+      }
+      else if(INTERRUPT_ANY_CHANGE == trust->int_type) {
 #ifdef OUTPUT
         printf("Sending TRUST_NOTIF to %u, for %u on %u.%u.%u.%u\n",
           lproc->pid, trust->pid,
@@ -653,7 +1018,8 @@ static void commit_proc_trust_list(struct localproc_struct *lproc,
       }
     }
   }
-  list_splice(&remove_list, &lproc->tmp_tlist_head);
+  /* the trusts of the host stay together and in order */
+  list_splice(&committed, &lproc->trust_list_head) ;
 }
 
 /* test if a local process joined at least one of the joinlty groups of
@@ -699,6 +1065,8 @@ extern void remote_host_suspect(struct host_struct *host,
   struct trust_struct *trust     = NULL ;
   struct list_head remove_list          ;
   
+  metrics.host_suspects++ ;
+  trace_event(TRACE_HOST_SUSPECT, &host->addr, host->remote_epoch.tv_sec, 0, 0) ;
   
   list_for_each(tmp_lproc, &local_procs_list_head) {
     lproc = list_entry(tmp_lproc, struct localproc_struct, local_procs_list) ;
@@ -728,6 +1096,8 @@ extern void remote_host_suspect(struct host_struct *host,
   /* remove all the suspicion events on the remote groups of the
    remote host */
   remove_host_suspect_group(host) ;
+  /* the accusations queued for it are dropped with it */
+  remove_accusations_event(host) ;
   
   free_host(host) ;
   return ;
@@ -804,10 +1174,9 @@ extern struct host_struct *locate_create_host(struct sockaddr_in *addr,
 static unsigned int calc_groups_sendint(struct host_struct *rhost) {
   
   struct list_head *tmp_procgroup = NULL ;
-  struct list_head *tmp_lproc = NULL ;
+  struct list_head *tmp_member = NULL ;
   
   struct procgroup_struct *group = NULL ;
-  struct localproc_struct *lproc = NULL ;
   struct groupqos_struct *gqos = NULL ;
   
   /* the sendint value will be at most equal to a maximum value */
@@ -822,15 +1191,13 @@ static unsigned int calc_groups_sendint(struct host_struct *rhost) {
   list_for_each(tmp_procgroup, &rhost->list_remote_procs_in_groups_to_calc_eta) {
     group = list_entry(tmp_procgroup, struct procgroup_struct, pglist) ;
     
-    if (!is_in_ordered_list(group->gid, &local_groups_list_head))
+    if (!gset_test(&local_groups_set, group->gid))
       continue;
     else {
-      list_for_each(tmp_lproc, &local_procs_list_head) {
-        lproc = list_entry(tmp_lproc, struct localproc_struct,
-        local_procs_list) ;
+      list_for_each(tmp_member, local_group_members(group->gid)) {
+        gqos = list_entry(tmp_member, struct groupqos_struct, members_list) ;
         
-        gqos = locate_gqos(lproc, group->gid) ;
-        if(NULL == gqos || NULL == gqos->qos || gqos->qos->TdU == 0) {
+        if(NULL == gqos->qos || gqos->qos->TdU == 0) {
           continue ;
         }
         sendint1 = wei_sendint(gqos->qos, &rhost->stats) ;
@@ -895,6 +1262,9 @@ extern void recalc_needed_sendint(struct host_struct *rhost,
     sendint = MIN_SENDINT ;
   }
   
+  if(rhost->remote_needed_sendint != sendint)
+    trace_event(TRACE_SENDINT, &rhost->addr, rhost->remote_needed_sendint,
+    sendint, TRACE_SENDINT_REMOTE_NEEDED) ;
   rhost->remote_needed_sendint = sendint;
 }
 
@@ -926,7 +1296,7 @@ extern void remote_replay_host(struct localproc_struct *lproc,
   commit_proc_trust_list(lproc, host, now) ;
   
   out:
-  list_free(&lproc->tmp_tlist_head, struct trust_struct, trust_list) ;
+  trust_list_free(&lproc->tmp_tlist_head) ;
   
   if (retval < 0) {
 #ifdef OUTPUT
@@ -939,44 +1309,198 @@ extern void remote_replay_host(struct localproc_struct *lproc,
 }
 
 
-static inline int add_proc_group_list2list(u_int gid, struct list_head *list1, struct list_head *list2) {
+/* counts a report of which only some fragments arrived as an alive of
+ rhost: its header is in every fragment. The lists of processes stay the
+ ones of the last complete report. So a lost fragment is not taken as a
+ lost alive by the loss estimation. */
+static void remote_merge_alive(struct host_struct *rhost,
+  struct frag_struct *frag) {
+  int retval ;
+  
+  if(timercmp(&frag->thought_local_epoch, &local_epoch, !=) ||
+    timercmp(&frag->remote_epoch, &rhost->remote_epoch, !=))
+    goto out ;
   
-  struct list_head *tmp_head1, *tmp_head2;
-  struct procgroup_struct *procgroup1, *procgroup2, *entry_ptr;
+  if(rhost->stats.local_initial_finished != FINISHED_YES)
+    goto out ;
   
-  if (list_empty(list2)) {
-    list_for_each(tmp_head2, list1) {
-      procgroup1 = list_entry(tmp_head2, struct procgroup_struct, pglist);
-      
-      entry_ptr = malloc(sizeof(struct procgroup_struct));
-      if (entry_ptr == NULL)
-        return -1;
-      
-      entry_ptr->pid = procgroup1->pid;
-      entry_ptr->gid = procgroup1->gid;
-      list_add_tail(&entry_ptr->pglist, list2);
-    }
+  metrics.reports_rcvd++ ;
+  trace_event(TRACE_REPORT_RCVD, &rhost->addr, frag->seq, 0, frag->sendint) ;
+  
+  if(greater_than(rhost->stats.last_seq, frag->seq)) {
+    metrics.reports_out_of_order++ ;
+    trace_event(TRACE_REPORT_OOO, &rhost->addr, frag->seq,
+    rhost->stats.last_seq, 0) ;
+    stats_new_sample(rhost, frag->seq, &frag->sending_ts, &frag->arrival_ts,
+    frag->sendint) ;
+    goto out ;
   }
-  else {
-    list_for_each(tmp_head1, list2) {
-      procgroup2 = list_entry(tmp_head1, struct procgroup_struct, pglist);
-      
-      if (procgroup2->gid >= gid)
-        break;
-    }
-    list_for_each(tmp_head2, list1) {
-      procgroup1 = list_entry(tmp_head2, struct procgroup_struct, pglist);
-      
-      entry_ptr = malloc(sizeof(struct procgroup_struct));
-      if (entry_ptr == NULL)
-        return -1;
-      
-      entry_ptr->pid = procgroup1->pid;
-      entry_ptr->gid = procgroup1->gid;
-      list_add_tail(&entry_ptr->pglist, tmp_head1);
+  
+  rhost->stats.last_seq = frag->seq ;
+  stats_new_sample(rhost, frag->seq, &frag->sending_ts, &frag->arrival_ts,
+  frag->sendint) ;
+  
+  retval = build_trust_lists(rhost, &rhost->remote_servers_proc_head,
+  &frag->sending_ts, &frag->arrival_ts) ;
+  if(retval >= 0)
+    retval = build_all_procs_trust_lists_all_groups(rhost,
+      &rhost->remote_all_groups_procs_head,
+    &frag->sending_ts, &frag->arrival_ts) ;
+  if(retval >= 0) {
+    memcpy(&rhost->sending_ts, &frag->sending_ts, sizeof(rhost->sending_ts)) ;
+    commit_trust_lists(rhost, &frag->arrival_ts) ;
+  }
+  all_trust_lists_free() ;
+  
+  out:
+  return ;
+}
+
+/* gives up the reassembly of the report of rhost: a newer one arrived */
+static void frag_abandon(struct host_struct *rhost) {
+  remote_merge_alive(rhost, rhost->frag) ;
+  frag_free(rhost) ;
+}
+
+/* hands the omega accusations of a report, at ptr, to omega. The
+ section ends at end. */
+static void remote_merge_accusations(char *ptr, char *end,
+  struct sockaddr_in *raddr,
+  struct timeval *arrival_ts) {
+  unsigned int accusations_count ;
+  unsigned int gid ;
+  struct timeval startTime ;
+  
+  if(ptr + 4 > end)
+    return ;
+  ptr = msg_parse_rep_accusations_count(ptr, &accusations_count) ;
+  while(accusations_count-- && ptr + REP_ACCUSATION_LEN <= end) {
+    ptr = msg_parse_rep_accusation(ptr, &gid, &startTime) ;
+#ifdef OUTPUT
+    fprintf(stdout, "Received accusation from: %u.%u.%u.%u for gid: %u\n",
+    NIPQUAD(raddr), gid) ;
+#endif
+#ifdef LOG
+    fprintf(flog, "Received accusation from: %u.%u.%u.%u for gid: %u\n",
+    NIPQUAD(raddr), gid) ;
+#endif
+    doUponReceivedAccusation(gid, &startTime, arrival_ts) ;
+  }
+}
+
+/* merge a fragment of a report. Once all the fragments of the report are
+ there, it is merged as if it had been received whole. */
+extern void remote_frag_merge(char *msg, int msg_len,
+  struct sockaddr_in *raddr,
+  struct timeval *arrival_ts) {
+  char *ptr = NULL ;
+  struct host_struct *rhost = NULL ;
+  struct frag_struct *frag  = NULL ;
+  
+  unsigned int seq, frag_index, frag_count, report_len, remote_sendint ;
+  struct timeval sending_ts, remote_epoch, thought_local_epoch ;
+  int len ;
+  int retval ;
+  
+  retval = -EMSGSIZE ;
+  if(msg_len < REP_FRAG_HEAD_LEN)
+    goto out ;
+  
+  ptr = msg_parse_rep_frag_head(msg, &seq, &frag_index, &frag_count,
+    &report_len, &sending_ts, &remote_epoch, &thought_local_epoch,
+  &remote_sendint) ;
+  len = msg_len - REP_FRAG_HEAD_LEN ;
+  
+  if(frag_count == 0 || frag_count > REP_MAX_FRAGS ||
+    frag_index >= frag_count ||
+    report_len <= (frag_count - 1) * REP_FRAG_PAYLOAD ||
+    report_len > frag_count * REP_FRAG_PAYLOAD ||
+    len != min(REP_FRAG_PAYLOAD, report_len - frag_index * REP_FRAG_PAYLOAD))
+    goto out ;
+  
+  retval = 0 ;
+  /* hosts are created by the messages that are never fragmented */
+  rhost = locate_host(raddr) ;
+  if(NULL == rhost)
+    goto out ;
+  
+  frag = rhost->frag ;
+  if(frag && frag->seq != seq) {
+    if(!greater_than(seq, frag->seq)) /* late fragment of an older report */
+      goto out ;
+    frag_abandon(rhost) ;
+    frag = NULL ;
+  }
+  
+  if(NULL == frag) {
+    if(!greater_than(seq, rhost->stats.last_seq)) /* already counted */
+      goto out ;
+    
+    retval = -ENOMEM ;
+    frag = malloc(sizeof(*frag)) ;
+    if(NULL == frag)
+      goto out ;
+    frag->msg = malloc(report_len) ;
+    if(NULL == frag->msg) {
+      free(frag) ;
+      goto out ;
     }
+    frag->seq = seq ;
+    frag->frag_count = frag_count ;
+    frag->frags_rcvd = 0 ;
+    frag->len = report_len ;
+    memset(frag->rcvd, 0, sizeof(frag->rcvd)) ;
+    memcpy(&frag->sending_ts, &sending_ts, sizeof(sending_ts)) ;
+    memcpy(&frag->remote_epoch, &remote_epoch, sizeof(remote_epoch)) ;
+    memcpy(&frag->thought_local_epoch, &thought_local_epoch,
+    sizeof(thought_local_epoch)) ;
+    frag->sendint = remote_sendint ;
+    memcpy(&frag->arrival_ts, arrival_ts, sizeof(*arrival_ts)) ;
+    rhost->frag = frag ;
+  }
+  
+  retval = -EINVAL ;
+  if(frag->frag_count != frag_count || frag->len != report_len)
+    goto out ;
+  
+  retval = 0 ;
+  if(frag->rcvd[frag_index / 32] & (1u << (frag_index % 32))) /* duplicate */
+    goto out ;
+  frag->rcvd[frag_index / 32] |= 1u << (frag_index % 32) ;
+  frag->frags_rcvd++ ;
+  memcpy(frag->msg + frag_index * REP_FRAG_PAYLOAD, ptr, len) ;
+  
+  if(frag->frags_rcvd < frag->frag_count)
+    goto out ;
+  
+  /* complete: detach it before merging it. The report arrived with its
+   first fragment, as for an abandoned one (see frag_abandon()) */
+  rhost->frag = NULL ;
+  switch(msg_type(frag->msg)) {
+    case MSG_REPORT:
+    remote_merge(frag->msg, frag->len, raddr, &frag->arrival_ts) ;
+    break ;
+    
+    case MSG_REPORT_COMPACT:
+    remote_compact_merge(frag->msg, frag->len, raddr, &frag->arrival_ts) ;
+    break ;
+    
+    default:
+    retval = -EINVAL ;
+    break ;
+  }
+  free(frag->msg) ;
+  free(frag) ;
+  
+  out:
+  if (retval < 0) {
+#ifdef OUTPUT
+    fprintf(stderr, "fdd: remote_frag_merge failed\n") ;
+#endif
+#ifdef LOG
+    fprintf(flog, "fdd: remote_frag_merge failed\n") ;
+#endif
   }
-  return 0;
 }
 
 
@@ -1013,10 +1537,15 @@ extern void remote_merge(char *msg, int msg_len,
   
   unsigned int   eta_rcvd = 0 ;
   
-  struct list_head remote_all_groups_procs_list ;
-  struct list_head remote_group_procs_list ;
-  struct list_head remote_servers_proc_list ;
-  struct list_head local_servers_proc_list ;
+  char *ptr_delta = NULL ;
+  unsigned int   omitted = 0 ;
+  unsigned int   acked_seq[REP_LISTS] ;
+  
+  struct pid_view remote_servers_view ;
+  struct pid_view local_servers_view ;
+  struct pg_view groups_view ;
+  struct list_head spare_uint_list ;
+  struct list_head spare_procgroup_list ;
   struct list_head *tmp_head;
   struct uint_struct *group;
   
@@ -1040,10 +1569,8 @@ extern void remote_merge(char *msg, int msg_len,
   int delta ;
 #endif
   
-  INIT_LIST_HEAD(&remote_servers_proc_list) ;
-  INIT_LIST_HEAD(&remote_all_groups_procs_list) ;
-  INIT_LIST_HEAD(&remote_group_procs_list) ;
-  INIT_LIST_HEAD(&local_servers_proc_list) ;
+  INIT_LIST_HEAD(&spare_uint_list) ;
+  INIT_LIST_HEAD(&spare_procgroup_list) ;
   
   ptr_head = msg ;
   ptr_remote_servers =
@@ -1067,10 +1594,14 @@ extern void remote_merge(char *msg, int msg_len,
   
   
   retval = -EMSGSIZE ;
-  if(ptr_remote_servers > msg + MAX_MSG_LEN) {
+  if(ptr_remote_servers > msg + msg_len) {
     goto out ;
   }
   
+  retval = arena_reserve(&merge_arena, MERGE_ARENA_SIZE(msg_len)) ;
+  if(retval < 0)
+    goto out ;
+  
   retval = 0 ;
   if(timercmp(&thought_local_epoch, &local_epoch, <)) {
     /* message sent for the previos life of the FDD */
@@ -1099,6 +1630,13 @@ extern void remote_merge(char *msg, int msg_len,
   if(NULL == rhost)
     goto out ;
   
+  /* an older report still waiting for fragments will not complete */
+  if(rhost->frag && greater_than(seq, rhost->frag->seq))
+    frag_abandon(rhost) ;
+  
+  metrics.reports_rcvd++ ;
+  trace_event(TRACE_REPORT_RCVD, raddr, seq, msg_len, remote_sendint) ;
+  
   
   retval = 0 ;
   /* received a message before having computed the initial value of
@@ -1151,51 +1689,62 @@ extern void remote_merge(char *msg, int msg_len,
   rhost->stats.last_seq, seq) ;
 #endif
   
+  /* the accusations count even in an out of order report */
+  ptr_delta = ptr_remote_servers + remote_servers_list_len +
+  local_servers_list_len + remotevars_count * REP_LOCALVARS_LEN ;
+  if(ptr_delta + REP_DELTA_LEN < msg + msg_len)
+    remote_merge_accusations(ptr_delta + REP_DELTA_LEN, msg + msg_len,
+    raddr, arrival_ts) ;
+  
   retval = 0 ;
   if( timercmp(&rhost->remote_epoch, &remote_epoch, >)
     || greater_than(rhost->stats.last_seq, seq) ) {
     /* message sent before the host's crash or out of order message */
-    
-#ifdef OUTPUT
-    fprintf(stdout, "REPORT_OUT_OF_ORDER: prev_seq=%u, seq=%u\n",
-    rhost->stats.last_seq, seq) ;
-#endif
-#ifdef LOG
-    fprintf(flog, "REPORT_OUT_OF_ORDER: prev_seq=%u, seq=%u\n",
-    rhost->stats.last_seq, seq) ;
-#endif
+    metrics.reports_out_of_order++ ;
+    trace_event(TRACE_REPORT_OOO, raddr, seq, rhost->stats.last_seq, 0) ;
     /* compute the new statistics */
     stats_new_sample(rhost, seq, &sending_ts, arrival_ts, remote_sendint ) ;
     goto out;
   }
   
+  /* the lists left out are the ones we already have. An ack going
+   backwards is taken too: the host lost the lists (it restarted, or
+   recreated us after a suspicion) and they must be sent again. */
+  if(ptr_delta + REP_DELTA_LEN <= msg + msg_len) {
+    msg_parse_rep_delta(ptr_delta, &omitted, acked_seq) ;
+    for(i = 0 ; i < REP_LISTS ; i++)
+      rhost->lists_acked_seq[i] = acked_seq[i] ;
+  }
+  
   /* parse the list of requested local servers */
-  if(rhost->remote_clients_list_seq != remote_clients_list_seq) {
+  if(!(omitted & (1 << REP_LIST_CLIENTS)) &&
+    rhost->remote_clients_list_seq != remote_clients_list_seq) {
     rhost->local_servers_list_seq++ ;
     new_remote_clients = 1 ;
     ptr_local_servers = ptr_remote_servers + remote_servers_list_len ;
     retval = -EMSGSIZE ;
-    if(ptr_local_servers > msg + MAX_MSG_LEN)
+    if(ptr_local_servers > msg + msg_len)
       goto out ;
     
-    parse_proc_list(msg, ptr_local_servers, local_servers_proc_count,
-    &local_servers_proc_list, &retval) ;
+    parse_pid_view(msg + msg_len, ptr_local_servers, local_servers_proc_count,
+    &local_servers_view, &retval) ;
     
     if( retval < 0 )
-      goto out_free_proc_list ;
+      goto out ;
   }
   
   
   /* parse the list of remote servers */
-  if( rhost->last_local_clients_list_seq == rhost->local_clients_list_seq &&
-    rhost->remote_servers_list_seq == remote_servers_list_seq) {
+  if( (omitted & (1 << REP_LIST_SERVERS)) ||
+    (rhost->last_local_clients_list_seq == rhost->local_clients_list_seq &&
+    rhost->remote_servers_list_seq == remote_servers_list_seq)) {
   }
   else {
     new_remote_servers = 1 ;
-    ptr = parse_proc_list(msg, ptr_remote_servers, remote_servers_proc_count,
-    &remote_servers_proc_list, &retval) ;
+    ptr = parse_pid_view(msg + msg_len, ptr_remote_servers, remote_servers_proc_count,
+    &remote_servers_view, &retval) ;
     if(retval < 0)
-      goto out_free_proc_list ;
+      goto out ;
   }
   
   ptr = ptr_remote_servers + remote_servers_proc_count * sizeof(int) ;
@@ -1226,21 +1775,34 @@ extern void remote_merge(char *msg, int msg_len,
   
   
   /* parse the groups */
-  if(
+  if((omitted & (1 << REP_LIST_GROUPS)) == 0 && (
 #ifndef SYNCH_CLOCKS
     1 ||
 #endif
-    !greater_than(rhost->remote_groups_list_seq, remote_groups_list_seq)) {
+    !greater_than(rhost->remote_groups_list_seq, remote_groups_list_seq))) {
     struct uint_struct *entry_ptr ;
     int entry_exists ;
     
     new_remote_groups = 1 ;
     
-    list_free(&rhost->list_remote_procs_in_groups_to_calc_eta,
-    struct procgroup_struct, pglist);
-    
+    /* room for all the pids left in the message */
+    groups_view.count = 0 ;
+    groups_view.pairs = NULL ;
+    retval = -EMSGSIZE ;
+    if(ptr > msg + msg_len)
+      goto out ;
+    retval = -ENOMEM ;
+    if(ptr < msg + msg_len) {
+      groups_view.pairs = arena_alloc(&merge_arena, (msg + msg_len - ptr) /
+      REP_PID_LEN * sizeof(*groups_view.pairs)) ;
+      if(groups_view.pairs == NULL)
+        goto out ;
+    }
     
     for(i = 0 ; i < remote_groups_count ; i++) {
+      retval = -EMSGSIZE ;
+      if(ptr + REP_GHEAD_LEN > msg + msg_len)
+        goto out ;
       ptr = msg_parse_rep_ghead(ptr, &gid, &group_ts, &eta_rcvd, &procs_count) ;
       
       /* keep the largest group ts of this host */
@@ -1252,38 +1814,82 @@ extern void remote_merge(char *msg, int msg_len,
       list_insert_ordered(gid, val, &rhost->remote_all_groups_head,
       struct uint_struct, uint_list, <) ;
       if(entry_ptr == NULL)
-        goto out_free_proc_list ;
+        goto out ;
       
       retval = sched_suspect_remote_group(rhost, entry_ptr, arrival_ts) ;
       if(retval < 0)
-        goto out_free_proc_list ;
+        goto out ;
       
-      ptr = parse_group_procs_list(msg, ptr, raddr, gid, procs_count,
-      &remote_group_procs_list, eta_rcvd, &retval, arrival_ts) ;
+      ptr = parse_group_procs_list(msg + msg_len, ptr, raddr, gid, procs_count,
+      &groups_view, eta_rcvd, &retval, arrival_ts) ;
+      if(retval < 0)
+        goto out ;
       
-      if (eta_rcvd) {
-        if (add_proc_group_list2list(gid, &remote_group_procs_list,
-          &remote_all_groups_procs_list) < 0) {
-          fprintf(stderr, "fdd: Error in remote_merge while merging current proc_group");
-          fprintf(stderr, "list with the one received\n");
-        }
-      }
       /* If we received at least one group with eta_rcvd = false it means
        that we must send a report containing the eta. */
-      else
+      if (!eta_rcvd)
         send_back_eta = 1;
-      
-      list_splice(&remote_group_procs_list, &rhost->list_remote_procs_in_groups_to_calc_eta) ;
-      
-      INIT_LIST_HEAD(&remote_group_procs_list) ;
     }
+    pg_view_normalize(&groups_view) ;
+    
     retval = build_jointly_groups_list(rhost,
     &rhost->remote_all_groups_head) ;
     if(retval < 0)
-      goto out_free_proc_list ;
+      goto out ;
   }
   else {
     new_remote_groups = 0 ;
+    if(omitted & (1 << REP_LIST_GROUPS))
+      refresh_group_contenders(rhost) ;
+  }
+  
+  /* the entries of the processes that came in the lists of the report */
+  retval = -ENOMEM ;
+  if( new_remote_servers &&
+    spare_uints(&spare_uint_list, pid_list_missing(
+    &rhost->remote_servers_proc_head, &remote_servers_view)) < 0 )
+  goto out ;
+  if( new_remote_clients &&
+    spare_uints(&spare_uint_list, pid_list_missing(
+    &rhost->local_servers_proc_head, &local_servers_view)) < 0 )
+  goto out ;
+  if( new_remote_groups &&
+    (spare_procgroups(&spare_procgroup_list, pg_list_missing(
+    &rhost->remote_all_groups_procs_head, &groups_view, 1)) < 0 ||
+    spare_procgroups(&spare_procgroup_list, pg_list_missing(
+    &rhost->list_remote_procs_in_groups_to_calc_eta, &groups_view, 0)) < 0) )
+  goto out ;
+  
+  /* we can't fail anymore, can commit the lists of this message: only
+   the processes that came or went are touched */
+  if( new_remote_servers )
+    pid_list_sync(&rhost->remote_servers_proc_head, &remote_servers_view,
+  &spare_uint_list) ;
+  
+  if( new_remote_groups ) {
+    pg_list_sync(&rhost->remote_all_groups_procs_head, &groups_view, 1,
+    &spare_procgroup_list) ;
+    pg_list_sync(&rhost->list_remote_procs_in_groups_to_calc_eta,
+    &groups_view, 0, &spare_procgroup_list) ;
+  }
+  
+  if( new_remote_clients )
+    pid_list_sync(&rhost->local_servers_proc_head, &local_servers_view,
+  &spare_uint_list) ;
+  
+  if(!(omitted & (1 << REP_LIST_SERVERS))) {
+    rhost->remote_servers_list_seq = remote_servers_list_seq ;
+    rhost->last_local_clients_list_seq = rhost->local_clients_list_seq ;
+    rhost->lists_applied_seq[REP_LIST_SERVERS] = seq ;
+  }
+  if(!(omitted & (1 << REP_LIST_CLIENTS))) {
+    rhost->remote_clients_list_seq = remote_clients_list_seq ;
+    rhost->lists_applied_seq[REP_LIST_CLIENTS] = seq ;
+  }
+  
+  if(new_remote_groups) {
+    rhost->remote_groups_list_seq = remote_groups_list_seq ;
+    rhost->lists_applied_seq[REP_LIST_GROUPS] = seq ;
   }
   
   if(remote_sendint != rhost->remote_actual_sendint) {
@@ -1293,23 +1899,12 @@ extern void remote_merge(char *msg, int msg_len,
   rhost->stats.last_seq = seq ;
   stats_new_sample(rhost, seq, &sending_ts, arrival_ts, remote_sendint ) ;
   
-  if( new_remote_servers )
-  retval = build_trust_lists(rhost, &remote_servers_proc_list,
-  &sending_ts, arrival_ts) ;
-  else
   retval = build_trust_lists(rhost, &rhost->remote_servers_proc_head,
   &sending_ts, arrival_ts) ;
   if(retval < 0)
     goto out_free_trust_lists ;
   
-  if( new_remote_groups )
-    retval =
-  build_all_procs_trust_lists_all_groups(rhost,
-    &remote_all_groups_procs_list,
-  &sending_ts, arrival_ts) ;
-  else
-    retval =
-  build_all_procs_trust_lists_all_groups(rhost,
+  retval = build_all_procs_trust_lists_all_groups(rhost,
     &rhost->remote_all_groups_procs_head,
   &sending_ts, arrival_ts) ;
   if(retval < 0)
@@ -1320,41 +1915,21 @@ extern void remote_merge(char *msg, int msg_len,
   
   /* Added for Omega*/
   /* Parse the remotevars list received and insert them in the remotevars list */
-  parse_and_insert_remotevars_list(msg, ptr, remotevars_count, raddr, &retval);
+  parse_and_insert_remotevars_list(msg + msg_len, ptr, remotevars_count, raddr, &retval);
   
   if (retval < 0)
-    goto out;
-  
-  if (remotevars_count != 0) {
-    if (updateGlobalLeaders(arrival_ts) < 0)
-      fprintf(stderr, "fdd Upon received alive: Error while updating global leaders\n");
-  }
-  
-  
-  /* we can't fail anymore, can commit changes by this message */
-  /* switch list heads so that the old one will be freed further down */
-  if( new_remote_servers )
-    list_swap(&rhost->remote_servers_proc_head, &remote_servers_proc_list) ;
-  
-  if( new_remote_groups )
-  list_swap(&rhost->remote_all_groups_procs_head,
-  &remote_all_groups_procs_list) ;
+    goto out_free_trust_lists;
   
-  if( new_remote_clients )
-    list_swap(&rhost->local_servers_proc_head, &local_servers_proc_list) ;
+  /* the leaders of the groups marked dirty above are recomputed once at
+   the end of the loop iteration, see updateDirtyGlobalLeaders() */
   
   memcpy(&rhost->sending_ts, &sending_ts, sizeof(sending_ts)) ;
-  rhost->stats.last_seq = seq ;
-  
-  rhost->remote_servers_list_seq = remote_servers_list_seq ;
-  rhost->last_local_clients_list_seq = rhost->local_clients_list_seq ;
-  rhost->remote_clients_list_seq = remote_clients_list_seq ;
-  
-  if(new_remote_groups)
-    rhost->remote_groups_list_seq = remote_groups_list_seq ;
   
   //  rhost->remote_actual_sendint = remote_sendint ;
   
+  if(rhost->local_needed_sendint != local_needed_sendint)
+    trace_event(TRACE_SENDINT, raddr, rhost->local_needed_sendint,
+    local_needed_sendint, TRACE_SENDINT_LOCAL_NEEDED) ;
   rhost->local_needed_sendint = local_needed_sendint;
   recalc_needed_sendint(rhost, arrival_ts) ;
   
@@ -1391,14 +1966,10 @@ extern void remote_merge(char *msg, int msg_len,
   out_free_trust_lists:
   all_trust_lists_free() ;
   
-  out_free_proc_list:
-  list_free(&remote_group_procs_list, struct procgroup_struct, pglist) ;
-  list_free(&remote_all_groups_procs_list, struct procgroup_struct, pglist) ;
-  list_free(&remote_servers_proc_list, struct uint_struct, uint_list) ;
-  list_free(&local_servers_proc_list, struct uint_struct, uint_list) ;
-  //  list_free(&remote_groups, struct uint_struct, uint_list) ;
-  
   out:
+  list_free(&spare_uint_list, struct uint_struct, uint_list) ;
+  list_free(&spare_procgroup_list, struct procgroup_struct, pglist) ;
+  arena_reset(&merge_arena) ;
   if (retval < 0) {
 #ifdef OUTPUT
     fprintf(stderr, "fdd: remote_merge failed\n") ;
@@ -1409,6 +1980,148 @@ extern void remote_merge(char *msg, int msg_len,
   }
 }
 
+/* merge a report in the compact wire format: it is converted back to the
+ fixed format. The sender understands the compact format from now on. */
+extern void remote_compact_merge(char *msg, int msg_len,
+  struct sockaddr_in *raddr,
+  struct timeval *arrival_ts) {
+  static char rep[REP_MAX_LEN + 24] ;
+  struct host_struct *rhost = NULL ;
+  int rep_len ;
+  
+  rep_len = msg_expand_report(msg, msg_len, rep, REP_MAX_LEN) ;
+  if(rep_len < 0) {
+#ifdef OUTPUT
+    fprintf(stderr, "fdd: bad compact report from %u.%u.%u.%u\n", NIPQUAD(raddr)) ;
+#endif
+#ifdef LOG
+    fprintf(flog, "fdd: bad compact report from %u.%u.%u.%u\n", NIPQUAD(raddr)) ;
+#endif
+    goto out ;
+  }
+  
+  remote_merge(rep, rep_len, raddr, arrival_ts) ;
+  
+  rhost = locate_host(raddr) ;
+  if(rhost && rhost->wire_version < WIRE_VERSION_COMPACT)
+    rhost->wire_version = WIRE_VERSION_COMPACT ;
+  
+  out:
+  return ;
+}
+
+/* merge the alive multicast of a remote host. The report the host would
+ have sent us is rebuilt from our section of the message and its shared
+ part, leaving out the lists of servers only sent by its unicast reports
+ so that ours are kept, and handed to remote_merge(). The groups list
+ has its own seq. nb., remote_groups_alive_list_seq: the list is left out
+ too when it is not newer than the last one applied. */
+extern void remote_alive_multicast_merge(char *msg, int msg_len,
+  struct sockaddr_in *raddr,
+  struct timeval *arrival_ts) {
+  char rep[SAFE_MSG_LEN] ;
+  char *ptr        = NULL ;
+  char *ptr_groups = NULL ;
+  char *ptr_rep    = NULL ;
+  
+  struct host_struct *rhost = NULL ;
+  struct sockaddr_in addr ;
+  
+  struct timeval sending_ts ;
+  struct timeval remote_epoch ;
+  struct timeval thought_local_epoch ;
+  struct timeval local_largest_group_ts_rcvd ;
+  
+  unsigned int remote_groups_list_seq = 0 ;
+  unsigned int remote_groups_count    = 0 ;
+  unsigned int remote_groups_len      = 0 ;
+  unsigned int remotevars_count       = 0 ;
+  unsigned int sections_count         = 0 ;
+  unsigned int seq                    = 0 ;
+  unsigned int remote_sendint         = 0 ;
+  unsigned int local_needed_sendint   = 0 ;
+  unsigned int groups_list_seq ;
+  unsigned int omitted ;
+  int shared_len ;
+  int new_groups ;
+  int i ;
+  
+  ptr_groups = msg_parse_alive_multicast_head(msg, &sending_ts, &remote_epoch,
+    &remote_groups_list_seq, &remote_groups_count,
+  &remote_groups_len, &remotevars_count, &sections_count) ;
+  
+  shared_len = remote_groups_len + remotevars_count * REP_LOCALVARS_LEN ;
+  if(ptr_groups + shared_len > msg + msg_len)
+    goto out ;
+  
+  /* look for our section */
+  ptr = ptr_groups + shared_len ;
+  for(i = 0 ; i < sections_count ; i++) {
+    if(ptr + ALIVE_MULTICAST_SECTION_LEN > msg + msg_len)
+      goto out ;
+    ptr = msg_parse_alive_multicast_section(ptr, &addr, &seq, &remote_sendint,
+      &local_needed_sendint, &thought_local_epoch,
+    &local_largest_group_ts_rcvd) ;
+    if(sockaddr_eq(&addr, &fdd_local_addr))
+      break ;
+  }
+  if(i == sections_count)
+    goto out ;
+  
+  /* hosts are created, and restarted hosts recreated, by the unicast reports */
+  rhost = locate_host(raddr) ;
+  if(NULL == rhost || timercmp(&rhost->remote_epoch, &remote_epoch, !=))
+    goto out ;
+  
+  /* remote_merge() takes a groups list newer than the one of the unicast
+   reports, whose seq. nb. is put back afterwards */
+  new_groups = !greater_than(rhost->remote_groups_alive_list_seq,
+  remote_groups_list_seq) ;
+  omitted = (1 << REP_LIST_SERVERS) | (1 << REP_LIST_CLIENTS) ;
+  groups_list_seq = rhost->remote_groups_list_seq ;
+  if(new_groups)
+    groups_list_seq++ ;
+  else {
+    omitted |= (1 << REP_LIST_GROUPS) ;
+    ptr_groups += remote_groups_len ;
+    shared_len -= remote_groups_len ;
+    remote_groups_len = 0 ;
+    remote_groups_count = 0 ;
+  }
+  
+  ptr_rep = msg_skip_rep_head(rep) ;
+  if(ptr_rep + shared_len + REP_DELTA_LEN > rep + MAX_MSG_LEN)
+    goto out ;
+  memcpy(ptr_rep, ptr_groups, shared_len) ;
+  ptr_rep += shared_len ;
+  ptr_rep = msg_build_rep_delta(ptr_rep, omitted, rhost->lists_acked_seq) ;
+  
+  msg_build_rep_head(rep, &sending_ts, seq, &remote_epoch, &thought_local_epoch,
+    
+    rhost->remote_servers_list_seq, groups_list_seq,
+    remote_groups_len, 0, remote_groups_count, remote_sendint,
+    remotevars_count,
+    
+    rhost->remote_clients_list_seq, 0, 0, local_needed_sendint,
+  &local_largest_group_ts_rcvd) ;
+  
+  remote_merge(rep, ptr_rep - rep, raddr, arrival_ts) ;
+  
+  if(!new_groups)
+    goto out ;
+  rhost = locate_host(raddr) ;
+  if(NULL == rhost || timercmp(&rhost->remote_epoch, &remote_epoch, !=))
+    goto out ;
+  if(rhost->remote_groups_list_seq == groups_list_seq) {
+    /* applied */
+    rhost->remote_groups_list_seq = groups_list_seq - 1 ;
+    rhost->remote_groups_alive_list_seq = remote_groups_list_seq ;
+  }
+  
+  out:
+  return ;
+}
+
 extern void show_host(struct list_head *mng_hosts, int n) {
   struct host_struct *host = NULL ;
   
@@ -33,25 +33,24 @@
 /* imported stuff */
 extern FILE *flog;
 extern struct list_head local_procs_list_head ;
+extern struct gset local_monitored_groups_set ;
 
 LIST_HEAD(event_list_head);
 
-/* add a new event in the list */
-static int add_event(int type, struct localproc_struct *lproc,
+/* insert a new event in the list, returns it or NULL if out of memory */
+static struct event_struct *insert_event(int type, struct localproc_struct *lproc,
   struct trust_struct *tproc, struct delay_struct *delay,
   struct host_struct *host,
   struct uint_struct *remote_group,
-  struct timeval *tv) {
+  fdd_ns_t due_ns) {
   struct list_head *tmp       = NULL ;
   struct event_struct *event  = NULL ;
   struct event_struct *event1 = NULL ;
-  int retval ;
   
   /* create the event object */
   event = malloc(sizeof(*event)) ;
-  retval = -ENOMEM ;
   if(event == NULL)
-    goto out ;
+    return NULL ;
   
   /* sets the event's object fields */
   event->type = type ;
@@ -62,19 +61,42 @@ static int add_event(int type, struct localproc_struct *lproc,
   event->host = host ;
   event->remote_group = remote_group ;
   
-  /* set the event's schedule time */
-  memcpy(&event->tv, tv, sizeof(event->tv)) ;
+  event->due_ns = due_ns ;
   
   list_for_each(tmp, &event_list_head) {
     event1 = list_entry(tmp, struct event_struct, event_list) ;
-    if(!timercmp(&event->tv, &event1->tv, >))
+    if(event->due_ns <= event1->due_ns)
       break ;
   }
   
   list_add_tail(&event->event_list, tmp);
-  retval = 0;
-  out:
-  return retval;
+  return event ;
+}
+
+/* add a new event in the list */
+static int add_event(int type, struct localproc_struct *lproc,
+  struct trust_struct *tproc, struct delay_struct *delay,
+  struct host_struct *host,
+  struct uint_struct *remote_group,
+  struct timeval *tv) {
+  /* the deadlines given here are computed from wall clock times, the
+   queue is kept in monotonic time */
+  if(insert_event(type, lproc, tproc, delay, host, remote_group,
+    wall2mono_ns(tv)) == NULL)
+    return -ENOMEM ;
+  return 0 ;
+}
+
+/* add the report event of the host, replacing the pending one */
+static int add_report_event(struct host_struct *host, fdd_ns_t due_ns) {
+  
+  remove_report_event(host) ;
+  
+  host->report_event = insert_event(EVENT_REPORT, NULL, NULL, NULL, host,
+  NULL, due_ns) ;
+  if(host->report_event == NULL)
+    return -ENOMEM ;
+  return 0 ;
 }
 
 /* remove the event associated with the sending of
@@ -96,18 +118,25 @@ static void sched_remove_hello_multicast_event() {
 
 /* removes the report event for the host */
 extern void remove_report_event(struct host_struct *host) {
+  
+  if(host->report_event == NULL)
+    return ;
+  list_del(&host->report_event->event_list) ;
+  free(host->report_event) ;
+  host->report_event = NULL ;
+}
+
+/* removes the event flushing the accusations queued for the host */
+extern void remove_accusations_event(struct host_struct *host) {
   struct list_head *tmp       = NULL ;
   struct event_struct *event  = NULL ;
   
   list_for_each(tmp, &event_list_head) {
     event = list_entry(tmp, struct event_struct, event_list) ;
-    if(event->type == EVENT_REPORT) {
-      if (event->host == host) {
-        tmp = tmp->prev ;
-        list_del(&event->event_list) ;
-        free(event) ;
-        return ;
-      }
+    if(event->type == EVENT_ACCUSATIONS && event->host == host) {
+      list_del(&event->event_list) ;
+      free(event) ;
+      return ;
     }
   }
 }
@@ -174,45 +203,16 @@ extern int sched_initial_ed_event(struct host_struct *host,
 /* Added for Omega */
 /* Returns true if there is a report event in the event list for a particular
  host concerning a particular group */
-extern int exists_report_in_event_list(struct sockaddr_in *raddr, u_int gid) {
-  struct event_struct *event;
-  struct list_head *tmp_event;
-  struct host_struct *host;
-  struct list_head *tmp_lproc;
-  struct localproc_struct *lproc;
-  struct list_head *tmp_groupqos;
-  struct groupqos_struct *groupqos;
-  
-  list_for_each(tmp_event, &event_list_head) {
-    event = list_entry(tmp_event, struct event_struct, event_list);
-    if (event->type == EVENT_REPORT) {
-      host = event->host;
-      if ((&host->addr) == NULL)
-        continue;
-      else if (sockaddr_eq(&host->addr, raddr)) {
-        list_for_each(tmp_lproc, &local_procs_list_head) {
-          lproc = list_entry(tmp_lproc, struct localproc_struct, local_procs_list);
-          list_for_each(tmp_groupqos, &lproc->gqlist_head) {
-            groupqos = list_entry(tmp_groupqos, struct groupqos_struct, gqlist);
-            if ((groupqos->qos != NULL) && (groupqos->gid == gid))
-              return 1;
-          }
-        }
-        return 0; /* There's only one report event per host in the event list */
-      }
-    }
-  }
-  return 0;
+extern int exists_report_in_event_list(struct host_struct *host, u_int gid) {
+  return host->report_event != NULL &&
+  gset_test(&local_monitored_groups_set, gid);
 }
 
 /* sched_report - schedule a report message now! */
 /* insert an EVENT_REPORT in the list of reports */
 extern int sched_report_now(struct host_struct *host, struct timeval *now) {
   
-  remove_report_event(host);
-  
-  return add_event(EVENT_REPORT, NULL, NULL, NULL, host, NULL,
-  now) ;
+  return add_report_event(host, wall2mono_ns(now)) ;
 }
 
 
@@ -220,9 +220,8 @@ extern int sched_report_now(struct host_struct *host, struct timeval *now) {
 /* insert an EVENT_REPORT in the list of reports */
 extern int sched_report(struct host_struct *host) {
   
-  struct timeval next_report, now, largest_jointly_group_ts;
-  
-  remove_report_event(host);
+  struct timeval largest_jointly_group_ts;
+  fdd_ns_t next_report;
   
   /* If we aren't done with the initial estimation of the quality of the link
    or there are no jointly groups, we schedule the report normally. */
@@ -234,28 +233,21 @@ extern int sched_report(struct host_struct *host) {
      This enables the monitoring to start even in case of msg loss. */
     if (timercmp(&largest_jointly_group_ts, &host->local_largest_group_ts_rcvd, ==) ||
       timercmp(&largest_jointly_group_ts, &host->local_largest_group_ts_rcvd, <)) {
-      return add_event(EVENT_REPORT, NULL, NULL, NULL, host, NULL,
-      &host->next_report_ts);
+      return add_report_event(host, host->next_report_ns);
     }
     else {
-      gettimeofday(&now, NULL);
-      
       /* schedule a report in 50 ms */
-      unit2timer(50, &next_report);
-      timeradd(&now, &next_report, &next_report);
+      next_report = mono_ns() + unit2ns(50);
       
-      if(timercmp(&next_report, &host->next_report_ts, <)) {
-        return add_event(EVENT_REPORT, NULL, NULL, NULL, host, NULL,
-        &next_report);
+      if(next_report < host->next_report_ns) {
+        return add_report_event(host, next_report);
       }
       else
-      return add_event(EVENT_REPORT, NULL, NULL, NULL, host, NULL,
-      &host->next_report_ts);
+      return add_report_event(host, host->next_report_ns);
     }
   }
   else
-  return add_event(EVENT_REPORT, NULL, NULL, NULL, host, NULL,
-  &host->next_report_ts);
+  return add_report_event(host, host->next_report_ns);
 }
 
 
@@ -263,14 +255,8 @@ extern int sched_report(struct host_struct *host) {
 /* insert an EVENT_REPORT in the list of reports delta_t milliseconds after now. */
 extern int sched_report_a_bit_later(struct host_struct *host, struct timeval *now,
   u_int delta_t) {
-  struct timeval tv;
-  
-  remove_report_event(host);
   
-  unit2timer(delta_t, &tv);
-  timeradd(now, &tv, &tv);
-  return add_event(EVENT_REPORT, NULL, NULL, NULL, host, NULL,
-  &tv) ;
+  return add_report_event(host, wall2mono_ns(now) + unit2ns(delta_t)) ;
 }
 
 
@@ -311,6 +297,15 @@ extern int sched_hello_multicast(struct timeval *now_hello, u_int when_hello) {
   return add_event(EVENT_HELLO, NULL, NULL, NULL, NULL, NULL, &when_hello_time) ;
 }
 
+/* schedule the next alive multicast sendint after now */
+extern int sched_alive_multicast(struct timeval *now, u_int sendint) {
+  struct timeval when ;
+  
+  unit2timer(sendint, &when) ;
+  timeradd(now, &when, &when) ;
+  return add_event(EVENT_MCAST_ALIVE, NULL, NULL, NULL, NULL, NULL, &when) ;
+}
+
 /* remove the suspicion of the appartenence of all groups to a host */
 extern void remove_host_suspect_group(struct host_struct *host) {
   
@@ -350,6 +345,18 @@ static void remove_suspect_remote_group(struct host_struct *host,
   }
 }
 
+/* schedule the sending of the accusations queued for the host in one
+ datagram, ACCUSATION_FLUSH_DELAY after now */
+extern int sched_accusations(struct host_struct *host, struct timeval *now) {
+  struct timeval when ;
+  
+  unit2timer(ACCUSATION_FLUSH_DELAY, &when) ;
+  timeradd(now, &when, &when) ;
+  
+  remove_accusations_event(host) ;
+  return add_event(EVENT_ACCUSATIONS, NULL, NULL, NULL, host, NULL, &when) ;
+}
+
 /* schedule a suspicion of the appartenence of a group to a remote host */
 extern int sched_suspect_remote_group(struct host_struct *host,
   struct uint_struct *remote_group,
@@ -371,18 +378,24 @@ extern void fd_sched_run(struct timeval *timeout,
   struct list_head *tmp       = NULL ;
   struct event_struct *event  = NULL ;
   int type ;
+  fdd_ns_t mono_now = mono_ns() ;
+  u_int64_t run_start_ns = metrics_now_ns() ;
   
   
   /* processing the events from the event list */
   while((tmp = head->next) != head) {
     event = list_entry(tmp, struct event_struct, event_list) ;
-    if(timercmp(now, &event->tv, <))
+    if(mono_now < event->due_ns)
       break ;
     
+    metrics_hist_add(&metrics.sched_lateness, mono_now - event->due_ns) ;
+    metrics.events_dispatched++ ;
+    
     type = event->type ;
     event->type = EVENT_NONE ; /* prevent it from being deleted */
     switch(type) {
       case EVENT_REPORT: /* has to send a report event */
+        event->host->report_event = NULL ;
         local_send_report_host(event->host, now) ;
       break ;
       
@@ -407,7 +420,16 @@ extern void fd_sched_run(struct timeval *timeout,
       break ;
       
       case EVENT_SUSPECT_GROUP: /* suspicion on the appartenence of a group to a host */
-        suspect_remote_group(event->host, event->remote_group) ;
+        if(!hello_digest_keeps_group(event->host, event->remote_group, now))
+          suspect_remote_group(event->host, event->remote_group) ;
+      break ;
+      
+      case EVENT_MCAST_ALIVE: /* has to multicast the alives of the local groups */
+        local_send_alive_multicast(now) ;
+      break ;
+      
+      case EVENT_ACCUSATIONS: /* accusations no report carried */
+        local_flush_accusations(event->host) ;
       break ;
     }
     list_del(tmp) ;
@@ -419,9 +441,10 @@ extern void fd_sched_run(struct timeval *timeout,
       timerinf(timeout);
       } else {
       event = list_entry(head->next, struct event_struct, event_list);
-      timersub(&event->tv, now, timeout) ;
+      ns2timer(event->due_ns - mono_now, timeout) ;
     }
   } /* end if */
+  metrics_hist_since(&metrics.sched_run, run_start_ns) ;
 }
 
 
@@ -35,6 +35,16 @@ extern FILE *flog ;
 
 static unsigned int local_hello_seq ;
 
+/* digest of the local groups, see send_hello_multicast() */
+static u_int64_t local_hello_digest ;
+static unsigned int local_hello_groups_count ;
+static unsigned int local_hello_digest_seq ;
+static int local_hello_digest_valid ;
+
+/* HELLO requests are answered by one multicast full HELLO per HELLO_SENDINT */
+static int local_hello_full_pending ;
+static struct timeval local_hello_full_ts ;
+
 extern struct timeval local_epoch ;
 extern unsigned int local_groups_list_seq ;
 extern unsigned int local_groups_multicast_list_seq ;
@@ -45,10 +55,18 @@ extern struct list_head local_groups_list_head ;
 extern void local_init_multicast() {
   int retval ;
   local_hello_seq = 0 ;
+  local_hello_digest_valid = 0 ;
+  local_hello_full_pending = 0 ;
+  timerclear(&local_hello_full_ts) ;
   
   /* send hello multicast now */
   retval = sched_hello_multicast(&local_epoch, 0) ;
   
+#ifdef MULTICAST_ALIVES
+  if( retval >= 0 )
+    retval = sched_alive_multicast(&local_epoch, MCAST_IDLE_SENDINT) ;
+#endif
+  
   if( retval < 0 ) {
 #ifdef OUTPUT
     fprintf(stdout, "Could not schedule multicast event\n") ;
@@ -60,13 +78,14 @@ extern void local_init_multicast() {
 }
 
 
-/* builds a HELLO type message and multicast it */
-extern void send_hello_multicast(struct timeval *now_hello) {
-  char msg[MAX_MSG_LEN] ;
-  char *ptr = NULL, *ptr_head = NULL, *ptr_groups_list = NULL ;
+/* builds a HELLO type message in msg and returns its length. The digest
+ of the local groups is updated on the way. */
+static int build_hello_msg(char *msg) {
+  char *ptr = NULL, *ptr_head = NULL ;
   struct list_head *tmp_group = NULL ;
   int groups_count = 0 ;
   struct list_head groups_list ;
+  u_int64_t digest = 0 ;
   
   struct uint_struct *group = NULL ;
   
@@ -76,6 +95,7 @@ extern void send_hello_multicast(struct timeval *now_hello) {
   
   ptr_head = ptr ;
   
+  retval = -EMSGSIZE ;
   if((ptr = msg_skip_hello_head(ptr)) > msg + MAX_MSG_LEN) {
 #ifdef OUTPUT
     fprintf(stdout, "local_send_hello_multicast:Buffer overflow\n") ;
@@ -87,7 +107,6 @@ extern void send_hello_multicast(struct timeval *now_hello) {
   }
   
   
-  ptr_groups_list = ptr ;
   /* build the list of local groups in the groups_list variable */
   retval = build_groups_list(&groups_list) ;
   if(retval < 0)
@@ -107,21 +126,112 @@ extern void send_hello_multicast(struct timeval *now_hello) {
 #ifdef LOG
       fprintf(flog, "local_send_hello_multicast:Buffer overflow\n") ;
 #endif
+      list_free(&groups_list, struct uint_struct, uint_list) ;
       goto out ;
     }
     
+    digest = hello_digest_add(digest, group->val) ;
     groups_count++ ;
     tmp_group = tmp_group->prev ;
     list_del(&group->uint_list) ;
     free(group) ;
   }
   
+  local_hello_digest = digest ;
+  local_hello_groups_count = groups_count ;
+  local_hello_digest_seq = local_groups_multicast_list_seq ;
+  local_hello_digest_valid = 1 ;
+  
+  retval = -EMSGSIZE ;
+  if(ptr + 4 > msg + MAX_MSG_LEN) {
+#ifdef OUTPUT
+    fprintf(stdout, "local_send_hello_multicast:Buffer overflow\n") ;
+#endif
+#ifdef LOG
+    fprintf(flog, "local_send_hello_multicast:Buffer overflow\n") ;
+#endif
+    goto out ;
+  }
+  ptr = msg_build_hello_wire_version(ptr, WIRE_VERSION) ;
+  
   /* multicast message sequence number - used to deal with out of order messages */
   local_hello_seq++ ;
   msg_build_hello_head(ptr_head, local_hello_seq, local_groups_multicast_list_seq,
   &local_epoch, groups_count) ;
   
-  if(comm_hello_multicast(msg, ptr-msg) < 0) {
+  retval = ptr - msg ;
+  out:
+  return retval ;
+}
+
+/* recomputes the digest of the local groups if they changed since */
+static int update_hello_digest(void) {
+  struct list_head groups_list ;
+  struct list_head *tmp_group = NULL ;
+  struct uint_struct *group = NULL ;
+  int retval ;
+  
+  if(local_hello_digest_valid &&
+    local_hello_digest_seq == local_groups_multicast_list_seq)
+    return 0 ;
+  
+  retval = build_groups_list(&groups_list) ;
+  if(retval < 0)
+    return retval ;
+  
+  local_hello_digest = 0 ;
+  local_hello_groups_count = 0 ;
+  list_for_each(tmp_group, &groups_list) {
+    group = list_entry(tmp_group, struct uint_struct, uint_list) ;
+    local_hello_digest = hello_digest_add(local_hello_digest, group->val) ;
+    local_hello_groups_count++ ;
+  }
+  list_free(&groups_list, struct uint_struct, uint_list) ;
+  
+  local_hello_digest_seq = local_groups_multicast_list_seq ;
+  local_hello_digest_valid = 1 ;
+  return 0 ;
+}
+
+/* the HELLO digest is multicast only if every known host understands it,
+ the others would never learn our groups */
+static int hello_digest_understood(void) {
+  struct list_head *tmp = NULL ;
+  struct host_struct *host = NULL ;
+  
+  list_for_each(tmp, &remote_host_list_head) {
+    host = list_entry(tmp, struct host_struct, remote_host_list) ;
+    if(host->wire_version < WIRE_VERSION_HELLO_DIGEST)
+      return 0 ;
+  }
+  return 1 ;
+}
+
+/* builds a HELLO type message and multicast it. When every known host
+ understands it, only the digest of the local groups is sent: the hosts
+ that do not know that digest ask for the full HELLO. */
+extern void send_hello_multicast(struct timeval *now_hello) {
+  char msg[MAX_MSG_LEN] ;
+  int msg_len ;
+  
+  if(!local_hello_full_pending && hello_digest_understood()) {
+    msg_len = update_hello_digest() ;
+    if(msg_len < 0)
+      goto out ;
+    local_hello_seq++ ;
+    msg_len = msg_build_hello_digest(msg, local_hello_seq,
+      local_groups_multicast_list_seq, &local_epoch,
+    local_hello_groups_count, local_hello_digest, WIRE_VERSION) - msg ;
+  }
+  else {
+    msg_len = build_hello_msg(msg) ;
+    if(msg_len < 0)
+      goto out ;
+    local_hello_full_pending = 0 ;
+    memcpy(&local_hello_full_ts, now_hello, sizeof(*now_hello)) ;
+  }
+  
+  if(comm_hello_multicast(msg, msg_len) < 0) {
 #ifdef OUTPUT
     fprintf(stdout, "Could not send the multicast hello\n") ;
 #endif
@@ -141,6 +251,112 @@ extern void send_hello_multicast(struct timeval *now_hello) {
   return ;
 }
 
+/* merge a HELLO digest: if it is the digest of the groups we know for the
+ host, they are confirmed, otherwise the full HELLO is requested */
+extern void hello_digest_merge(char *msg, int msg_len, struct sockaddr_in *raddr,
+  struct timeval *arrival_ts) {
+  char req[HELLO_REQUEST_LEN] ;
+  struct sockaddr_in addr ;
+  struct host_struct *host = NULL ;
+  unsigned int hello_seq ;
+  unsigned int remote_groups_list_seq ;
+  unsigned int groups_count ;
+  unsigned int wire_version ;
+  struct timeval remote_epoch ;
+  u_int64_t digest ;
+  
+  if(msg_len < HELLO_DIGEST_LEN)
+    goto out ;
+  
+  msg_parse_hello_digest(msg, &hello_seq, &remote_groups_list_seq,
+  &remote_epoch, &groups_count, &digest, &wire_version) ;
+  
+  host = locate_host(raddr) ;
+  if(host && timercmp(&host->remote_epoch, &remote_epoch, ==) &&
+    timerisset(&host->hello_digest_ts) && host->hello_digest == digest) {
+    if(!greater_than(hello_seq, host->hello_seq)) {
+#ifdef OUTPUT
+      fprintf(stdout, "HELLO_OUT_OF_ORDER\n") ;
+#endif
+#ifdef LOG
+      fprintf(flog, "HELLO_OUT_OF_ORDER\n") ;
+#endif
+      goto out ;
+    }
+    host->hello_seq = hello_seq ;
+    host->wire_version = wire_version ;
+    memcpy(&host->hello_digest_ts, arrival_ts, sizeof(*arrival_ts)) ;
+    goto out ;
+  }
+  
+  /* the seq of the host is left as it is so that the answer is accepted */
+  memcpy(&addr, raddr, sizeof(addr)) ;
+  msg_build_hello_request(req) ;
+  if(comm_send(req, HELLO_REQUEST_LEN, &addr) < 0) {
+#ifdef OUTPUT
+    fprintf(stdout, "Could not request the hello of %u.%u.%u.%u\n", NIPQUAD(raddr)) ;
+#endif
+#ifdef LOG
+    fprintf(flog, "Could not request the hello of %u.%u.%u.%u\n", NIPQUAD(raddr)) ;
+#endif
+  }
+  
+  out:
+  return ;
+}
+
+/* answer a HELLO request: the full HELLO is multicast once for all the
+ requests received meanwhile, at most once per HELLO_SENDINT */
+extern void hello_request_merge(char *msg, int msg_len, struct sockaddr_in *raddr,
+  struct timeval *arrival_ts) {
+  struct timeval next_ts ;
+  
+  if(local_hello_full_pending)
+    goto out ;
+  local_hello_full_pending = 1 ;
+  
+  unit2timer(HELLO_SENDINT, &next_ts) ;
+  timeradd(&local_hello_full_ts, &next_ts, &next_ts) ;
+  if(timerisset(&local_hello_full_ts) && timercmp(&next_ts, arrival_ts, >)) {
+    if(sched_hello_multicast(&local_hello_full_ts, HELLO_SENDINT) < 0)
+      goto fail ;
+  }
+  else if(sched_hello_multicast(arrival_ts, 0) < 0)
+    goto fail ;
+  goto out ;
+  
+  fail:
+#ifdef OUTPUT
+  fprintf(stdout, "Could not schedule the hello for %u.%u.%u.%u\n", NIPQUAD(raddr)) ;
+#endif
+#ifdef LOG
+  fprintf(flog, "Could not schedule the hello for %u.%u.%u.%u\n", NIPQUAD(raddr)) ;
+#endif
+  local_hello_full_pending = 0 ;
+  out:
+  return ;
+}
+
+/* the groups of the HELLO of a host are not suspected while its HELLO
+ digests confirm them: the suspicion is moved to the timeout after the
+ last confirmation. Returns 1 if the group is kept. */
+extern int hello_digest_keeps_group(struct host_struct *host,
+  struct uint_struct *group,
+  struct timeval *now) {
+  struct timeval timeout ;
+  
+  if(!timerisset(&host->hello_digest_ts) ||
+    !is_in_ordered_list(group->val, &host->hello_groups_head))
+    return 0 ;
+  
+  unit2timer(2*max(FDD_GROUP_TDU, HELLO_SENDINT), &timeout) ;
+  timeradd(&host->hello_digest_ts, &timeout, &timeout) ;
+  if(!timercmp(&timeout, now, >))
+    return 0 ;
+  
+  return sched_suspect_remote_group(host, group, &host->hello_digest_ts) >= 0 ;
+}
+
 /* merge a new multicast message received */
 extern void hello_multicast_merge(char *msg, int msg_len, struct sockaddr_in *raddr,
   struct timeval *arrival_ts) {
@@ -160,6 +376,7 @@ extern void hello_multicast_merge(char *msg, int msg_len, struct sockaddr_in *ra
   int remote_host_already_known = 1, new_group = 0, send_report_msg = 0;
   struct list_head *tmp_jointly;
   struct uint_struct *group;
+  u_int64_t digest = 0 ;
   
   LIST_HEAD(jointly_groups_bckup);
   
@@ -214,10 +431,14 @@ extern void hello_multicast_merge(char *msg, int msg_len, struct sockaddr_in *ra
   INIT_LIST_HEAD(&remote_all_groups) ;
   
   retval = 0 ;
-  ptr = parse_proc_list(msg, ptr, groups_count, &remote_all_groups, &retval) ;
+  ptr = parse_proc_list(msg + msg_len, ptr, groups_count, &remote_all_groups, &retval) ;
   if(retval < 0)
     goto out_free_proc_list ;
   
+  /* older peers do not send their wire version */
+  if(ptr + 4 <= msg + msg_len)
+    msg_parse_hello_wire_version(ptr, &host->wire_version) ;
+  
   list_for_each(tmp, &remote_all_groups) {
     struct uint_struct *entry_ptr = NULL ;
     int entry_exists ;
@@ -233,9 +454,8 @@ extern void hello_multicast_merge(char *msg, int msg_len, struct sockaddr_in *ra
     if(retval < 0)
       goto out_free_proc_list ;
     
-    tmp = tmp->prev;
-    list_del(&group->uint_list) ;
-    free(group) ;
+    /* the list is kept to check the next HELLO digests against */
+    digest = hello_digest_add(digest, group->val) ;
   }
   
   /* Modified for Omega */
@@ -260,7 +480,7 @@ extern void hello_multicast_merge(char *msg, int msg_len, struct sockaddr_in *ra
       list_insert_ordered(group->val, val, &jointly_groups_bckup, struct uint_struct,
       uint_list, <) ;
       if (entry_ptr == NULL)
-        goto out;
+        goto out_free_proc_list;
     }
   }
   
@@ -287,7 +507,7 @@ extern void hello_multicast_merge(char *msg, int msg_len, struct sockaddr_in *ra
       new_group = 1;
       /* There's a new group we are part of, do we want to monitor that group?
        If yes then send a report msg. */
-      if(exists_report_in_event_list(raddr, group->val)) {
+      if(exists_report_in_event_list(host, group->val)) {
         send_report_msg = 1;
         break;
       }
@@ -328,12 +548,15 @@ extern void hello_multicast_merge(char *msg, int msg_len, struct sockaddr_in *ra
   }
   
   host->remote_groups_multicast_list_seq = remote_groups_list_seq ;
+  list_swap(&host->hello_groups_head, &remote_all_groups) ;
+  host->hello_digest = digest ;
+  memcpy(&host->hello_digest_ts, arrival_ts, sizeof(*arrival_ts)) ;
   local_groups_list_seq++ ;
   recalc_needed_sendint(host, arrival_ts) ;
   local_sched_report_sooner(host->local_needed_sendint, arrival_ts, host) ;
   
   out_free_proc_list:
-  /*list_free(&remote_all_groups, struct uint_struct, uint_list);*/
+  list_free(&remote_all_groups, struct uint_struct, uint_list);
   out:
   
   /* Added for Omega */
@@ -97,46 +97,6 @@ static double calculate_weight(unsigned int units,
 }
 #endif
 
-/*
- ** Records the arrival timestamp of the nearly received message, in the list
- ** in order to compute the loss probability afterwards
- */
-static int merge_average_msg(struct stats_struct *stats, unsigned int seq,
-  struct timeval *sending_ts,
-  struct timeval *arrival_ts) {
-  struct list_head *tmp = NULL ;
-  struct average_lost_struct *average_lost = NULL ;
-  struct average_lost_struct *new_average_lost = NULL ;
-  int retval ;
-  
-  list_for_each(tmp, &stats->average_lost_head) {
-    average_lost = list_entry(tmp, struct average_lost_struct, lost_msg_list) ;
-    if(greater_than(seq, average_lost->seq))
-      break ;
-  }
-  
-  retval = -ENOMEM ;
-  new_average_lost = malloc(sizeof(*new_average_lost)) ;
-  if(NULL == new_average_lost) {
-#ifdef OUTPUT
-    fprintf(stdout, "merge_average_msg:%s\n", strerror(errno)) ;
-#endif
-#ifdef LOG_EXTRA
-    fprintf(flog, "merge_average_msg:%s\n", strerror(errno)) ;
-#endif
-    goto out ;
-  }
-  
-  new_average_lost->seq = seq ; /* put the sequence number */
-  memcpy(&new_average_lost->arrival_ts, arrival_ts,
-  sizeof(new_average_lost->arrival_ts)) ; /* copy the arrival timestamp */
-  list_add_tail(&new_average_lost->lost_msg_list, tmp) ;
-  retval = 0 ;
-  
-  out:
-  return retval ;
-}
-
 /*************** AVERAGE LOSS PROBABILITY COMPUTATION *****************/
 /*
  ** Compute the value of the loss probability right after a messages has been lost
@@ -239,6 +199,81 @@ static void average_out_of_order_rep(struct stats_struct *stats) {
     stats->nb_average_lost_msg-- ;
 }
 
+#define WINDOW_WORD(seq) (((seq) % LOSS_WINDOW_BITS) / 64)
+#define WINDOW_BIT(seq)  ((u_int64_t)1 << ((seq) % 64))
+
+/*
+ ** returns the smallest sequence number of the window, there must be one
+ */
+static unsigned int first_pending_seq(struct stats_struct *stats) {
+  unsigned int seq = stats->last_average_seq + 1 ;
+  u_int64_t word ;
+  
+  for( ; ; ) {
+    word = stats->average_window[WINDOW_WORD(seq)] >> (seq % 64) ;
+    if(word)
+      return seq + __builtin_ctzll(word) ;
+    seq += 64 - seq % 64 ;
+  }
+}
+
+/*
+ ** takes the smallest sequence number of the window into account in the
+ ** loss probability
+ */
+static void account_first_pending(struct stats_struct *stats,
+  struct timeval *arrival_ts) {
+  unsigned int seq = first_pending_seq(stats) ;
+  
+  stats->average_window[WINDOW_WORD(seq)] &= ~WINDOW_BIT(seq) ;
+  stats->nb_average_pending-- ;
+  recompute_pl(stats, seq, stats->last_average_seq, arrival_ts) ;
+  stats->last_average_seq = seq ;
+}
+
+/*
+ ** Records the nearly received message in the window, in order to compute
+ ** the loss probability afterwards
+ */
+static void merge_average_msg(struct stats_struct *stats, unsigned int seq,
+  struct timeval *arrival_ts) {
+  
+  if(!greater_than(seq, stats->last_average_seq)) {
+#ifdef OUTPUT
+    fprintf(stdout, "AVERAGE_PL_MESSAGE_OUT_OF_ORDER: seq=%u, prev_seq=%u\n",
+    seq, stats->last_average_seq) ;
+#endif
+#ifdef LOG
+    fprintf(flog, "AVERAGE_PL_MESSAGE_OUT_OF_ORDER:seq=%u, prev_seq=%u\n",
+    seq, stats->last_average_seq) ;
+#endif
+    /* treat the overdelayed messages which have been declared lost.
+    just adjust the value of the received messages
+     */
+    average_out_of_order_rep(stats) ;
+    return ;
+  }
+  
+  /* make room for seq: the oldest messages are taken into account
+   without waiting any longer */
+  while(stats->nb_average_pending &&
+    seq - stats->last_average_seq > LOSS_WINDOW_BITS)
+  account_first_pending(stats, arrival_ts) ;
+  
+  if(seq - stats->last_average_seq > LOSS_WINDOW_BITS) {
+    /* nothing else is waiting, the gap is accounted for right away */
+    recompute_pl(stats, seq, stats->last_average_seq, arrival_ts) ;
+    stats->last_average_seq = seq ;
+    return ;
+  }
+  
+  if(!(stats->average_window[WINDOW_WORD(seq)] & WINDOW_BIT(seq))) {
+    stats->average_window[WINDOW_WORD(seq)] |= WINDOW_BIT(seq) ;
+    stats->nb_average_pending++ ;
+  }
+  stats->average_arrival[seq % LOSS_WINDOW_BITS] = timer2unit(arrival_ts) ;
+}
+
 /*
  ** delays the computation of the loss probability:
  **  the delay is computed so that there are no more than 1% of DELAYED messages
@@ -247,9 +282,8 @@ static void average_out_of_order_rep(struct stats_struct *stats) {
 static void recompute_pl_late(struct host_struct *host,
   struct timeval *now) {
   struct stats_struct *stats = &host->stats ;
-  struct list_head *tmp = NULL ;
-  struct average_lost_struct *average_lost = NULL ;
   struct timeval limit_arrival_ts ;
+  u_int limit ;
   
   /* the delay */
   unit2timer((u_int)rint(sqrt(stats->est.v_d*(1.0/DEVIATION_ACCURACY-1))),
@@ -266,62 +300,99 @@ static void recompute_pl_late(struct host_struct *host,
   to find out the loss probability's value
    */
   timersub(now, &limit_arrival_ts, &limit_arrival_ts) ;
+  limit = timer2unit(&limit_arrival_ts) ;
   
 #ifdef OUTPUT_EXTRA
-  fprintf(stdout, "average_lost_list: ") ;
-#endif
-#ifdef LOG_EXTRA
-  fprintf(flog, "average_lost_list: ") ;
-#endif
-  list_for_each_reverse(tmp, &stats->average_lost_head) {
-    average_lost = list_entry(tmp, struct average_lost_struct, lost_msg_list) ;
-#ifdef OUTPUT_EXTRA
-    fprintf(stdout, "%u ", average_lost->seq) ;
+  fprintf(stdout, "average window: %u pending after %u\n",
+  stats->nb_average_pending, stats->last_average_seq) ;
 #endif
 #ifdef LOG_EXTRA
-    fprintf(flog, "%u ", average_lost->seq) ;
+  fprintf(flog, "average window: %u pending after %u\n",
+  stats->nb_average_pending, stats->last_average_seq) ;
 #endif
-  }
   
-#ifdef OUTPUT_EXTRA
-  fprintf(stdout, "\n") ;
-#endif
-#ifdef LOG_EXTRA
-  fprintf(flog, "\n") ;
-#endif
-  
-  /* take all the delayed messages from the list up to the limit
-  given by the value of the delay processing
+  /* take the delayed messages from the window, in the order of their
+  sequence numbers, up to the limit given by the value of the delay
+   processing
    */
-  list_for_each_reverse(tmp, &stats->average_lost_head) {
-    average_lost = list_entry(tmp, struct average_lost_struct, lost_msg_list) ;
-    if(timercmp(&average_lost->arrival_ts, &limit_arrival_ts, >))
-      break ;
-    if(greater_than(host->stats.last_average_seq, average_lost->seq)) {
-#ifdef OUTPUT
-      fprintf(stdout, "AVERAGE_PL_MESSAGE_OUT_OF_ORDER: seq=%u, prev_seq=%u\n",
-      average_lost->seq, host->stats.last_average_seq) ;
-#endif
-#ifdef LOG
-      fprintf(flog, "AVERAGE_PL_MESSAGE_OUT_OF_ORDER:seq=%u, prev_seq=%u\n",
-      average_lost->seq, host->stats.last_average_seq) ;
-#endif
-      /* treat the overdelayed messages which have been declared lost.
-      just adjust the value of the received messages
-       */
-      average_out_of_order_rep(stats) ;
-    }
-    else {
-      
-      recompute_pl(stats, average_lost->seq, host->stats.last_average_seq,
-      &average_lost->arrival_ts) ;
-      host->stats.last_average_seq = average_lost->seq ;
-    }
-    tmp = tmp->next ;
-    list_del(&average_lost->lost_msg_list) ;
-    free(average_lost) ;
+  while(stats->nb_average_pending) {
+    if((int)(stats->average_arrival[first_pending_seq(stats) % LOSS_WINDOW_BITS] -
+      limit) > 0)
+    break ;
+    account_first_pending(stats, now) ;
   }
-  return ;
+}
+
+/****************** PHI ACCRUAL DETECTOR ******************************/
+/*
+ ** records the time elapsed since the previous message: mean over the first
+ ** PHI_SAMPLES samples, exponentially weighted afterwards. The samples are
+ ** divided by the sendint the host announced, so that a change of sendint
+ ** is taken at once instead of over the weighted samples.
+ */
+static void merge_interarrival(struct stats_struct *stats,
+  struct timeval *arrival_ts, unsigned int remote_sendint) {
+  struct timeval tv ;
+  double interarrival, delta, weight ;
+  
+  if(timerisset(&stats->last_arrival_ts) && remote_sendint &&
+    timercmp(arrival_ts, &stats->last_arrival_ts, >)) {
+    timersub(arrival_ts, &stats->last_arrival_ts, &tv) ;
+    interarrival = timer2unit(&tv) / (double)remote_sendint ;
+    
+    if(stats->nb_interarrival < PHI_SAMPLES)
+      stats->nb_interarrival++ ;
+    weight = 1.0 / stats->nb_interarrival ;
+    delta = interarrival - stats->interarrival_mean ;
+    stats->interarrival_mean += weight * delta ;
+    stats->interarrival_var = (1.0 - weight) *
+    (stats->interarrival_var + weight * delta * delta) ;
+  }
+  if(remote_sendint)
+    stats->interarrival_sendint = remote_sendint ;
+  memcpy(&stats->last_arrival_ts, arrival_ts, sizeof(stats->last_arrival_ts)) ;
+}
+
+/*
+ ** returns z such that a normal variable is above z standard deviations
+ ** with probability p, p <= 0.5 (Abramowitz and Stegun 26.2.23)
+ */
+static double normal_tail_quantile(double p) {
+  double t = sqrt(-2.0 * log(p)) ;
+  
+  return t - (2.515517 + 0.802853 * t + 0.010328 * t * t) /
+  (1.0 + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t) ;
+}
+
+/* phi_fresh_point - sets fresh to the time at which the phi of the host
+ reaches the threshold given by qos, the inter-arrival times being normal.
+ The time is at most TdU after the arrival. Returns -1 if there are too
+ few samples yet, 0 otherwise. */
+extern int phi_fresh_point(struct qos_struct *qos, struct stats_struct *stats,
+  struct timeval *arrival_ts, struct timeval *fresh) {
+  double threshold, mean, deviation, margin ;
+  
+  if(stats->nb_interarrival < PHI_MIN_SAMPLES || stats->interarrival_mean <= 0.0 ||
+    stats->interarrival_sendint == 0)
+  return -1 ;
+  
+  /* back to units, at the current sendint of the host */
+  mean = stats->interarrival_mean * stats->interarrival_sendint ;
+  
+  /* one mistake per TmrL: a message out of TmrL/mean may be late */
+  threshold = log10(qos->TmrL * (double)UNITS_PER_SEC / mean) ;
+  threshold = min(max(threshold, PHI_MIN_THRESHOLD), PHI_MAX_THRESHOLD) ;
+  
+  deviation = max(sqrt(stats->interarrival_var) * stats->interarrival_sendint,
+  PHI_MIN_DEVIATION) ;
+  margin = mean +
+  deviation * normal_tail_quantile(pow(10.0, -threshold)) ;
+  if(margin > qos->TdU)
+    margin = qos->TdU ;
+  
+  unit2timer((u_int)rint(margin), fresh) ;
+  timeradd(arrival_ts, fresh, fresh) ;
+  return 0 ;
 }
 
 /************** INSTANT EXPECTED DELAY COMPUTATION ********************/
@@ -426,118 +497,129 @@ static double compute_instant_delay(struct stats_struct *stats,
 #endif
 
 #ifndef SYNCH_CLOCKS
-/* compute the average value of the sending intervals of the messages received from the
-remote host
+static inline long long timer2usec(struct timeval *tv) {
+  return (long long)tv->tv_sec * 1000000LL + tv->tv_usec ;
+}
+
+/*
+ ** moves delay_base_seq to the smallest seq of the samples
  */
-static void compute_average_sendint(struct stats_struct *stats,
-  struct timeval *tv_average_sendint) {
-  struct list_head *tmp ;
-  struct average_delay_struct *entry ;
-  unsigned int n = 0 ;
-  struct timeval tv_sendint ;
+static void rebase_average_delays(struct stats_struct *stats) {
+  struct average_delay_struct *lowest ;
   
-  timerclear(tv_average_sendint) ;
-  
-  /* add all the sendint values of the list in a time structure */
-  list_for_each(tmp, &stats->average_delay_msg_head) {
-    entry = list_entry(tmp, struct average_delay_struct, delay_list) ;
-    unit2timer(entry->remote_sendint, &tv_sendint) ;
-    timeradd(tv_average_sendint, &tv_sendint, tv_average_sendint) ;
-    n++ ;
+  if(list_empty(&stats->average_delay_msg_head))
+    return ;
+  lowest = list_entry(stats->average_delay_msg_head.prev,
+  struct average_delay_struct, delay_list) ;
+  stats->sum_delay_seq -= (long long)stats->nb_average_delay_msg *
+  (int)(lowest->seq - stats->delay_base_seq) ;
+  stats->delay_base_seq = lowest->seq ;
+}
+
+/*
+ ** accounts for a sample entering the list, or replacing the one with the
+ ** same seq (old_entry set). The samples above it are walked, i.e. none
+ ** when the messages arrive in order.
+ */
+static void average_delays_enter(struct stats_struct *stats,
+  struct average_delay_struct *entry,
+  int old_entry,
+  unsigned int old_sendint,
+  struct timeval *old_arrival_ts) {
+  struct list_head *tmp ;
+  struct average_delay_struct *above ;
+  long long sum_above = 0 ;
+  unsigned int nb_above = 0, rank ;
+  
+  for(tmp = stats->average_delay_msg_head.next ; tmp != &entry->delay_list ;
+    tmp = tmp->next) {
+    above = list_entry(tmp, struct average_delay_struct, delay_list) ;
+    sum_above += above->remote_sendint ;
+    nb_above++ ;
   }
+  rank = stats->nb_average_delay_msg - 1 - nb_above ;
   
-  if(!n)
+  if(old_entry) {
+    stats->sum_delay_arrival += timer2usec(&entry->arrival_ts) - timer2usec(old_arrival_ts) ;
+    stats->sum_delay_sendint += (long long)entry->remote_sendint - old_sendint ;
+    stats->sum_delay_rank_sendint += (long long)rank *
+    ((long long)entry->remote_sendint - old_sendint) ;
     return ;
+  }
   
-  /* divide the sum by the number of parts (timer structure)*/
-  timerdiv(tv_average_sendint, n) ;
-  return ;
+  if(stats->nb_average_delay_msg == 1)
+    stats->delay_base_seq = entry->seq ;
+  stats->sum_delay_arrival += timer2usec(&entry->arrival_ts) ;
+  stats->sum_delay_sendint += entry->remote_sendint ;
+  /* the samples above it go one rank up */
+  stats->sum_delay_rank_sendint += (long long)rank * entry->remote_sendint + sum_above ;
+  stats->sum_delay_seq += (int)(entry->seq - stats->delay_base_seq) ;
+  rebase_average_delays(stats) ;
 }
-#endif
 
-#ifndef SYNCH_CLOCKS
 /*
- ** recompute the value of the expected arrival time of the next message
+ ** accounts for the sample with the smallest seq leaving the list, it has
+ ** already been unlinked
+ */
+static void average_delays_leave(struct stats_struct *stats,
+  struct average_delay_struct *entry) {
+  
+  stats->sum_delay_arrival -= timer2usec(&entry->arrival_ts) ;
+  stats->sum_delay_sendint -= entry->remote_sendint ;
+  /* the other samples go one rank down */
+  stats->sum_delay_rank_sendint -= stats->sum_delay_sendint ;
+  rebase_average_delays(stats) ;
+}
+
+/*
+ ** recompute the value of the expected arrival time of the next message:
+ ** the mean over the samples of their arrival minus the sending intervals
+ ** preceding them, plus all the sending intervals. A lost message counts
+ ** for the average sending interval. The sums are kept by
+ ** merge_average_delay_msg(), this is O(1).
  */
 extern void recompute_expected_arrival(struct host_struct *host) {
   
-  struct list_head *tmp ;
   struct stats_struct *stats = &host->stats ;
-  struct average_delay_struct *delay ;
-  struct timeval tv0 ;
+  struct average_delay_struct *highest ;
+  double n = stats->nb_average_delay_msg ;
+  double sendint, average_sendint, preceding, last_preceding ;
+  double expected_arrival ;
+  long long usecs ;
   
-  unsigned int s0 = 0 ;
-  unsigned int k ;
-  
-  struct timeval arrival_ts ;
-  struct timeval sum_eta ;
-  struct timeval expected_arrival ;
-  struct timeval tv_eta ;
-  struct timeval tv_average_eta ;
+  if(stats->nb_average_delay_msg == 0)
+    return ;
   
-  int num_samples = 0 ;
+  highest = list_entry(stats->average_delay_msg_head.next,
+  struct average_delay_struct, delay_list) ;
   
-  timerclear(&tv0) ;
-  timerclear(&sum_eta) ;
-  timerclear(&expected_arrival) ;
+  sendint = (double)stats->sum_delay_sendint * USECS_PER_UNIT ;
+  average_sendint = sendint / n ;
   
-  /* average sendint value */
-  compute_average_sendint(stats, &tv_average_eta) ;
-#ifdef OUTPUT
-  fprintf(stdout, "average_sendint=%ld.%ld ; = %u ms\n",
-    tv_average_eta.tv_sec, tv_average_eta.tv_usec,
-  timer2unit(&tv_average_eta)) ;
-#endif
-#ifdef LOG
-  fprintf(flog, "average_sendint=%ld.%ld ; = %u ms\n",
-    tv_average_eta.tv_sec, tv_average_eta.tv_usec,
-  timer2unit(&tv_average_eta)) ;
-#endif
-  list_for_each_reverse(tmp, &stats->average_delay_msg_head) {
-    delay = list_entry(tmp, struct average_delay_struct, delay_list) ;
-    
-    /* set tv0 the first arrival timestamp in the list
-    all the further computations will be relative to it
-     but it will not altere the results */
-    if( !timerisset(&tv0) ) {
-      memcpy(&tv0, &delay->arrival_ts, sizeof(tv0)) ;
-      s0 = delay->seq ;
-    }
-    
-    timersub(&delay->arrival_ts, &tv0, &arrival_ts) ;
-    
-    /* for each lost message consider its sending interval as being
-     equal to the average value over all sending intervals */
-    for(k = s0 + 1 ; k < delay->seq ; k++) {
-      timeradd(&sum_eta, &tv_average_eta, &sum_eta) ;
-      printf("Lost %u. Adding the average\n", k) ;
-    }
-    timersub(&arrival_ts, &sum_eta, &arrival_ts) ;
-    timeradd(&expected_arrival, &arrival_ts, &expected_arrival) ;
-    
-    unit2timer(delay->remote_sendint, &tv_eta) ;
-    timeradd(&sum_eta, &tv_eta, &sum_eta) ;
-    
-    s0 = delay->seq ;
-    num_samples++ ;
-  }
+  /* the sum over the samples of the sending intervals preceding them: the
+   received ones, then the lost ones */
+  preceding = ((n - 1) * stats->sum_delay_sendint - stats->sum_delay_rank_sendint) *
+  (double)USECS_PER_UNIT ;
+  preceding += average_sendint * (stats->sum_delay_seq - n * (n - 1) / 2) ;
   
-  if(num_samples == 0)
-    return ;
+  /* the sending intervals up to the next message */
+  last_preceding = sendint + average_sendint *
+  ((double)(highest->seq - stats->delay_base_seq) - (n - 1)) ;
   
-  timerdiv(&expected_arrival, num_samples) ;
-  timeradd(&expected_arrival, &sum_eta, &expected_arrival) ;
-  timeradd(&expected_arrival, &tv0, &expected_arrival) ;
+  expected_arrival = (stats->sum_delay_arrival - preceding) / n + last_preceding ;
+  usecs = (long long)rint(expected_arrival) ;
+  stats->expected_arrival_ts.tv_sec = usecs / 1000000 ;
+  stats->expected_arrival_ts.tv_usec = usecs % 1000000 ;
   
-  memcpy(&stats->expected_arrival_ts, &expected_arrival,
-  sizeof(stats->expected_arrival_ts)) ;
 #ifdef OUTPUT
-  fprintf(stdout, "Computed expected_arrival=%ld.%ld, num_samples=%i\n",
-  expected_arrival.tv_sec, expected_arrival.tv_usec, num_samples) ;
+  fprintf(stdout, "Computed expected_arrival=%ld.%ld, num_samples=%u\n",
+  stats->expected_arrival_ts.tv_sec, stats->expected_arrival_ts.tv_usec,
+  stats->nb_average_delay_msg) ;
 #endif
 #ifdef LOG
-  fprintf(flog, "Computed expected_arrival=%ld.%ld, num_samples=%i\n",
-  expected_arrival.tv_sec, expected_arrival.tv_usec, num_samples) ;
+  fprintf(flog, "Computed expected_arrival=%ld.%ld, num_samples=%u\n",
+  stats->expected_arrival_ts.tv_sec, stats->expected_arrival_ts.tv_usec,
+  stats->nb_average_delay_msg) ;
 #endif
 }
 #endif
@@ -553,6 +635,10 @@ extern int merge_average_delay_msg(struct stats_struct *stats,
   int retval ;
   struct average_delay_struct *entry_ptr = NULL ;
   int entry_exists ;
+#ifndef SYNCH_CLOCKS
+  unsigned int old_sendint = 0 ;
+  struct timeval old_arrival_ts ;
+#endif
   
   list_insert_ordered(seq, seq, &stats->average_delay_msg_head,
   struct average_delay_struct, delay_list, >) ;
@@ -560,6 +646,13 @@ extern int merge_average_delay_msg(struct stats_struct *stats,
   if(entry_ptr == NULL)
     goto out ;
   
+#ifndef SYNCH_CLOCKS
+  if(entry_exists) {
+    old_sendint = entry_ptr->remote_sendint ;
+    memcpy(&old_arrival_ts, &entry_ptr->arrival_ts, sizeof(old_arrival_ts)) ;
+  }
+#endif
+  
 #ifdef SYNCH_CLOCKS
   if(timercmp(arrival_ts, sending_ts, >)) {
     timersub(arrival_ts, sending_ts, &entry_ptr->delay_tv) ;
@@ -574,7 +667,12 @@ extern int merge_average_delay_msg(struct stats_struct *stats,
   entry_ptr->remote_sendint = remote_sendint ;
   memcpy(&entry_ptr->arrival_ts, arrival_ts, sizeof(entry_ptr->arrival_ts)) ;
   
-  stats->nb_average_delay_msg++ ;
+  /* a duplicate replaces the sample with the same seq */
+  if(!entry_exists)
+    stats->nb_average_delay_msg++ ;
+#ifndef SYNCH_CLOCKS
+  average_delays_enter(stats, entry_ptr, entry_exists, old_sendint, &old_arrival_ts) ;
+#endif
   
   /* remove extra messages from the average delay list */
   list_for_each_reverse(tmp, &stats->average_delay_msg_head) {
@@ -584,8 +682,11 @@ extern int merge_average_delay_msg(struct stats_struct *stats,
     delay_list) ;
     tmp = tmp->next ;
     list_del(&average_delay->delay_list) ;
-    free(average_delay) ;
     stats->nb_average_delay_msg-- ;
+#ifndef SYNCH_CLOCKS
+    average_delays_leave(stats, average_delay) ;
+#endif
+    free(average_delay) ;
   }
   
   retval = 0 ;
@@ -593,6 +694,18 @@ extern int merge_average_delay_msg(struct stats_struct *stats,
   return retval ;
 }
 
+/* clear_average_delays - drops the samples of the average delay */
+extern void clear_average_delays(struct stats_struct *stats) {
+  
+  list_free(&stats->average_delay_msg_head, struct average_delay_struct, delay_list) ;
+  stats->nb_average_delay_msg = 0 ;
+#ifndef SYNCH_CLOCKS
+  stats->delay_base_seq = 0 ;
+  stats->sum_delay_arrival = stats->sum_delay_sendint = 0 ;
+  stats->sum_delay_rank_sendint = stats->sum_delay_seq = 0 ;
+#endif
+}
+
 /* compute the standard deviation of message delay */
 extern unsigned int compute_average_delays(struct stats_struct *stats) {
   
@@ -652,11 +765,53 @@ extern unsigned int compute_average_delays(struct stats_struct *stats) {
   return timer2unit(&ed_tv) ;
 }
 
+/* initial_delays_converged - tells whether the samples of the INITIAL_ED
+ stage are enough: the maximum number of them, or the confidence interval
+ of the delay and the standard error of its variance within tolerance
+ (see INITIAL_ED_TOLERANCE) */
+extern int initial_delays_converged(struct stats_struct *stats) {
+  struct list_head *tmp = NULL ;
+  struct average_delay_struct *average_delay = NULL ;
+  double n = stats->nb_average_delay_msg ;
+  double delay, diff, sum = 0.0, sum_sq = 0.0, sum_4 = 0.0 ;
+  double mean, var, m4, var_se ;
+  
+  if(stats->nb_average_delay_msg >= AVERAGE_DELAY_MAX_SAMPLES)
+    return 1 ;
+  if(stats->nb_average_delay_msg < INITIAL_MIN_SAMPLES)
+    return 0 ;
+  
+  list_for_each(tmp, &stats->average_delay_msg_head) {
+    average_delay = list_entry(tmp, struct average_delay_struct, delay_list) ;
+    sum += average_delay->delay_tv.tv_sec * (double)UNITS_PER_SEC +
+    average_delay->delay_tv.tv_usec / (double)USECS_PER_UNIT ;
+  }
+  mean = sum / n ;
+  
+  /* central moments, the fourth one for the spread of the variance */
+  list_for_each(tmp, &stats->average_delay_msg_head) {
+    average_delay = list_entry(tmp, struct average_delay_struct, delay_list) ;
+    delay = average_delay->delay_tv.tv_sec * (double)UNITS_PER_SEC +
+    average_delay->delay_tv.tv_usec / (double)USECS_PER_UNIT ;
+    diff = (delay - mean) * (delay - mean) ;
+    sum_sq += diff ;
+    sum_4 += diff * diff ;
+  }
+  var = sum_sq / (n - 1.0) ;
+  m4 = sum_4 / n ;
+  var_se = sqrt(max(0.0, m4 - (n - 3.0) / (n - 1.0) * var * var) / n) ;
+  
+  if(INITIAL_CONFIDENCE_Z * sqrt(var / n) > INITIAL_ED_TOLERANCE)
+    return 0 ;
+  return var_se <= max(INITIAL_VD_TOLERANCE * var, INITIAL_VD_MIN_TOLERANCE) ;
+}
+
 /****************** EXTERN STUFF *********************/
 /* stats_init - initialize a stats structure */
 extern void stats_init(struct stats_struct *stats) {
   
-  INIT_LIST_HEAD(&stats->average_lost_head) ;
+  bzero(stats->average_window, sizeof(stats->average_window)) ;
+  stats->nb_average_pending = 0 ;
   
   bzero(&stats->expected_arrival_ts, sizeof(stats->expected_arrival_ts)) ;
   stats->local_initial_finished = FINISHED_NO ;
@@ -669,11 +824,21 @@ extern void stats_init(struct stats_struct *stats) {
   
   INIT_LIST_HEAD(&stats->average_delay_msg_head) ;
   stats->nb_average_delay_msg = 0 ;
+#ifndef SYNCH_CLOCKS
+  stats->delay_base_seq = 0 ;
+  stats->sum_delay_arrival = stats->sum_delay_sendint = 0 ;
+  stats->sum_delay_rank_sendint = stats->sum_delay_seq = 0 ;
+#endif
   stats->nb_average_recompute_period = 1 ;
   
   stats->est.pl = INITIAL_LOSS_PROBABILITY ;
   stats->est.e_d = stats->est.v_d = 0.0 ;
   
+  timerclear(&stats->last_arrival_ts) ;
+  stats->nb_interarrival = 0 ;
+  stats->interarrival_mean = stats->interarrival_var = 0.0 ;
+  stats->interarrival_sendint = 0 ;
+  
   stats->last_interval_length = (unsigned int)rint(1.0/INITIAL_LOSS_PROBABILITY) ;
   stats->current_interval_length = 0 ;
 }
@@ -689,6 +854,8 @@ extern void stats_new_sample(struct host_struct *host, unsigned int seq,
   /* inits for the first received message */
   if( stats->nb_average_delay_msg == 0 ) {
     host->stats.last_average_seq = seq - 1 ;
+    bzero(stats->average_window, sizeof(stats->average_window)) ;
+    stats->nb_average_pending = 0 ;
   }
   
   /* standard deviation computation */
@@ -698,27 +865,16 @@ extern void stats_new_sample(struct host_struct *host, unsigned int seq,
   /* expected arrival time computation */
   recompute_expected_arrival(host) ;
 #endif
+  /* include this message in the inter-arrival times */
+  merge_interarrival(stats, arrival_ts, remote_sendint) ;
   /* include this message in the loss probability computation */
-  merge_average_msg(stats, seq, sending_ts, arrival_ts) ;
+  merge_average_msg(stats, seq, arrival_ts) ;
   /* recompute the loss probability "latelly" */
   recompute_pl_late(host, arrival_ts) ;
   
-#ifdef OUTPUT_EXTRA
-  fprintf(stdout, "pl=%f, vd=%f, seq=%u, host=%u.%u.%u.%u, "
-    "expected_arrival:%ld.%ld\n"
-    "Host's sendint:%u\n",
-    host->stats.est.pl, host->stats.est.v_d, seq,
-    NIPQUAD(&host->addr),
-    host->stats.expected_arrival_ts.tv_sec,
-    host->stats.expected_arrival_ts.tv_usec,
-  remote_sendint) ;
-#endif
-#ifdef LOG_EXTRA
-  fprintf(flog, "pl=%f, ed=%f, vd=%f, seq=%u, host=%u.%u.%u.%u\n"
-    "Host's sendint:%u\n",
-    host->stats.est.pl, host->stats.est.e_d, host->stats.est.v_d, seq,
-  NIPQUAD(&host->addr), remote_sendint) ;
-#endif
+  trace_event_f(TRACE_ESTIMATE, &host->addr, host->stats.est.pl,
+  host->stats.est.e_d, host->stats.est.v_d) ;
+  warm_save(host, arrival_ts) ;
 }
 
 extern void recompute_delays(struct stats_struct *stats,
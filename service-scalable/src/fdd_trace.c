@@ -0,0 +1,95 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_trace.c - mmap'd binary event trace ring */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "fdd_trace.h"
+
+#ifdef TRACE
+
+struct trace_ring *trace_ring = NULL ;
+
+/* trace_init - creates the trace file and maps it. The ring is restarted
+ at every start of the daemon. Returns 0 on success, -1 otherwise (the
+ daemon then runs without trace). */
+extern int trace_init(void) {
+  int fd ;
+  void *ptr ;
+  struct stat st ;
+  struct timespec rt, mono ;
+  
+  /* in /tmp: a link put there by someone else is not followed, and only
+   a regular file is truncated */
+  fd = open(FDD_TRACE_FILE, O_RDWR | O_CREAT | O_NOFOLLOW, 0644) ;
+  if(fd < 0) {
+    perror("fdd: could not open the trace file") ;
+    return -1 ;
+  }
+  if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+    fprintf(stderr, "fdd: the trace file is not a regular file\n") ;
+    close(fd) ;
+    return -1 ;
+  }
+  if(ftruncate(fd, 0) < 0 || ftruncate(fd, TRACE_RING_SIZE) < 0) {
+    perror("fdd: could not size the trace file") ;
+    close(fd) ;
+    return -1 ;
+  }
+  ptr = mmap(NULL, TRACE_RING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) ;
+  close(fd) ;
+  if(ptr == MAP_FAILED) {
+    perror("fdd: could not map the trace file") ;
+    return -1 ;
+  }
+  
+  memset(ptr, 0, sizeof(struct trace_ring)) ;
+  trace_ring = ptr ;
+  trace_ring->magic = TRACE_MAGIC ;
+  trace_ring->version = TRACE_VERSION ;
+  trace_ring->nb_records = TRACE_RING_RECORDS ;
+  trace_ring->record_size = sizeof(struct trace_record) ;
+  
+  clock_gettime(CLOCK_REALTIME, &rt) ;
+  clock_gettime(CLOCK_MONOTONIC, &mono) ;
+  trace_ring->realtime_offset_ns =
+  ((int64_t)rt.tv_sec - mono.tv_sec) * 1000000000ll +
+  ((int64_t)rt.tv_nsec - mono.tv_nsec) ;
+  
+  return 0 ;
+}
+
+/* trace_cleanup - flushes and unmaps the ring, the file is kept for
+ the decoder */
+extern void trace_cleanup(void) {
+  if(!trace_ring)
+    return ;
+  msync(trace_ring, TRACE_RING_SIZE, MS_SYNC) ;
+  munmap(trace_ring, TRACE_RING_SIZE) ;
+  trace_ring = NULL ;
+}
+
+#endif /* TRACE */
@@ -0,0 +1,171 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_tracedump.c - offline decoder of the fdd trace ring */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include "fdd_trace.h"
+
+static const char *trace_type_name(u_int16_t type) {
+  switch(type) {
+    case TRACE_REPORT_SENT:   return "REPORT_SENT" ;
+    case TRACE_REPORT_RCVD:   return "REPORT_RCVD" ;
+    case TRACE_REPORT_OOO:    return "REPORT_OUT_OF_ORDER" ;
+    case TRACE_ESTIMATE:      return "ESTIMATE" ;
+    case TRACE_SENDINT:       return "SENDINT" ;
+    case TRACE_HOST_SUSPECT:  return "HOST_SUSPECT" ;
+    case TRACE_NOTIFY:        return "NOTIFY" ;
+    case TRACE_LEADER_CHANGE: return "LEADER_CHANGE" ;
+    default:                  return "UNKNOWN" ;
+  }
+}
+
+static void print_record(struct trace_record *rec, int64_t offset, int csv) {
+  struct in_addr addr ;
+  int64_t ts = (int64_t)rec->ts_ns + offset ;
+  
+  addr.s_addr = rec->addr ;
+  
+  if(csv) {
+    printf("%lld.%09lld,%s,%s,", (long long)(ts / 1000000000ll),
+      (long long)(ts % 1000000000ll), trace_type_name(rec->type),
+    inet_ntoa(addr)) ;
+    if(rec->type == TRACE_ESTIMATE)
+      printf("%g,%g,%g\n", rec->arg[0].f, rec->arg[1].f, rec->arg[2].f) ;
+    else
+      printf("%u,%u,%u\n", rec->arg[0].u, rec->arg[1].u, rec->arg[2].u) ;
+    return ;
+  }
+  
+  printf("[%lld.%09lld] %-20s %-15s ", (long long)(ts / 1000000000ll),
+    (long long)(ts % 1000000000ll), trace_type_name(rec->type),
+  inet_ntoa(addr)) ;
+  
+  switch(rec->type) {
+    case TRACE_REPORT_SENT:
+      printf("seq=%u len=%u local_needed_sendint=%u\n",
+      rec->arg[0].u, rec->arg[1].u, rec->arg[2].u) ;
+    break ;
+    case TRACE_REPORT_RCVD:
+      printf("seq=%u len=%u remote_sendint=%u\n",
+      rec->arg[0].u, rec->arg[1].u, rec->arg[2].u) ;
+    break ;
+    case TRACE_REPORT_OOO:
+      printf("seq=%u last_seq=%u\n", rec->arg[0].u, rec->arg[1].u) ;
+    break ;
+    case TRACE_ESTIMATE:
+      printf("pl=%f e_d=%f v_d=%f\n", rec->arg[0].f, rec->arg[1].f,
+      rec->arg[2].f) ;
+    break ;
+    case TRACE_SENDINT:
+      printf("%s %u -> %u\n", rec->arg[2].u == TRACE_SENDINT_LOCAL_NEEDED ?
+        "local_needed_sendint" : "remote_needed_sendint",
+      rec->arg[0].u, rec->arg[1].u) ;
+    break ;
+    case TRACE_HOST_SUSPECT:
+      printf("remote_epoch=%u\n", rec->arg[0].u) ;
+    break ;
+    case TRACE_NOTIFY:
+      printf("pid=%u gid=%u notif=%u\n", rec->arg[0].u, rec->arg[1].u,
+      rec->arg[2].u) ;
+    break ;
+    case TRACE_LEADER_CHANGE:
+      printf("gid=%u pid=%u stable=%u\n", rec->arg[0].u, rec->arg[1].u,
+      rec->arg[2].u) ;
+    break ;
+    default:
+      printf("%u %u %u\n", rec->arg[0].u, rec->arg[1].u, rec->arg[2].u) ;
+    break ;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  const char *file = FDD_TRACE_FILE ;
+  struct trace_ring *ring ;
+  struct trace_record rec, *slot ;
+  struct stat st ;
+  u_int64_t head, pos, first ;
+  int fd, opt, csv = 0 ;
+  
+  while((opt = getopt(argc, argv, "c")) != -1) {
+    switch(opt) {
+      case 'c':
+        csv = 1 ;
+      break ;
+      default:
+        fprintf(stderr, "usage: %s [-c] [trace file]\n", argv[0]) ;
+      exit(EXIT_FAILURE) ;
+    }
+  }
+  if(optind < argc)
+    file = argv[optind] ;
+  
+  if((fd = open(file, O_RDONLY)) < 0 || fstat(fd, &st) < 0) {
+    perror(file) ;
+    exit(EXIT_FAILURE) ;
+  }
+  if(st.st_size < sizeof(struct trace_ring)) {
+    fprintf(stderr, "%s: not a trace file\n", file) ;
+    exit(EXIT_FAILURE) ;
+  }
+  ring = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0) ;
+  if(ring == MAP_FAILED) {
+    perror("mmap") ;
+    exit(EXIT_FAILURE) ;
+  }
+  if(ring->magic != TRACE_MAGIC || ring->version != TRACE_VERSION ||
+    ring->record_size != sizeof(struct trace_record) ||
+    ring->nb_records == 0 || (ring->nb_records & (ring->nb_records - 1)) ||
+    st.st_size < sizeof(struct trace_ring) +
+  (off_t)ring->nb_records * ring->record_size) {
+    fprintf(stderr, "%s: bad trace header\n", file) ;
+    exit(EXIT_FAILURE) ;
+  }
+  
+  if(csv)
+    printf("ts,type,addr,a,b,c\n") ;
+  
+  /* the ring may still be written by a running daemon: only records
+   whose seq matches their position, before and after the copy, are
+   complete (the writer clears seq, fills the record, then sets seq) */
+  head = ring->head ;
+  first = head > ring->nb_records ? head - ring->nb_records : 0 ;
+  for(pos = first ; pos < head ; pos++) {
+    slot = &ring->rec[pos & (ring->nb_records - 1)] ;
+    memcpy(&rec, slot, sizeof(rec)) ;
+    __sync_synchronize() ;
+    if(rec.seq != (u_int32_t)(pos + 1) ||
+      *(volatile u_int32_t *)&slot->seq != rec.seq)
+    continue ;
+    print_record(&rec, ring->realtime_offset_ns, csv) ;
+  }
+  
+  munmap(ring, st.st_size) ;
+  close(fd) ;
+  return 0 ;
+}
@@ -0,0 +1,173 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+/* fdd_vis.c - the (pid, gid) pairs in which a local process is visible,
+ * in an open addressing table. visibility_list_head keeps the same pairs
+ * ordered; the report builders only ask whether a pair is in, once per
+ * local process and jointly group. The table also holds one VIS_PROC
+ * slot per process of visibility_list_head, so that a process without
+ * entry can be told apart from one invisible in the group. */
+#include <errno.h>
+#include <stdlib.h>
+#include "fdd_vis.h"
+
+#define VIS_FREE    0
+#define VIS_USED    1
+#define VIS_DELETED 2
+#define VIS_PROC    3 /* the process pid has a visibility entry */
+
+struct vis_slot {
+  u_int pid ;
+  u_int gid ;
+  int state ;
+} ;
+
+static struct vis_slot *vis_slots = NULL ;
+static unsigned int vis_nb_slots = 0 ;
+static unsigned int vis_nb_used = 0 ;    /* VIS_USED and VIS_PROC slots */
+static unsigned int vis_nb_deleted = 0 ; /* VIS_DELETED slots */
+
+static inline unsigned int vis_hash(u_int pid, u_int gid,
+  unsigned int nb_slots) {
+  u_int64_t key = ((u_int64_t)pid << 32) | gid ;
+  
+  key *= 0x9e3779b97f4a7c15ULL ;
+  return (unsigned int)(key >> 32) & (nb_slots - 1) ;
+}
+
+/* returns the slot of the pair in the given state (VIS_USED or
+ VIS_PROC), or -1 if it is not in */
+static int vis_find(u_int pid, u_int gid, int state) {
+  unsigned int h ;
+  
+  if(vis_nb_slots == 0)
+    return -1 ;
+  for(h = vis_hash(pid, gid, vis_nb_slots) ; vis_slots[h].state != VIS_FREE ;
+    h = (h + 1) & (vis_nb_slots - 1)) {
+    if(vis_slots[h].state == state && vis_slots[h].pid == pid &&
+      vis_slots[h].gid == gid)
+      return h ;
+  }
+  return -1 ;
+}
+
+/* rebuilds the table with nb_slots slots, dropping the deleted ones */
+static int vis_resize(unsigned int nb_slots) {
+  struct vis_slot *slots ;
+  unsigned int i, h ;
+  
+  slots = calloc(nb_slots, sizeof(*slots)) ;
+  if(slots == NULL)
+    return -ENOMEM ;
+  
+  for(i = 0 ; i < vis_nb_slots ; i++) {
+    if(vis_slots[i].state != VIS_USED && vis_slots[i].state != VIS_PROC)
+      continue ;
+    h = vis_hash(vis_slots[i].pid, vis_slots[i].gid, nb_slots) ;
+    while(slots[h].state != VIS_FREE)
+      h = (h + 1) & (nb_slots - 1) ;
+    slots[h] = vis_slots[i] ;
+  }
+  
+  free(vis_slots) ;
+  vis_slots = slots ;
+  vis_nb_slots = nb_slots ;
+  vis_nb_deleted = 0 ;
+  return 0 ;
+}
+
+static int vis_insert(u_int pid, u_int gid, int state) {
+  unsigned int h, nb_slots ;
+  
+  if(vis_find(pid, gid, state) >= 0)
+    return 0 ;
+  
+  /* keep the table at most half full, deleted slots included */
+  if(2 * (vis_nb_used + vis_nb_deleted + 1) > vis_nb_slots) {
+    nb_slots = vis_nb_slots ? vis_nb_slots : VIS_MIN_SLOTS ;
+    while(4 * (vis_nb_used + 1) > nb_slots)
+      nb_slots *= 2 ;
+    if(vis_resize(nb_slots) < 0)
+      return -ENOMEM ;
+  }
+  
+  h = vis_hash(pid, gid, vis_nb_slots) ;
+  while(vis_slots[h].state == VIS_USED || vis_slots[h].state == VIS_PROC)
+    h = (h + 1) & (vis_nb_slots - 1) ;
+  if(vis_slots[h].state == VIS_DELETED)
+    vis_nb_deleted-- ;
+  vis_slots[h].pid = pid ;
+  vis_slots[h].gid = gid ;
+  vis_slots[h].state = state ;
+  vis_nb_used++ ;
+  return 0 ;
+}
+
+static void vis_remove(u_int pid, u_int gid, int state) {
+  int h = vis_find(pid, gid, state) ;
+  
+  if(h < 0)
+    return ;
+  vis_slots[h].state = VIS_DELETED ;
+  vis_nb_used-- ;
+  vis_nb_deleted++ ;
+}
+
+/* vis_add_proc - the process pid has a visibility entry. Returns 0 on
+ success, -ENOMEM otherwise */
+extern int vis_add_proc(u_int pid) {
+  return vis_insert(pid, 0, VIS_PROC) ;
+}
+
+/* vis_del_proc - the process pid no longer has a visibility entry */
+extern void vis_del_proc(u_int pid) {
+  vis_remove(pid, 0, VIS_PROC) ;
+}
+
+/* vis_add - the process pid is visible in the group gid. Returns 0 on
+ success, -ENOMEM otherwise */
+extern int vis_add(u_int pid, u_int gid) {
+  return vis_insert(pid, gid, VIS_USED) ;
+}
+
+/* vis_del - the process pid is no longer visible in the group gid */
+extern void vis_del(u_int pid, u_int gid) {
+  vis_remove(pid, gid, VIS_USED) ;
+}
+
+/* vis_test - tells whether the process pid is visible in the group gid:
+ VIS_VISIBLE if it is, VIS_INVISIBLE if the process is invisible in it,
+ VIS_ABSENT if the process has no visibility entry at all */
+extern int vis_test(u_int pid, u_int gid) {
+  if(vis_find(pid, gid, VIS_USED) >= 0)
+    return VIS_VISIBLE ;
+  if(vis_find(pid, 0, VIS_PROC) >= 0)
+    return VIS_INVISIBLE ;
+  return VIS_ABSENT ;
+}
+
+extern void vis_cleanup(void) {
+  free(vis_slots) ;
+  vis_slots = NULL ;
+  vis_nb_slots = 0 ;
+  vis_nb_used = 0 ;
+  vis_nb_deleted = 0 ;
+}
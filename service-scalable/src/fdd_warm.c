@@ -0,0 +1,154 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_warm.c - mmap'd network estimates of the hosts, kept across
+ * restarts. A host created again for an address whose estimates are
+ * recent enough starts monitoring right away with them, its variance
+ * inflated, instead of going through the INITIAL_ED stage: the estimates
+ * are then refined by the reports as usual. */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "fdd.h"
+#include "fdd_stats.h"
+#include "fdd_warm.h"
+#include "misc.h"
+
+#ifdef WARM_START
+
+static struct warm_file *warm_file = NULL ;
+
+/* warm_init - maps the estimates file, created empty if it does not
+ exist or is not understood. Returns 0 on success, -1 otherwise (the
+ daemon then always goes through the INITIAL_ED stage). */
+extern int warm_init(void) {
+  int fd ;
+  void *ptr ;
+  struct stat st ;
+  
+  /* in /tmp: a link put there by someone else is not followed */
+  fd = open(FDD_WARM_FILE, O_RDWR | O_CREAT | O_NOFOLLOW, 0644) ;
+  if(fd < 0) {
+    perror("fdd: could not open the warm start file") ;
+    return -1 ;
+  }
+  if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+    fprintf(stderr, "fdd: the warm start file is not a regular file\n") ;
+    close(fd) ;
+    return -1 ;
+  }
+  if(st.st_size != WARM_FILE_SIZE && ftruncate(fd, WARM_FILE_SIZE) < 0) {
+    perror("fdd: could not size the warm start file") ;
+    close(fd) ;
+    return -1 ;
+  }
+  ptr = mmap(NULL, WARM_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) ;
+  close(fd) ;
+  if(ptr == MAP_FAILED) {
+    perror("fdd: could not map the warm start file") ;
+    return -1 ;
+  }
+  
+  warm_file = ptr ;
+  if(warm_file->magic != WARM_MAGIC || warm_file->version != WARM_VERSION ||
+    warm_file->nb_entries != WARM_ENTRIES ||
+    warm_file->entry_size != sizeof(struct warm_entry)) {
+    memset(ptr, 0, WARM_FILE_SIZE) ;
+    warm_file->magic = WARM_MAGIC ;
+    warm_file->version = WARM_VERSION ;
+    warm_file->nb_entries = WARM_ENTRIES ;
+    warm_file->entry_size = sizeof(struct warm_entry) ;
+  }
+  return 0 ;
+}
+
+/* warm_cleanup - unmaps the file, it is kept for the next start */
+extern void warm_cleanup(void) {
+  if(!warm_file)
+    return ;
+  msync(warm_file, WARM_FILE_SIZE, MS_ASYNC) ;
+  munmap(warm_file, WARM_FILE_SIZE) ;
+  warm_file = NULL ;
+}
+
+/* the entry of the address among the WARM_PROBES slots following its
+ hash. If it has none and create is set, the first free slot or else the
+ least recently updated one is given to it. */
+static struct warm_entry *warm_locate(u_int32_t addr, int create) {
+  struct warm_entry *ent, *victim = NULL ;
+  u_int32_t h = addr * 2654435761u ;
+  int i ;
+  
+  for(i = 0 ; i < WARM_PROBES ; i++) {
+    ent = &warm_file->ent[(h + i) & (WARM_ENTRIES - 1)] ;
+    if(ent->addr == addr)
+      return ent ;
+    if(victim == NULL || (victim->addr != 0 &&
+      (ent->addr == 0 || ent->saved_sec < victim->saved_sec)))
+      victim = ent ;
+  }
+  if(!create)
+    return NULL ;
+  
+  memset(victim, 0, sizeof(*victim)) ;
+  victim->addr = addr ;
+  return victim ;
+}
+
+/* warm_seed - starts a new host with the recent estimates of its address.
+ Returns 1 if it needs no INITIAL_ED stage, 0 otherwise. */
+extern int warm_seed(struct host_struct *host, struct timeval *now) {
+  struct warm_entry *ent ;
+  
+  if(!warm_file)
+    return 0 ;
+  
+  ent = warm_locate(host->addr.sin_addr.s_addr, 0) ;
+  if(NULL == ent || ent->saved_sec > now->tv_sec ||
+    now->tv_sec - ent->saved_sec > WARM_MAX_AGE)
+    return 0 ;
+  
+  host->stats.est.e_d = ent->e_d ;
+  host->stats.est.v_d = ent->v_d * WARM_VAR_INFLATE ;
+  host->stats.est.pl = max(ent->pl, 1.0 / AVERAGE_DELAY_MAX_SAMPLES) ;
+  host->stats.local_initial_finished = FINISHED_YES ;
+  return 1 ;
+}
+
+/* warm_save - records the current estimates of a host */
+extern void warm_save(struct host_struct *host, struct timeval *now) {
+  struct warm_entry *ent ;
+  
+  if(!warm_file || host->stats.local_initial_finished != FINISHED_YES)
+    return ;
+  
+  ent = warm_locate(host->addr.sin_addr.s_addr, 1) ;
+  ent->e_d = host->stats.est.e_d ;
+  ent->v_d = host->stats.est.v_d ;
+  ent->pl = host->stats.est.pl ;
+  ent->saved_sec = now->tv_sec ;
+}
+
+#endif /* WARM_START */
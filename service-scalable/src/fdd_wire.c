@@ -0,0 +1,467 @@
+//  This file is part of a leader election service
+//  See http://www.inf.unisi.ch/phd/schiper/LeaderElection/
+//
+//  Author: Daniel Ivan and Nicolas Schiper
+//  Copyright (C) 2001-2006 Daniel Ivan and Nicolas Schiper
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+//  USA, or send email to nicolas.schiper@lu.unisi.ch.
+//
+
+/* fdd_wire.c - compact wire format of the report messages
+ *
+ * A compact report carries the same information as a report (see
+ * fdd_msg.h) with variable length fields. It is converted from and to
+ * the fixed format at the socket, so that the rest of the FDD only
+ * handles the fixed format.
+ *
+ *	4    bytes  type	(message type - MSG_REPORT_COMPACT)
+ *	1    byte   version	(WIRE_VERSION_COMPACT)
+ *	varint      present	(bitmap of the header fields that are not 0.
+ *		    Fields are left out when they are 0, not when they are
+ *		    unchanged since the previous report: the reports go over
+ *		    UDP and may be lost, so each one is decoded on its own)
+ *	varint      each present header field, in the order of the report
+ *		    header. The list lengths are not sent, they follow from
+ *		    the counts. The timestamps are in nanoseconds, the
+ *		    epochs absolute, the others relative to the sender's
+ *		    epoch (zigzag encoded).
+ * local servers processes list:
+ *	varint      pid		(zigzag delta with the previous pid)
+ * local groups list:
+ *	varint      gid		(zigzag delta with the previous gid)
+ *	varint      group_ts	(relative to the sender's epoch)
+ *	varint      eta_rcvd
+ *	varint      proc_count
+ *	varint      pid		(proc_count times, delta encoded)
+ * remote servers processes list:
+ *	varint      pid		(delta encoded)
+ * localvars list:
+ *	varint      gid		(delta encoded)
+ *	varint      accusationTime (relative to the sender's epoch)
+ *	varint      startTime      (relative to the sender's epoch)
+ * delta trailer, if the report has one (up to the end of the message):
+ *	varint      omitted
+ *	varint      acked_seq	(REP_LISTS times)
+ * accusations, if the report has some (up to the end of the message):
+ *	varint      accusations_count
+ *	varint      gid		(accusations_count times, delta encoded)
+ *	varint      startTime	(relative to the sender's epoch)
+ */
+#include <errno.h>
+#include "fdd.h"
+#include "fdd_wire.h"
+
+/* header fields, in the order of the report header */
+#define F_SENDING_TS          0
+#define F_SEQ                 1
+#define F_EPOCH               2
+#define F_REMOTE_EPOCH        3
+#define F_SERVERS_LIST_SEQ    4
+#define F_GROUPS_LIST_SEQ     5
+#define F_SERVERS_PROC_COUNT  6
+#define F_GROUPS_COUNT        7
+#define F_SENDINT             8
+#define F_VARS_COUNT          9
+#define F_CLIENTS_LIST_SEQ   10
+#define F_REMOTE_PROC_COUNT  11
+#define F_NEEDED_SENDINT     12
+#define F_LARGEST_GROUP_TS   13
+#define F_COUNT              14
+
+/* header fields that are timestamps relative to the epoch */
+#define F_RELATIVE ((1 << F_SENDING_TS) | (1 << F_LARGEST_GROUP_TS))
+#define F_TIMESTAMP (F_RELATIVE | (1 << F_EPOCH) | (1 << F_REMOTE_EPOCH))
+
+#define WIRE_CHECK(ptr, end) do { if((ptr) == NULL || (ptr) > (end)) \
+ goto out ; } while(0)
+
+/* writes a list of pid of the fixed message to the compact one */
+static char *compact_pid_list(char *ptr, char *out, char *out_end, int count,
+  int *retval) {
+  u_int pid ;
+  int64_t prev = 0 ;
+  int i ;
+  
+  for(i = 0 ; i < count ; i++) {
+    if(out + 10 > out_end) {
+      *retval = -EMSGSIZE ;
+      return NULL ;
+    }
+    ptr = msg_parse_rep_pid(ptr, &pid) ;
+    out = (char *)put_varint((unsigned char *)out, zigzag((int64_t)pid - prev)) ;
+    prev = pid ;
+  }
+  return out ;
+}
+
+/* reads a list of pid of the compact message to the fixed one */
+static char *expand_pid_list(char **pptr, char *end, char *out, char *out_end,
+  int count) {
+  u_int64_t val ;
+  int64_t pid = 0 ;
+  int i ;
+  
+  for(i = 0 ; i < count ; i++) {
+    *pptr = (char *)get_varint((unsigned char *)*pptr, (unsigned char *)end, &val) ;
+    if(*pptr == NULL || out + 4 > out_end)
+      return NULL ;
+    pid += unzigzag(val) ;
+    out = msg_build_rep_pid(out, (u_int)pid) ;
+  }
+  return out ;
+}
+
+/* msg_compact_report - converts the fixed format report msg to the compact
+ format in out. Returns the length of the compact message, -EMSGSIZE if it
+ does not fit in out_len, -EINVAL if msg is not consistent. */
+extern int msg_compact_report(char *msg, int msg_len, char *out, int out_len) {
+  char *end     = msg + msg_len ;
+  char *out_end = out + out_len ;
+  char *ptr, *ptr_list, *ptr_delta, *ptr_accusations, *optr ;
+  
+  struct timeval tv[F_COUNT] ;
+  u_int f[F_COUNT] ;
+  u_int servers_list_len, remote_servers_list_len ;
+  u_int omitted, acked_seq[REP_LISTS] ;
+  u_int accusations_count ;
+  u_int64_t present = 0 ;
+  int64_t epoch_ns ;
+  int64_t prev_gid ;
+  
+  u_int gid, eta_rcvd ;
+  int procs_count ;
+  struct timeval group_ts, accusationTime, startTime ;
+  int i ;
+  int retval = -EINVAL ;
+  
+  if(msg_skip_rep_head(msg) > end)
+    goto out ;
+  
+  ptr = msg_parse_rep_head(msg, &tv[F_SENDING_TS], &f[F_SEQ],
+    &tv[F_EPOCH], &tv[F_REMOTE_EPOCH],
+    
+    &f[F_SERVERS_LIST_SEQ], &f[F_GROUPS_LIST_SEQ],
+    &servers_list_len, &f[F_SERVERS_PROC_COUNT],
+    &f[F_GROUPS_COUNT], &f[F_SENDINT], &f[F_VARS_COUNT],
+    
+    &f[F_CLIENTS_LIST_SEQ], &remote_servers_list_len,
+    &f[F_REMOTE_PROC_COUNT], &f[F_NEEDED_SENDINT],
+  &tv[F_LARGEST_GROUP_TS]) ;
+  
+  ptr_delta = ptr + servers_list_len + remote_servers_list_len +
+  f[F_VARS_COUNT] * REP_LOCALVARS_LEN ;
+  if((ptr_delta != end && ptr_delta + REP_DELTA_LEN > end) ||
+    f[F_SERVERS_PROC_COUNT] * sizeof(int) > servers_list_len)
+    goto out ;
+  
+  ptr_accusations = ptr_delta == end ? end : ptr_delta + REP_DELTA_LEN ;
+  accusations_count = 0 ;
+  if(ptr_accusations != end) {
+    if(ptr_accusations + 4 > end ||
+      (end - ptr_accusations - 4) % REP_ACCUSATION_LEN)
+      goto out ;
+    msg_parse_rep_accusations_count(ptr_accusations, &accusations_count) ;
+    if(accusations_count != (end - ptr_accusations - 4) / REP_ACCUSATION_LEN)
+      goto out ;
+  }
+  
+  epoch_ns = wire_tv2ns(&tv[F_EPOCH]) ;
+  for(i = 0 ; i < F_COUNT ; i++) {
+    if(F_TIMESTAMP & (1 << i) ? timerisset(&tv[i]) : f[i] != 0)
+      present |= 1 << i ;
+  }
+  
+  retval = -EMSGSIZE ;
+  if(out + 4 + 1 + F_COUNT * 10 > out_end)
+    goto out ;
+  
+  optr = out ;
+  put32((unsigned char *)optr, (unsigned int)MSG_REPORT_COMPACT) ; optr += 4 ;
+  *optr++ = WIRE_VERSION_COMPACT ;
+  optr = (char *)put_varint((unsigned char *)optr, present) ;
+  for(i = 0 ; i < F_COUNT ; i++) {
+    if(!(present & (1 << i)))
+      continue ;
+    if(F_RELATIVE & (1 << i))
+      optr = (char *)put_varint((unsigned char *)optr,
+      zigzag(wire_tv2ns(&tv[i]) - epoch_ns)) ;
+    else if(F_TIMESTAMP & (1 << i))
+      optr = (char *)put_varint((unsigned char *)optr, wire_tv2ns(&tv[i])) ;
+    else
+      optr = (char *)put_varint((unsigned char *)optr, f[i]) ;
+  }
+  
+  /* local servers */
+  optr = compact_pid_list(ptr, optr, out_end, f[F_SERVERS_PROC_COUNT], &retval) ;
+  if(NULL == optr)
+    goto out ;
+  ptr += f[F_SERVERS_PROC_COUNT] * sizeof(int) ;
+  
+  /* local groups */
+  prev_gid = 0 ;
+  for(i = 0 ; i < f[F_GROUPS_COUNT] ; i++) {
+    retval = -EINVAL ;
+    if(msg_skip_rep_ghead(ptr) > end)
+      goto out ;
+    ptr = msg_parse_rep_ghead(ptr, &gid, &group_ts, &eta_rcvd, &procs_count) ;
+    if(procs_count < 0 || ptr + procs_count * sizeof(int) > end)
+      goto out ;
+    
+    retval = -EMSGSIZE ;
+    if(optr + 4 * 10 > out_end)
+      goto out ;
+    optr = (char *)put_varint((unsigned char *)optr, zigzag((int64_t)gid - prev_gid)) ;
+    optr = (char *)put_varint((unsigned char *)optr,
+    zigzag(wire_tv2ns(&group_ts) - epoch_ns)) ;
+    optr = (char *)put_varint((unsigned char *)optr, eta_rcvd) ;
+    optr = (char *)put_varint((unsigned char *)optr, procs_count) ;
+    prev_gid = gid ;
+    
+    optr = compact_pid_list(ptr, optr, out_end, procs_count, &retval) ;
+    if(NULL == optr)
+      goto out ;
+    ptr += procs_count * sizeof(int) ;
+  }
+  
+  retval = -EINVAL ;
+  ptr_list = msg_skip_rep_head(msg) ;
+  if(ptr != ptr_list + servers_list_len)
+    goto out ;
+  
+  /* remote servers */
+  if(ptr + f[F_REMOTE_PROC_COUNT] * sizeof(int) > end)
+    goto out ;
+  optr = compact_pid_list(ptr, optr, out_end, f[F_REMOTE_PROC_COUNT], &retval) ;
+  if(NULL == optr)
+    goto out ;
+  ptr += f[F_REMOTE_PROC_COUNT] * sizeof(int) ;
+  
+  retval = -EINVAL ;
+  if(ptr != ptr_list + servers_list_len + remote_servers_list_len)
+    goto out ;
+  
+  /* localvars */
+  prev_gid = 0 ;
+  for(i = 0 ; i < f[F_VARS_COUNT] ; i++) {
+    retval = -EMSGSIZE ;
+    if(optr + 3 * 10 > out_end)
+      goto out ;
+    ptr = msg_parse_rep_localvars(ptr, &gid, &accusationTime, &startTime) ;
+    optr = (char *)put_varint((unsigned char *)optr, zigzag((int64_t)gid - prev_gid)) ;
+    optr = (char *)put_varint((unsigned char *)optr,
+    zigzag(wire_tv2ns(&accusationTime) - epoch_ns)) ;
+    optr = (char *)put_varint((unsigned char *)optr,
+    zigzag(wire_tv2ns(&startTime) - epoch_ns)) ;
+    prev_gid = gid ;
+  }
+  
+  if(ptr_delta != end) {
+    retval = -EMSGSIZE ;
+    if(optr + (1 + REP_LISTS) * 10 > out_end)
+      goto out ;
+    msg_parse_rep_delta(ptr_delta, &omitted, acked_seq) ;
+    optr = (char *)put_varint((unsigned char *)optr, omitted) ;
+    for(i = 0 ; i < REP_LISTS ; i++)
+      optr = (char *)put_varint((unsigned char *)optr, acked_seq[i]) ;
+  }
+  
+  if(ptr_accusations != end) {
+    retval = -EMSGSIZE ;
+    if(optr + (1 + 2 * accusations_count) * 10 > out_end)
+      goto out ;
+    optr = (char *)put_varint((unsigned char *)optr, accusations_count) ;
+    ptr = ptr_accusations + 4 ;
+    prev_gid = 0 ;
+    for(i = 0 ; i < accusations_count ; i++) {
+      ptr = msg_parse_rep_accusation(ptr, &gid, &startTime) ;
+      optr = (char *)put_varint((unsigned char *)optr, zigzag(gid - prev_gid)) ;
+      optr = (char *)put_varint((unsigned char *)optr,
+      zigzag(wire_tv2ns(&startTime) - epoch_ns)) ;
+      prev_gid = gid ;
+    }
+  }
+  
+  retval = optr - out ;
+  out:
+  return retval ;
+}
+
+/* msg_expand_report - converts the compact report msg to the fixed format
+ in out. Returns the length of the fixed message, -EMSGSIZE if it does not
+ fit in out_len, -EINVAL if msg is truncated or of an unknown version. */
+extern int msg_expand_report(char *msg, int msg_len, char *out, int out_len) {
+  char *end     = msg + msg_len ;
+  char *out_end = out + out_len ;
+  char *ptr, *optr, *optr_list, *optr_remote ;
+  
+  struct timeval tv[F_COUNT] ;
+  u_int f[F_COUNT] ;
+  u_int64_t present, val ;
+  int64_t epoch_ns ;
+  int64_t gid ;
+  
+  struct timeval group_ts, accusationTime, startTime ;
+  u_int64_t eta_rcvd, procs_count ;
+  int i ;
+  int retval = -EINVAL ;
+  
+  ptr = msg + 4 ;
+  if(ptr + 1 > end || *ptr++ != WIRE_VERSION_COMPACT)
+    goto out ;
+  
+  ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &present) ;
+  WIRE_CHECK(ptr, end) ;
+  
+  /* the epoch is needed by the relative timestamps before it */
+  memset(f, 0, sizeof(f)) ;
+  memset(tv, 0, sizeof(tv)) ;
+  epoch_ns = 0 ;
+  {
+    u_int64_t raw[F_COUNT] ;
+    
+    for(i = 0 ; i < F_COUNT ; i++) {
+      raw[i] = 0 ;
+      if(!(present & (1 << i)))
+        continue ;
+      ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &raw[i]) ;
+      WIRE_CHECK(ptr, end) ;
+    }
+    epoch_ns = raw[F_EPOCH] ;
+    for(i = 0 ; i < F_COUNT ; i++) {
+      if(!(present & (1 << i)))
+        continue ;
+      if(F_RELATIVE & (1 << i))
+        wire_ns2tv(epoch_ns + unzigzag(raw[i]), &tv[i]) ;
+      else if(F_TIMESTAMP & (1 << i))
+        wire_ns2tv(raw[i], &tv[i]) ;
+      else
+        f[i] = raw[i] ;
+    }
+  }
+  
+  retval = -EMSGSIZE ;
+  optr = msg_skip_rep_head(out) ;
+  if(optr > out_end)
+    goto out ;
+  optr_list = optr ;
+  
+  retval = -EINVAL ;
+  /* local servers */
+  optr = expand_pid_list(&ptr, end, optr, out_end, f[F_SERVERS_PROC_COUNT]) ;
+  WIRE_CHECK(optr, out_end) ;
+  
+  /* local groups */
+  gid = 0 ;
+  for(i = 0 ; i < f[F_GROUPS_COUNT] ; i++) {
+    ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &val) ;
+    WIRE_CHECK(ptr, end) ;
+    gid += unzigzag(val) ;
+    ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &val) ;
+    WIRE_CHECK(ptr, end) ;
+    wire_ns2tv(epoch_ns + unzigzag(val), &group_ts) ;
+    ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &eta_rcvd) ;
+    WIRE_CHECK(ptr, end) ;
+    ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &procs_count) ;
+    WIRE_CHECK(ptr, end) ;
+    
+    if(msg_skip_rep_ghead(optr) > out_end)
+      goto out ;
+    optr = msg_build_rep_ghead(optr, (u_int)gid, &group_ts, (u_int)eta_rcvd,
+    (int)procs_count) ;
+    optr = expand_pid_list(&ptr, end, optr, out_end, procs_count) ;
+    WIRE_CHECK(optr, out_end) ;
+  }
+  
+  /* remote servers */
+  optr_remote = optr ;
+  optr = expand_pid_list(&ptr, end, optr, out_end, f[F_REMOTE_PROC_COUNT]) ;
+  WIRE_CHECK(optr, out_end) ;
+  
+  msg_build_rep_head(out, &tv[F_SENDING_TS], f[F_SEQ],
+    &tv[F_EPOCH], &tv[F_REMOTE_EPOCH],
+    
+    f[F_SERVERS_LIST_SEQ], f[F_GROUPS_LIST_SEQ],
+    optr_remote - optr_list, f[F_SERVERS_PROC_COUNT],
+    f[F_GROUPS_COUNT], f[F_SENDINT], f[F_VARS_COUNT],
+    
+    f[F_CLIENTS_LIST_SEQ], optr - optr_remote,
+    f[F_REMOTE_PROC_COUNT], f[F_NEEDED_SENDINT],
+  &tv[F_LARGEST_GROUP_TS]) ;
+  
+  /* localvars */
+  gid = 0 ;
+  for(i = 0 ; i < f[F_VARS_COUNT] ; i++) {
+    ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &val) ;
+    WIRE_CHECK(ptr, end) ;
+    gid += unzigzag(val) ;
+    ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &val) ;
+    WIRE_CHECK(ptr, end) ;
+    wire_ns2tv(epoch_ns + unzigzag(val), &accusationTime) ;
+    ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &val) ;
+    WIRE_CHECK(ptr, end) ;
+    wire_ns2tv(epoch_ns + unzigzag(val), &startTime) ;
+    
+    retval = -EMSGSIZE ;
+    if(optr + REP_LOCALVARS_LEN > out_end)
+      goto out ;
+    retval = -EINVAL ;
+    optr = msg_build_rep_localvars(optr, (u_int)gid, &accusationTime, &startTime) ;
+  }
+  
+  if(ptr < end) {
+    u_int delta[1 + REP_LISTS] ;
+    
+    for(i = 0 ; i < 1 + REP_LISTS ; i++) {
+      ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &val) ;
+      WIRE_CHECK(ptr, end) ;
+      delta[i] = (u_int)val ;
+    }
+    retval = -EMSGSIZE ;
+    if(optr + REP_DELTA_LEN > out_end)
+      goto out ;
+    optr = msg_build_rep_delta(optr, delta[0], delta + 1) ;
+  }
+  
+  if(ptr < end) {
+    u_int64_t accusations_count ;
+    
+    ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end,
+    &accusations_count) ;
+    WIRE_CHECK(ptr, end) ;
+    /* each accusation takes at least two bytes */
+    if(accusations_count > (u_int64_t)(end - ptr) / 2)
+      goto out ;
+    retval = -EMSGSIZE ;
+    if(optr + 4 + accusations_count * REP_ACCUSATION_LEN > out_end)
+      goto out ;
+    retval = -EINVAL ;
+    optr = msg_build_rep_accusations_count(optr, (u_int)accusations_count) ;
+    gid = 0 ;
+    while(accusations_count--) {
+      ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &val) ;
+      WIRE_CHECK(ptr, end) ;
+      gid += unzigzag(val) ;
+      ptr = (char *)get_varint((unsigned char *)ptr, (unsigned char *)end, &val) ;
+      WIRE_CHECK(ptr, end) ;
+      wire_ns2tv(epoch_ns + unzigzag(val), &startTime) ;
+      optr = msg_build_rep_accusation(optr, (u_int)gid, &startTime) ;
+    }
+  }
+  
+  retval = optr - out ;
+  out:
+  return retval ;
+}
@@ -27,6 +27,8 @@
 #include "misc.h"
 #include "variables_exchange.h"
 #include "pipe.h"
+#include "fdd_trace.h"
+#include "fdd_metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <netinet/in.h>
@@ -45,13 +47,26 @@ struct list_head globalLeader_head;
 /* The list of list of global contenders (one list per group) */
 struct list_head globalContenders_head;
 
+/* The groups whose global leader has to be recomputed, sorted by gid */
+struct list_head dirtyLeaders_head;
+
+/* The classes of the global contenders sets, see struct contender_class,
+ hashed on their sig */
+#define CONTENDER_CLASS_BUCKETS 1024 /* a power of two */
+static struct list_head contenderClasses_table[CONTENDER_CLASS_BUCKETS];
+
 
 int omega_algorithm_init() {
   
+  int i;
+  
   INIT_LIST_HEAD(&(localLeader_head));
   INIT_LIST_HEAD(&(localContenders_head));
   INIT_LIST_HEAD(&(globalLeader_head));
   INIT_LIST_HEAD(&(globalContenders_head));
+  INIT_LIST_HEAD(&(dirtyLeaders_head));
+  for (i = 0; i < CONTENDER_CLASS_BUCKETS; i++)
+    INIT_LIST_HEAD(&(contenderClasses_table[i]));
   
   return 0;
 }
@@ -74,8 +89,10 @@ inline int add_proc_in_localContenders_set(struct sockaddr_in *addr, u_int pid,
   
   if (entry_ptr == NULL)
     return -1;
-  else if (!entry_exists)
+  else if (!entry_exists) {
     INIT_LIST_HEAD(&entry_ptr->procs_list);
+    entry_ptr->cclass = NULL;
+  }
   
   list_for_each(tmp_head, &entry_ptr->procs_list) {
     tmp_proc = list_entry(tmp_head, struct proc_struct, proc_list);
@@ -139,13 +156,17 @@ inline int add_or_replace_locaLeader_in_globalContenders_set(u_int pid, u_int gi
   
   if (entry_ptr == NULL)
     return -1;
-  else if (!entry_exists)
+  else if (!entry_exists) {
     INIT_LIST_HEAD(&entry_ptr->procs_list);
+    entry_ptr->cclass = NULL;
+  }
   
   list_for_each(tmp_head, &entry_ptr->procs_list) {
     tmp_proc = list_entry(tmp_head, struct proc_struct, proc_list);
     if (is_local_address(&tmp_proc->addr)) {
       found_proc = 1;
+      if (tmp_proc->pid != pid)
+        contenders_release_class(entry_ptr);
       tmp_proc->pid = pid;
       break;
     }
@@ -158,12 +179,15 @@ inline int add_or_replace_locaLeader_in_globalContenders_set(u_int pid, u_int gi
       tmp_proc->pid = pid;
       memcpy(&tmp_proc->addr, &omega_localaddr, sizeof(struct sockaddr_in));
       list_add_tail(&(tmp_proc->proc_list), &entry_ptr->procs_list);
+      contenders_release_class(entry_ptr);
     }
   }
   return 0;
 }
 
 
+/* Returns 1 if the process was added to the contenders set of group gid,
+ 0 if it was already there and -1 on error. */
 inline int add_proc_in_globalContenders_set(struct sockaddr_in *addr, u_int pid, u_int gid) {
   
   struct contenders_struct *entry_ptr = NULL;
@@ -176,8 +200,10 @@ inline int add_proc_in_globalContenders_set(struct sockaddr_in *addr, u_int pid,
   
   if (entry_ptr == NULL)
     return -1;
-  else if (!entry_exists)
+  else if (!entry_exists) {
     INIT_LIST_HEAD(&entry_ptr->procs_list);
+    entry_ptr->cclass = NULL;
+  }
   
   list_for_each(tmp_head, &entry_ptr->procs_list) {
     tmp_proc = list_entry(tmp_head, struct proc_struct, proc_list);
@@ -194,6 +220,8 @@ inline int add_proc_in_globalContenders_set(struct sockaddr_in *addr, u_int pid,
       tmp_proc->pid = pid;
       memcpy(&tmp_proc->addr, addr, sizeof(struct sockaddr_in));
       list_add_tail(&(tmp_proc->proc_list), &entry_ptr->procs_list);
+      contenders_release_class(entry_ptr);
+      return 1;
     }
   }
   return 0;
@@ -216,6 +244,7 @@ inline int remove_proc_from_globalContenders_set(struct sockaddr_in *addr, u_int
           (pid == tmp_proc->pid)) {
           list_del(&tmp_proc->proc_list);
           free(tmp_proc);
+          contenders_release_class(tmp_contenders);
           return 0;
         }
       }
@@ -228,12 +257,125 @@ inline int remove_proc_from_globalContenders_set(struct sockaddr_in *addr, u_int
 }
 
 
+/* Drops the class of a global contenders set, whose processes changed.
+ The class is freed with its last set. */
+void contenders_release_class(struct contenders_struct *contenders) {
+  
+  struct contender_class *cclass = contenders->cclass;
+  
+  if (cclass == NULL)
+    return;
+  contenders->cclass = NULL;
+  if (--cclass->refcount == 0) {
+    list_del(&cclass->class_list);
+    free(cclass->procs);
+    free(cclass);
+  }
+}
+
+/* Orders the processes of a class by address, then pid, so that a set
+ has one class whatever the order its processes joined in. */
+static int class_proc_cmp(const void *a, const void *b) {
+  
+  struct class_proc_struct *p1 = (struct class_proc_struct *)a;
+  struct class_proc_struct *p2 = (struct class_proc_struct *)b;
+  
+  if (!sockaddr_eq(&p1->addr, &p2->addr))
+    return sockaddr_smaller(&p1->addr, &p2->addr) ? -1 : 1;
+  if (p1->pid != p2->pid)
+    return (p1->pid < p2->pid) ? -1 : 1;
+  return 0;
+}
+
+/* Returns 1 if the class holds the processes procs, sorted by
+ class_proc_cmp. */
+static int class_matches(struct contender_class *cclass, struct class_proc_struct *procs,
+  u_int32_t sig, int nb_procs) {
+  
+  int i;
+  
+  if ((cclass->sig != sig) || (cclass->nb_procs != nb_procs))
+    return 0;
+  for (i = 0; i < nb_procs; i++) {
+    if ((cclass->procs[i].pid != procs[i].pid) ||
+      !sockaddr_eq(&cclass->procs[i].addr, &procs[i].addr))
+    return 0;
+  }
+  return 1;
+}
+
+/* Returns the class of a global contenders set, looked up or created the
+ first time it is needed after a change of the set. Returns NULL if out
+ of memory. */
+static struct contender_class *contenders_class(struct contenders_struct *contenders) {
+  
+  struct contender_class *cclass;
+  struct class_proc_struct *procs;
+  struct proc_struct *tmp_proc;
+  struct list_head *tmp_head, *bucket;
+  u_int32_t sig = 2166136261u;
+  int nb_procs = 0, i = 0;
+  
+  if (contenders->cclass != NULL)
+    return contenders->cclass;
+  
+  list_for_each(tmp_head, &contenders->procs_list)
+    nb_procs++;
+  
+  /* The sorted processes, kept as the procs of the class if it is new */
+  procs = malloc((nb_procs ? nb_procs : 1) * sizeof(*procs));
+  if (procs == NULL)
+    return NULL;
+  list_for_each(tmp_head, &contenders->procs_list) {
+    tmp_proc = list_entry(tmp_head, struct proc_struct, proc_list);
+    memcpy(&procs[i].addr, &tmp_proc->addr, sizeof(struct sockaddr_in));
+    procs[i].pid = tmp_proc->pid;
+    i++;
+  }
+  qsort(procs, nb_procs, sizeof(*procs), class_proc_cmp);
+  for (i = 0; i < nb_procs; i++) {
+    sig = (sig ^ procs[i].addr.sin_addr.s_addr) * 16777619u;
+    sig = (sig ^ procs[i].pid) * 16777619u;
+  }
+  
+  bucket = &contenderClasses_table[sig & (CONTENDER_CLASS_BUCKETS - 1)];
+  list_for_each(tmp_head, bucket) {
+    cclass = list_entry(tmp_head, struct contender_class, class_list);
+    if (class_matches(cclass, procs, sig, nb_procs)) {
+      free(procs);
+      cclass->refcount++;
+      contenders->cclass = cclass;
+      return cclass;
+    }
+  }
+  
+  cclass = malloc(sizeof(*cclass));
+  if (cclass == NULL) {
+    free(procs);
+    return NULL;
+  }
+  cclass->procs = procs;
+  cclass->sig = sig;
+  cclass->nb_procs = nb_procs;
+  cclass->nb_remote = 0;
+  for (i = 0; i < nb_procs; i++) {
+    procs[i].local = is_local_address(&procs[i].addr);
+    if (!procs[i].local)
+      cclass->nb_remote++;
+  }
+  cclass->refcount = 1;
+  list_add(&cclass->class_list, bucket);
+  contenders->cclass = cclass;
+  return cclass;
+}
+
+
 /* Returns 1 if the proc is "smaller" than the current temporary leader, 0 otherwise.
 To determine which one is the smallest, we proceed in the following way:
 1) compare their accusationTime variable, if they are equal goto 2)
  2) compare their IP address. */
 static inline int compare_procs(struct leaders_struct *temp_newleader, struct timeval *newleader_accusationTime,
-  struct proc_struct *proc, struct timeval *proc_accusationTime) {
+  struct class_proc_struct *proc, struct timeval *proc_accusationTime) {
   if (timercmp(proc_accusationTime, newleader_accusationTime, <))
     return 1;
   else if (timercmp(proc_accusationTime, newleader_accusationTime, ==)) {
@@ -330,20 +472,20 @@ inline int updateLocalLeader(unsigned int gid, struct timeval *now) {
       }
     }
     
-    list_for_each(tmp_head1, &localregistered_proc_head) {
-      rproc = list_entry(tmp_head1, struct localregistered_proc_struct, localproc_list);
-      list_for_each(tmp_head2, &rproc->notif_type_list) {
-        tmp_notif = list_entry(tmp_head2, struct notif_type_struct, notif_type_list);
-        if ((tmp_notif->notif_type == OMEGA_INTERRUPT_ANY_CHANGE) &&
-          (!tmp_notif->already_notified)) {
-          msg_omega_build_notify(msg, &globalLeader->addr, globalLeader->pid, globalLeader->gid,
-          globalLeader->stable);
-          
-          if (write_msg(rproc->omega_int_fd, msg, OMEGA_FIFO_MSG_LEN) < 0)
-            fprintf(stderr, "omega updateLocalLeader: error while writing to interrupt pipe\n");
-          else
-            tmp_notif->already_notified = 1;
-        }
+    /* the notification carries the leader of gid: only the processes
+     in gid are told about it */
+    list_for_each(tmp_head1, omega_group_notifs(gid)) {
+      tmp_notif = list_entry(tmp_head1, struct notif_type_struct, group_list);
+      rproc = tmp_notif->rproc;
+      if ((tmp_notif->notif_type == OMEGA_INTERRUPT_ANY_CHANGE) &&
+        (!tmp_notif->already_notified)) {
+        msg_omega_build_notify(msg, &globalLeader->addr, globalLeader->pid, globalLeader->gid,
+        globalLeader->stable);
+        
+        if (write_msg(rproc->omega_int_fd, msg, OMEGA_FIFO_MSG_LEN) < 0)
+          fprintf(stderr, "omega updateLocalLeader: error while writing to interrupt pipe\n");
+        else
+          tmp_notif->already_notified = 1;
       }
     }
   }
@@ -351,33 +493,79 @@ inline int updateLocalLeader(unsigned int gid, struct timeval *now) {
   return 0;
 }
 
-int updateGlobalLeaders(struct timeval *now) {
+/* Records that the leader of group gid may have changed. The leader is
+ recomputed once, by updateDirtyGlobalLeaders(), whatever the number of
+ reports that touched the group in the meantime. */
+int mark_global_leader_dirty(unsigned int gid) {
   
-  struct contenders_struct *tmp_contenders;
-  struct list_head *tmp_head;
+  struct dirty_group_struct *entry_ptr = NULL;
+  int entry_exists;
   
-  list_for_each(tmp_head, &globalContenders_head) {
-    tmp_contenders = list_entry(tmp_head, struct contenders_struct, contenders_list);
-    if (updateGlobalLeader(tmp_contenders->gid, now) < 0)
-      return -1;
-  }
+  list_insert_ordered(gid, gid, &dirtyLeaders_head, struct dirty_group_struct, dirty_list, <);
+  
+  if (entry_ptr == NULL)
+    return -1;
   return 0;
 }
 
+/* Recomputes the leader of the groups marked dirty that still have a
+ contenders set. Both lists are sorted by gid. A group stays dirty until
+ all its ANY_CHANGE notifications are written: it is left on the list and
+ tried again at the next loop iteration. */
+int updateDirtyGlobalLeaders(struct timeval *now) {
+  
+  struct dirty_group_struct *tmp_dirty;
+  struct contenders_struct *tmp_contenders;
+  struct list_head *tmp_head1, *next_head1, *tmp_head2;
+  int retval = 0, updated;
+  
+  tmp_head2 = globalContenders_head.next;
+  for (tmp_head1 = dirtyLeaders_head.next; tmp_head1 != &dirtyLeaders_head;
+    tmp_head1 = next_head1) {
+    next_head1 = tmp_head1->next;
+    tmp_dirty = list_entry(tmp_head1, struct dirty_group_struct, dirty_list);
+    
+    while (tmp_head2 != &globalContenders_head) {
+      tmp_contenders = list_entry(tmp_head2, struct contenders_struct, contenders_list);
+      if (tmp_contenders->gid >= tmp_dirty->gid)
+        break;
+      tmp_head2 = tmp_head2->next;
+    }
+    if (tmp_head2 != &globalContenders_head) {
+      tmp_contenders = list_entry(tmp_head2, struct contenders_struct, contenders_list);
+      if (tmp_contenders->gid == tmp_dirty->gid) {
+        updated = updateGlobalLeader(tmp_dirty->gid, now);
+        if (updated < 0)
+          retval = -1;
+        else if (updated > 0) /* a notification is still to be written */
+          continue;
+      }
+    }
+    
+    list_del(&tmp_dirty->dirty_list);
+    free(tmp_dirty);
+  }
+  return retval;
+}
+
+/* Returns 0 on success, 1 if a notification couldn't be written (the
+ group is then marked dirty, to try again) and -1 on error. */
 inline int updateGlobalLeader(unsigned int gid, struct timeval *now) {
   
   struct leaders_struct *globalLeader = NULL, *newGlobalLeader, *tmp_leader;
   struct contenders_struct *tmp_globalContenders;
-  struct proc_struct *tmp_proc;
-  struct list_head *tmp_head1, *tmp_head2, *tmp_head3;
-  struct timeval accusationTime1, accusationTime2;
-  int globalLeader_found = 0;
+  struct contender_class *cclass;
+  struct class_proc_struct *tmp_proc;
+  struct list_head *tmp_head1, *tmp_head2;
+  struct timeval accusationTime1, accusationTime2, localAccusationTime;
+  int globalLeader_found = 0, local_accusationTime_read = 0, i;
   struct localregistered_proc_struct *rproc;
   struct notif_type_struct *tmp_notif;
   char msg[OMEGA_FIFO_MSG_LEN];
   int nb_remote_proc_in_contenders = 0;
   int addr_changed, pid_changed, stability_changed,
-  leader_changed;
+  leader_changed, retval = 0;
+  u_int64_t update_start_ns = metrics_now_ns();
   
   
   /* Update the leader for group gid */
@@ -415,111 +603,51 @@ inline int updateGlobalLeader(unsigned int gid, struct timeval *now) {
   newGlobalLeader->pid = 0; /* leader address and pid not yet assigned */
   memset(&newGlobalLeader->addr, 0x0, sizeof(struct sockaddr_in));
   
-  /* Get the newGlobalLeader */
+  /* Get the newGlobalLeader. The contenders come from the class of the
+   set: only the accusationTimes, which are per group, are read here. */
   list_for_each(tmp_head2, &globalContenders_head) {
     tmp_globalContenders = list_entry(tmp_head2, struct contenders_struct, contenders_list);
     if (tmp_globalContenders->gid < gid)
       continue;
     else if (tmp_globalContenders->gid == gid) {
-      
-      list_for_each(tmp_head3, &tmp_globalContenders->procs_list) {
-        struct timeval startT, accT;
-        
-        tmp_proc = list_entry(tmp_head3, struct proc_struct, proc_list);
-        
-        if (is_local_address(&tmp_proc->addr))
-          getlocalvars(gid, &accT, &startT);
-        else {
-          get_accusationTime_of_remoteprocess(&tmp_proc->addr, gid, &accT);
-          get_startTime_of_remoteprocess(&tmp_proc->addr, gid, &startT);
-        }
+      cclass = contenders_class(tmp_globalContenders);
+      if (cclass == NULL) {
+        fprintf(stderr, "updateGlobalLeader: error couldn't allocate memory for the contenders class of group: %u\n",
+        gid);
+        free(newGlobalLeader);
+        return -1;
       }
+      nb_remote_proc_in_contenders = cclass->nb_remote;
       
-      list_for_each(tmp_head3, &tmp_globalContenders->procs_list) {
-        tmp_proc = list_entry(tmp_head3, struct proc_struct, proc_list);
-        /* The process is local */
-        if (is_local_address(&tmp_proc->addr)) {
-          if (getlocalaccusationTime(gid, &accusationTime1) < 0) {
-            free(newGlobalLeader);
-            fprintf(stderr, "updateGlobalLeader: error couldn't find local accusationTime for group: %u\n", gid);
-            return -1;
-          }
-          else {
-            if (newGlobalLeader->pid == 0) { /* temporary new leader not yet initialized */
-              newGlobalLeader->pid = tmp_proc->pid;
-              memcpy(&newGlobalLeader->addr, &tmp_proc->addr, sizeof(struct sockaddr_in));
-            }
-            else if (is_local_address(&newGlobalLeader->addr)) { /* temporary new global leader is local */
-              if (getlocalaccusationTime(gid, &accusationTime2) < 0) {
-                fprintf(stderr, "updateGlobalLeader: error couldn't find local accusationTime for gid: %u\n", gid);
-                free(newGlobalLeader);
-                return -1;
-              }
-              else {
-                if(compare_procs(newGlobalLeader, &accusationTime2, tmp_proc, &accusationTime1)) {
-                  newGlobalLeader->pid = tmp_proc->pid;
-                  memcpy(&newGlobalLeader->addr, &tmp_proc->addr, sizeof(struct sockaddr_in));
-                }
-              }
-            }
-            else { /* temporary new global leader is remote */
-              if (get_accusationTime_of_remoteprocess(&newGlobalLeader->addr, gid, &accusationTime2) < 0) {
-                fprintf(stderr, "updateGlobalLeader: error couldn't find remote accusationTimeu for group: %u and addr: %u.%u.%u.%u\n",
-                gid, NIPQUAD(&newGlobalLeader->addr));
-                free(newGlobalLeader);
-                return -1;
-              }
-              else {
-                if(compare_procs(newGlobalLeader, &accusationTime2, tmp_proc, &accusationTime1)) {
-                  newGlobalLeader->pid = tmp_proc->pid;
-                  memcpy(&newGlobalLeader->addr, &tmp_proc->addr, sizeof(struct sockaddr_in));
-                }
-              }
+      for (i = 0; i < cclass->nb_procs; i++) {
+        tmp_proc = &cclass->procs[i];
+        /* The process is local, all the local contenders share the
+         accusationTime of the group */
+        if (tmp_proc->local) {
+          if (!local_accusationTime_read) {
+            if (getlocalaccusationTime(gid, &localAccusationTime) < 0) {
+              free(newGlobalLeader);
+              fprintf(stderr, "updateGlobalLeader: error couldn't find local accusationTime for group: %u\n", gid);
+              return -1;
             }
+            local_accusationTime_read = 1;
           }
+          memcpy(&accusationTime1, &localAccusationTime, sizeof(struct timeval));
         }
         /* The process is remote */
-        else {
-          nb_remote_proc_in_contenders++;
-          if (get_accusationTime_of_remoteprocess(&tmp_proc->addr, gid, &accusationTime1) < 0) {
-            fprintf(stderr, "updateGlobalLeader: error couldn't find remote accusationTime for group: %u and addr: %u.%u.%u.%u\n",
-            gid, NIPQUAD(&tmp_proc->addr));
-            free(newGlobalLeader);
-            return -1;
-          }
-          else {
-            if (newGlobalLeader->pid == 0) { /* temporary new global leader not yet initialized */
-              newGlobalLeader->pid = tmp_proc->pid;
-              memcpy(&newGlobalLeader->addr, &tmp_proc->addr, sizeof(struct sockaddr_in));
-            }
-            else if (is_local_address(&newGlobalLeader->addr)) { /* temporary new global leader is local */
-              if (getlocalaccusationTime(gid, &accusationTime2) < 0) {
-                fprintf(stderr, "updateGlobalLeader: error couldn't find local counter of fo group: %u\n", gid);
-                free(newGlobalLeader);
-                return -1;
-              }
-              else {
-                if(compare_procs(newGlobalLeader, &accusationTime2, tmp_proc, &accusationTime1)) {
-                  newGlobalLeader->pid = tmp_proc->pid;
-                  memcpy(&newGlobalLeader->addr, &tmp_proc->addr, sizeof(struct sockaddr_in));
-                }
-              }
-            }
-            else { /* temporary new global leader is remote */
-              if (get_accusationTime_of_remoteprocess(&newGlobalLeader->addr, gid, &accusationTime2) < 0) {
-                fprintf(stderr, "updateGlobalLeader: error couldn't find remote accusationTime for group: %u and addr: %u.%u.%u.%u\n",
-                gid, NIPQUAD(&newGlobalLeader->addr));
-                free(newGlobalLeader);
-                return -1;
-              }
-              else {
-                if(compare_procs(newGlobalLeader, &accusationTime2, tmp_proc, &accusationTime1)) {
-                  newGlobalLeader->pid = tmp_proc->pid;
-                  memcpy(&newGlobalLeader->addr, &tmp_proc->addr, sizeof(struct sockaddr_in));
-                }
-              }
-            }
-          }
+        else if (get_accusationTime_of_remoteprocess(&tmp_proc->addr, gid, &accusationTime1) < 0) {
+          fprintf(stderr, "updateGlobalLeader: error couldn't find remote accusationTime for group: %u and addr: %u.%u.%u.%u\n",
+          gid, NIPQUAD(&tmp_proc->addr));
+          free(newGlobalLeader);
+          return -1;
+        }
+        
+        /* the accusationTime of the temporary leader is kept in accusationTime2 */
+        if ((newGlobalLeader->pid == 0) || /* temporary new leader not yet initialized */
+          compare_procs(newGlobalLeader, &accusationTime2, tmp_proc, &accusationTime1)) {
+          newGlobalLeader->pid = tmp_proc->pid;
+          memcpy(&newGlobalLeader->addr, &tmp_proc->addr, sizeof(struct sockaddr_in));
+          memcpy(&accusationTime2, &accusationTime1, sizeof(struct timeval));
         }
       }
       break;
@@ -577,51 +705,46 @@ inline int updateGlobalLeader(unsigned int gid, struct timeval *now) {
   memcpy(&globalLeader->addr, &newGlobalLeader->addr, sizeof(struct sockaddr_in));
   globalLeader->pid = newGlobalLeader->pid;
   
-#ifdef OMEGA_OUTPUT
-  fprintf(stdout, "Old leader was pid: %u addr: %u.%u.%u.%u newleader is pid: %u addr: %u.%u.%u.%u\n",
-    tmp_leader->pid, NIPQUAD(&tmp_leader->addr), globalLeader->pid,
-  NIPQUAD(&globalLeader->addr));
-#endif
-#ifdef OMEGA_LOG
-  fprintf(omega_log, "Old leader was pid: %u addr: %u.%u.%u.%u newleader is pid: %u addr: %u.%u.%u.%u\n",
-    tmp_leader->pid, NIPQUAD(&tmp_leader->addr), globalLeader->pid,
-  NIPQUAD(&globalLeader->addr));
-#endif
-  
   /* Notify processes interested in this group if the leader changed */
   stability_changed = (tmp_leader->stable != globalLeader->stable);
   addr_changed = !sockaddr_eq(&tmp_leader->addr, &globalLeader->addr);
   pid_changed = (tmp_leader->pid != globalLeader->pid);
   leader_changed = addr_changed || pid_changed || stability_changed;
   
+  if (leader_changed) {
+    metrics.leader_changes++;
+    trace_event(TRACE_LEADER_CHANGE, &globalLeader->addr, gid, globalLeader->pid,
+    globalLeader->stable);
+  }
   
-  list_for_each(tmp_head1, &localregistered_proc_head) {
-    rproc = list_entry(tmp_head1, struct localregistered_proc_struct, localproc_list);
-    list_for_each(tmp_head2, &rproc->notif_type_list) {
-      tmp_notif = list_entry(tmp_head2, struct notif_type_struct, notif_type_list);
-      if (tmp_notif->gid == gid) {
-        if (tmp_notif->notif_type == OMEGA_INTERRUPT_ANY_CHANGE) {
-          if (leader_changed || !tmp_notif->already_notified) {
-            msg_omega_build_notify(msg, &globalLeader->addr, globalLeader->pid, globalLeader->gid,
-            globalLeader->stable);
-            
-            if (write_msg(rproc->omega_int_fd, msg, OMEGA_FIFO_MSG_LEN) < 0)
-              fprintf(stderr, "omega updateGlobalLeader: error while writing to interrupt pipe\n");
-            else
-              tmp_notif->already_notified = 1;
-          }
+  
+  list_for_each(tmp_head1, omega_group_notifs(gid)) {
+    tmp_notif = list_entry(tmp_head1, struct notif_type_struct, group_list);
+    rproc = tmp_notif->rproc;
+    if (tmp_notif->notif_type == OMEGA_INTERRUPT_ANY_CHANGE) {
+      if (leader_changed || !tmp_notif->already_notified) {
+        msg_omega_build_notify(msg, &globalLeader->addr, globalLeader->pid, globalLeader->gid,
+        globalLeader->stable);
+        
+        if (write_msg(rproc->omega_int_fd, msg, OMEGA_FIFO_MSG_LEN) < 0) {
+          fprintf(stderr, "omega updateGlobalLeader: error while writing to interrupt pipe\n");
+          /* sent again on the next update of the group */
+          tmp_notif->already_notified = 0;
+          retval = 1;
         }
-        break;
+        else
+          tmp_notif->already_notified = 1;
       }
-      else if (tmp_notif->gid > gid)
-        break;
     }
   }
+  if (retval > 0)
+    mark_global_leader_dirty(gid);
   
   
   free(tmp_leader);
   free(newGlobalLeader);
-  return 0;
+  metrics_hist_since(&metrics.leader_update, update_start_ns);
+  return retval;
 }
 
 inline void doUponSuspected(struct sockaddr_in *addr, u_int pid, u_int gid, struct timeval *now) {
@@ -665,6 +788,13 @@ inline void doUponSuspected(struct sockaddr_in *addr, u_int pid, u_int gid, stru
         fprintf(stderr, "omega check fdd int: Error while getting remote startTime\n");
         fprintf(stderr, "of addr: %u.%u.%u.%u for group: %u\n", NIPQUAD(addr), gid);
       }
+#ifdef OMEGA_ACCUSATIONS
+      /* the accusations for a host go together, see local_queue_accusation().
+       They make the accused leader move its accusationTime, so they change
+       the elections: off unless OMEGA_ACCUSATIONS is defined. */
+      else if (local_queue_accusation(addr, gid, &startTime, now) < 0)
+        fprintf(stderr, "omega doUponSuspected: Error while queuing the accusation for group: %u\n", gid);
+#endif
     }
     updateGlobalLeader(gid, now);
   }
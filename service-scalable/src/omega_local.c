@@ -34,14 +34,51 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include "misc.h"
+#include "fdd_gset.h"
 
 int omega_fifo_fd ;
 struct list_head localregistered_proc_head ;
 
+/* the notif_type_struct of the local processes, per group */
+static struct gtable omega_group_notifs_table = GTABLE_INIT ;
+
 void omega_local_init() {
   INIT_LIST_HEAD(&localregistered_proc_head);
 }
 
+extern void omega_local_cleanup(void) {
+  gtable_free(&omega_group_notifs_table);
+}
+
+
+/* omega_group_notifs - returns the list of the notif_type_struct of the
+ local processes in the group gid, through group_list */
+extern struct list_head *omega_group_notifs(unsigned int gid) {
+  static LIST_HEAD(no_notifs);
+  struct list_head *notifs;
+  
+  notifs = gtable_lookup(&omega_group_notifs_table, gid);
+  return notifs ? notifs : &no_notifs;
+}
+
+/* adds the notif_type of a local process to omega_group_notifs() */
+static int omega_group_add_notif(struct notif_type_struct *notif,
+  struct localregistered_proc_struct *rproc) {
+  struct list_head *head;
+  
+  head = gtable_create(&omega_group_notifs_table, notif->gid);
+  if (head == NULL)
+    return -ENOMEM;
+  
+  notif->rproc = rproc;
+  list_add_tail(&notif->group_list, head);
+  return 0;
+}
+
+static void omega_group_del_notif(struct notif_type_struct *notif) {
+  list_del(&notif->group_list);
+}
+
 
 /* send result message type to a local process */
 static int omega_send_result(struct localregistered_proc_struct *rproc, int result) {
@@ -65,7 +102,7 @@ gid. It also either deletes the contenders set of gid for the same reason as abo
 static void cleanup_leader_and_contenders(struct localregistered_proc_struct *rproc,
   unsigned int gid, int candidate, struct timeval *now) {
   
-  struct list_head *tmp_head1, *tmp_head2;
+  struct list_head *tmp_head1;
   struct contenders_struct *tmp_contenders;
   
   int local_group_empty = 1;
@@ -74,27 +111,18 @@ static void cleanup_leader_and_contenders(struct localregistered_proc_struct *rp
   int no_candidate = 1;
   
   struct notif_type_struct *tmp_notif;
-  struct localregistered_proc_struct *tmp_rproc;
   
   
   /* Check if there is another process in group gid */
-  list_for_each(tmp_head1, &localregistered_proc_head) {
-    tmp_rproc = list_entry(tmp_head1, struct localregistered_proc_struct, localproc_list);
-    if (tmp_rproc->pid != rproc->pid) {
-      list_for_each(tmp_head2, &tmp_rproc->notif_type_list) {
-        tmp_notif = list_entry(tmp_head2, struct notif_type_struct, notif_type_list);
-        if (tmp_notif->gid == gid) {
-          local_group_empty = 0;
-          if (tmp_notif->candidate == CANDIDATE) {
-            no_candidate = 0;
-            
-          }
-          break;
-        }
+  list_for_each(tmp_head1, omega_group_notifs(gid)) {
+    tmp_notif = list_entry(tmp_head1, struct notif_type_struct, group_list);
+    if (tmp_notif->rproc->pid != rproc->pid) {
+      local_group_empty = 0;
+      if (tmp_notif->candidate == CANDIDATE) {
+        no_candidate = 0;
+        break;
       }
     }
-    if (!no_candidate)
-      break;
   }
   
   /* Remove the localLeader variable, globalLeader variable, the localContenders set and
@@ -112,6 +140,7 @@ static void cleanup_leader_and_contenders(struct localregistered_proc_struct *rp
       else if (tmp_contenders->gid == gid) {
         list_del(&tmp_contenders->contenders_list);
         list_free(&tmp_contenders->procs_list, struct proc_struct, proc_list);
+        contenders_release_class(tmp_contenders);
         free(tmp_contenders);
         break;
       }
@@ -312,6 +341,7 @@ static void omega_local_unreg(struct localregistered_proc_struct *rproc, fd_set
     that the process unregistering will not be notified of
      the eventual leader change. */
     list_del(&tmp_notif->notif_type_list);
+    omega_group_del_notif(tmp_notif);
     free(tmp_notif);
     cleanup_leader_and_contenders(rproc, gid, candidate, now);
   }
@@ -361,6 +391,12 @@ static void do_startOmega(struct localregistered_proc_struct *rproc, char *msg,
       goto out;
     }
     else {
+      if (!entry_exists && omega_group_add_notif(entry_ptr, rproc) < 0) {
+        list_del(&entry_ptr->notif_type_list);
+        free(entry_ptr);
+        retval = -ENOMEM;
+        goto out;
+      }
       entry_ptr->notif_type = notif_type;
       entry_ptr->already_notified = 0;
       
@@ -493,6 +529,7 @@ static void do_stopOmega(struct localregistered_proc_struct *rproc, char *msg, s
     if (tmp_notif->gid == gid) {
       candidate = tmp_notif->candidate;
       list_del(&tmp_notif->notif_type_list);
+      omega_group_del_notif(tmp_notif);
       free(tmp_notif);
       break;
     }
@@ -529,6 +566,12 @@ static void do_change_interrupt_mode(struct localregistered_proc_struct *rproc,
     list_insert_ordered(gid, gid, &rproc->notif_type_list, struct notif_type_struct,
     notif_type_list, <);
     if (!entry_exists) {
+      /* the process never started omega in the group gid: drop the
+       entry list_insert_ordered has just added */
+      if (entry_ptr != NULL) {
+        list_del(&entry_ptr->notif_type_list);
+        free(entry_ptr);
+      }
       retval = -1;
       goto out;
     }
@@ -552,6 +595,31 @@ static void do_change_interrupt_mode(struct localregistered_proc_struct *rproc,
 }
 
 
+static void do_change_detector_mode(struct localregistered_proc_struct *rproc, char *msg) {
+  
+  unsigned int gid;
+  int detector;
+  int retval = -1;
+  
+  msg_omega_parse_detector(msg, &detector, &gid);
+  
+  if (detector == OMEGA_DETECTOR_PHI)
+    retval = do_set_group_detector(rproc->pid, gid, DETECTOR_PHI);
+  else if (detector == OMEGA_DETECTOR_CHEN)
+    retval = do_set_group_detector(rproc->pid, gid, DETECTOR_CHEN);
+  
+  retval = omega_send_result(rproc, retval < 0 ? -1 : 0) ;
+  if(retval < 0) {
+#ifdef OMEGA_OUTPUT
+    fprintf(stdout, "Error in do_change_detector_mode\n") ;
+#endif
+#ifdef OMEGA_LOG
+    fprintf(omega_log, "Error in do_change_detector_mode\n") ;
+#endif
+  }
+}
+
+
 static void do_get_leader(struct localregistered_proc_struct *rproc, char *msg) {
   
   struct list_head *tmp_head;
@@ -642,6 +710,10 @@ static void omega_do_cmd(struct localregistered_proc_struct *rproc, fd_set *dset
       do_change_interrupt_mode(rproc, msg);
     break;
     
+    case MSG_OMEGA_DETECTOR_MODE:
+      do_change_detector_mode(rproc, msg);
+    break;
+    
     default:
 #ifdef OMEGA_OUTPUT
     fprintf(stderr, "omega: bad message type on cmd fifo %d.\n", msg_type(msg));
@@ -667,6 +739,8 @@ extern void omega_local_check_pipes(fd_set *active, fd_set *dset, struct timeval
     tmp = tmp->next ;
     if( FD_ISSET(rproc->omega_cmd_fd, active) ) {
       omega_do_cmd(rproc, dset, now) ;
+      /* don't let a burst of commands delay reports and suspicions */
+      fdd_poll(now) ;
     }
   }
 }
@@ -715,20 +789,14 @@ extern void check_omega_fifo(fd_set *active, fd_set *dset, struct timeval *now)
  the group has to exist and contain local candidates. */
 extern int omega_group_exists_locally(unsigned int gid, int candidate) {
   
-  struct list_head *tmp_rproc, *tmp_notif;
-  struct localregistered_proc_struct *rproc;
+  struct list_head *tmp_notif;
   struct notif_type_struct *notif;
   
-  list_for_each(tmp_rproc, &localregistered_proc_head) {
-    rproc = list_entry(tmp_rproc, struct localregistered_proc_struct, localproc_list);
-    list_for_each(tmp_notif, &rproc->notif_type_list) {
-      notif = list_entry(tmp_notif, struct notif_type_struct, notif_type_list);
-      if (notif->gid == gid) {
-        if (((candidate == CANDIDATE) && (notif->candidate == CANDIDATE)) ||
-        (candidate == NOT_CANDIDATE))
-        return 1;
-      }
-    }
+  list_for_each(tmp_notif, omega_group_notifs(gid)) {
+    notif = list_entry(tmp_notif, struct notif_type_struct, group_list);
+    if (((candidate == CANDIDATE) && (notif->candidate == CANDIDATE)) ||
+    (candidate == NOT_CANDIDATE))
+    return 1;
   }
   return 0;
 }
@@ -37,10 +37,27 @@
 #include "misc.h"
 
 
+/* send_accusation_msg - sends an accusation message, carrying one or
+ more accusations, to the omega of raddr */
+void send_accusation_msg(struct sockaddr_in *raddr, char *msg, int msg_len) {
+  
+  struct sockaddr_in addr;
+  int bytes;
+  
+  memcpy(&addr, raddr, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(OMEGA_UDP_PORT);
+  
+  bytes = sendto(omega_udp_socket, msg, msg_len, 0, (struct sockaddr *) &addr, sizeof(addr));
+  
+  if(bytes < 0)
+    perror("omega: send_accusation_msg(), cannot send data\n");
+}
+
+
 void send_accusation(struct sockaddr_in *raddr, u_int gid, struct timeval *startTime) {
   
   char msg[OMEGA_UDP_MSG_LEN], *ptr;
-  int bytes;
   
 #ifdef OMEGA_OUTPUT
   fprintf(stdout, "Sending accusation to: %u.%u.%u.%u for gid: %u startTime: %ld.%ld\n",
@@ -54,33 +71,32 @@ void send_accusation(struct sockaddr_in *raddr, u_int gid, struct timeval *start
   
   ptr = msg_omega_build_accusation(msg, gid, startTime);
   
-  (*raddr).sin_family = AF_INET;
-  (*raddr).sin_port = htons(OMEGA_UDP_PORT);
-  
-  bytes = sendto(omega_udp_socket, msg, ptr-msg, 0, (struct sockaddr *) raddr, sizeof(*raddr));
-  
-  if(bytes < 0)
-    perror("omega: send_accusation(), cannot send data\n");
+  send_accusation_msg(raddr, msg, ptr-msg);
 }
 
 
+/* accusation_merge - merges the accusations of an accusation message,
+ a host batches the ones it has for us (see local_queue_accusation()) */
 void accusation_merge(char *msg, int msg_len, struct sockaddr_in *cliAddr, struct timeval *now) {
   
   u_int gid;
   struct timeval startTime;
+  char *ptr = msg + 4;
   
-  msg_omega_parse_accusation(msg, &gid, &startTime);
-  
-  doUponReceivedAccusation(gid, &startTime, now);
-  
+  while(ptr + OMEGA_ACCUSATION_LEN <= msg + msg_len) {
+    ptr = msg_omega_parse_accusation_entry(ptr, &gid, &startTime);
+    
+    doUponReceivedAccusation(gid, &startTime, now);
+    
 #ifdef OMEGA_OUTPUT
-  fprintf(stdout, "Received accusation from: %u.%u.%u.%u for gid: %u startTime: %ld.%ld\n",
-  NIPQUAD(cliAddr), gid, startTime.tv_sec, startTime.tv_usec);
+    fprintf(stdout, "Received accusation from: %u.%u.%u.%u for gid: %u startTime: %ld.%ld\n",
+    NIPQUAD(cliAddr), gid, startTime.tv_sec, startTime.tv_usec);
 #endif
 #ifdef OMEGA_LOG
-  fprintf(omega_log, "Received accusation from: %u.%u.%u.%u for gid: %u startTime: %ld.%ld\n",
-  NIPQUAD(cliAddr), gid, startTime.tv_sec, startTime.tv_usec);
+    fprintf(omega_log, "Received accusation from: %u.%u.%u.%u for gid: %u startTime: %ld.%ld\n",
+    NIPQUAD(cliAddr), gid, startTime.tv_sec, startTime.tv_usec);
 #endif
+  }
 }
 
 
@@ -32,6 +32,7 @@
 #include "variables_exchange.h"
 #include "omega_remote.h"
 #include "misc.h"
+#include "fdd_metrics.h"
 #include <signal.h>
 #include <errno.h>
 #include <string.h>
@@ -55,6 +56,8 @@ void terminate_omega(int sign) {
   struct timeval now;
   
   if (sign == SIGINT) {
+    omega_local_cleanup();
+    exchange_vars_cleanup();
     terminate_fdd();
     
     gettimeofday(&now, NULL);
@@ -191,26 +194,35 @@ static void init_omega(fd_set *dset) {
 
 int main(int argc, char *argv[]) {
   
-  fd_set dset, active;
+  fd_set dset, active, writable;
   int selected;
-  int fd_udp_socket;
+  int fd_udp_socket, fd_metrics_socket;
   struct timeval now;
   struct timeval timeout_fd;
+  u_int64_t wake_ns;
   
   init_omega(&dset);
   
   fd_udp_socket = fdd_init();
   FD_SET(fd_udp_socket, &dset);
   
+  /* the metrics endpoint is optional */
+  if ((fd_metrics_socket = metrics_init()) >= 0)
+    FD_SET(fd_metrics_socket, &dset);
+  
   while (1) {
     memcpy(&active, &dset, sizeof(fd_set));
+    FD_ZERO(&writable);
+    metrics_wset(&writable);
+    metrics.loop_iterations++;
     
     gettimeofday(&now, NULL);
     fd_sched_run(&timeout_fd, &now);
     
-    if( (selected = select(FD_SETSIZE, &active, NULL, NULL, &timeout_fd)) < 0 )
+    if( (selected = select(FD_SETSIZE, &active, &writable, NULL, &timeout_fd)) < 0 )
       terminate_omega(SIGINT);
     
+    wake_ns = metrics_now_ns();
     gettimeofday(&now, NULL);
     
     check_fd_socket(&active, &now);
@@ -222,6 +234,15 @@ int main(int argc, char *argv[]) {
     
     /* Check the cmd pipes of the registered processes */
     omega_local_check_pipes(&active, &dset, &now);
+    
+    /* Recompute the leaders of the groups changed by this iteration */
+    if (updateDirtyGlobalLeaders(&now) < 0)
+      fprintf(stderr, "omega: Error while updating global leaders\n");
+    
+    metrics_hist_since(&metrics.dispatch, wake_ns);
+    
+    /* Answer a metrics scrape, if any, and go on with the pending ones */
+    check_metrics_socket(&active, &writable);
   }
   return 0;
 }
@@ -28,13 +28,34 @@
 #include <sys/time.h>
 
 
+/* The table of the variables of the remote processes and the one of the
+ hosts heading their chains, see variables_exchange.h */
+static struct remotevars_slot *rvars_slots = NULL;
+static unsigned int rvars_nb_slots = 0;
+static unsigned int rvars_nb_used = 0;
+static unsigned int rvars_nb_deleted = 0;
+
+static struct remotevars_host *rvars_hosts = NULL;
+static unsigned int rvars_nb_hosts_slots = 0;
+static unsigned int rvars_nb_hosts = 0;
+static unsigned int rvars_nb_hosts_deleted = 0;
+
+
 int exchange_vars_init() {
-  /* initialize the localvars list and remotevars list */
+  /* initialize the localvars list */
   INIT_LIST_HEAD(&(localvars_head));
-  INIT_LIST_HEAD(&(remotevars_head));
   return 0;
 }
 
+void exchange_vars_cleanup() {
+  free(rvars_slots);
+  rvars_slots = NULL;
+  rvars_nb_slots = rvars_nb_used = rvars_nb_deleted = 0;
+  free(rvars_hosts);
+  rvars_hosts = NULL;
+  rvars_nb_hosts_slots = rvars_nb_hosts = rvars_nb_hosts_deleted = 0;
+}
+
 
 
 /*****************************************************************************/
@@ -42,8 +63,9 @@ int exchange_vars_init() {
 /* remotevars lists (not the global variable!)                               */
 /*****************************************************************************/
 
-/* Inserts remote variables in a remotevars list. */
-inline int insert_remotevars_in_list(struct sockaddr_in *addr, u_int gid, struct timeval *accusationTime,
+/* Inserts remote variables in a remotevars list. Returns 1 if the variables
+ of (addr, gid) are new or changed, 0 if they are unchanged and -1 on error. */
+int insert_remotevars_in_list(struct sockaddr_in *addr, u_int gid, struct timeval *accusationTime,
   struct timeval *startTime, struct list_head *remotevars) {
   
   struct remotevars_struct *tmp_remotevars = NULL;
@@ -51,6 +73,7 @@ inline int insert_remotevars_in_list(struct sockaddr_in *addr, u_int gid, struct
   struct vars_struct *tmp_vars = NULL;
   struct list_head *tmp_head2 = NULL;
   int found_addr = 0, found_gid = 0;
+  int changed = 1;
   
   list_for_each(tmp_head1, remotevars) {
     tmp_remotevars = list_entry(tmp_head1, struct remotevars_struct, remotevars_list);
@@ -64,6 +87,8 @@ inline int insert_remotevars_in_list(struct sockaddr_in *addr, u_int gid, struct
           continue;
         else if (tmp_vars->gid == gid) {
           found_gid = 1;
+          changed = timercmp(accusationTime, &tmp_vars->accusationTime, >) ||
+          timercmp(startTime, &tmp_vars->startTime, >);
           
           /* the max is taken because the links are not
            necessarily fifo */
@@ -109,7 +134,7 @@ inline int insert_remotevars_in_list(struct sockaddr_in *addr, u_int gid, struct
     list_add_tail(&(tmp_vars->vars_list), &tmp_remotevars->vars_head);
     list_add_tail(&(tmp_remotevars->remotevars_list), tmp_head1);
   }
-  return 0;
+  return changed;
 }
 
 
@@ -161,7 +186,7 @@ void free_remotevars_list(struct list_head *remotevars_list) {
 /*****************************************************************************/
 
 /* Creates the localvars of group gid */
-inline int create_localvars(unsigned int gid) {
+int create_localvars(unsigned int gid) {
   struct vars_struct *entry_ptr = NULL;
   int entry_exists;
   struct timeval tv;
@@ -377,102 +402,179 @@ inline int set_local_startTime(unsigned int gid) {
 /* The following procedures deal with the remotevars list                    */
 /*****************************************************************************/
 
-/* Returns 0 if the accusation variable of the group gid has been found,
- -1 otherwise. */
-inline int get_accusationTime_of_remoteprocess(struct sockaddr_in *addr, u_int gid,
-  struct timeval *accusationTime) {
+static inline unsigned int rvars_hash(u_int32_t addr, u_int gid,
+  unsigned int nb_slots) {
+  u_int64_t key = ((u_int64_t)addr << 32) | gid;
   
-  struct list_head *tmp_head1, *tmp_head2;
+  key *= 0x9e3779b97f4a7c15ULL;
+  return (unsigned int)(key >> 32) & (nb_slots - 1);
+}
+
+/* Returns the slot of the variables of (addr, gid), -1 if they are not in. */
+static int rvars_find(u_int32_t addr, u_int gid) {
+  unsigned int h;
   
-  struct remotevars_struct *tmp_remote;
-  struct vars_struct *tmp_vars;
+  if (rvars_nb_slots == 0)
+    return -1;
+  for (h = rvars_hash(addr, gid, rvars_nb_slots); rvars_slots[h].state != RVARS_FREE;
+    h = (h + 1) & (rvars_nb_slots - 1)) {
+    if (rvars_slots[h].state == RVARS_USED && rvars_slots[h].addr == addr &&
+      rvars_slots[h].gid == gid)
+      return h;
+  }
+  return -1;
+}
+
+/* Returns the head of the chain of the host addr, NULL if it has none. */
+static struct remotevars_host *rvars_find_host(u_int32_t addr) {
+  unsigned int h;
   
-  list_for_each(tmp_head1, &remotevars_head) {
-    tmp_remote = list_entry(tmp_head1, struct remotevars_struct, remotevars_list);
-    if (sockaddr_smaller(&tmp_remote->addr, addr))
+  if (rvars_nb_hosts_slots == 0)
+    return NULL;
+  for (h = rvars_hash(addr, 0, rvars_nb_hosts_slots); rvars_hosts[h].state != RVARS_FREE;
+    h = (h + 1) & (rvars_nb_hosts_slots - 1)) {
+    if (rvars_hosts[h].state == RVARS_USED && rvars_hosts[h].addr == addr)
+      return &rvars_hosts[h];
+  }
+  return NULL;
+}
+
+/* Rebuilds the table of the hosts with nb_slots slots, dropping the
+ deleted ones. The chains are not touched. */
+static int rvars_resize_hosts(unsigned int nb_slots) {
+  struct remotevars_host *hosts;
+  unsigned int i, h;
+  
+  hosts = calloc(nb_slots, sizeof(*hosts));
+  if (hosts == NULL)
+    return -1;
+  
+  for (i = 0; i < rvars_nb_hosts_slots; i++) {
+    if (rvars_hosts[i].state != RVARS_USED)
       continue;
-    else if (sockaddr_eq(&tmp_remote->addr, addr)) {
-      list_for_each(tmp_head2, &tmp_remote->vars_head) {
-        tmp_vars = list_entry(tmp_head2, struct vars_struct, vars_list);
-        if (tmp_vars->gid < gid)
-          continue;
-        else if (tmp_vars->gid == gid) {
-          memcpy(accusationTime, &tmp_vars->accusationTime, sizeof(struct timeval));
-          return 0;
-        }
-        else
-          break;
-      }
-      break;
+    h = rvars_hash(rvars_hosts[i].addr, 0, nb_slots);
+    while (hosts[h].state != RVARS_FREE)
+      h = (h + 1) & (nb_slots - 1);
+    hosts[h] = rvars_hosts[i];
+  }
+  
+  free(rvars_hosts);
+  rvars_hosts = hosts;
+  rvars_nb_hosts_slots = nb_slots;
+  rvars_nb_hosts_deleted = 0;
+  return 0;
+}
+
+/* Rebuilds the table of the variables with nb_slots slots, dropping the
+ deleted ones. The chains are rebuilt host by host. */
+static int rvars_resize(unsigned int nb_slots) {
+  struct remotevars_slot *slots;
+  unsigned int i, h;
+  int j, *last;
+  
+  slots = calloc(nb_slots, sizeof(*slots));
+  if (slots == NULL)
+    return -1;
+  
+  for (i = 0; i < rvars_nb_hosts_slots; i++) {
+    if (rvars_hosts[i].state != RVARS_USED)
+      continue;
+    last = &rvars_hosts[i].first;
+    for (j = rvars_hosts[i].first; j >= 0; j = rvars_slots[j].next) {
+      h = rvars_hash(rvars_slots[j].addr, rvars_slots[j].gid, nb_slots);
+      while (slots[h].state != RVARS_FREE)
+        h = (h + 1) & (nb_slots - 1);
+      slots[h] = rvars_slots[j];
+      *last = h;
+      last = &slots[h].next;
     }
-    else
-      break;
+    *last = -1;
   }
-  return -1;
+  
+  free(rvars_slots);
+  rvars_slots = slots;
+  rvars_nb_slots = nb_slots;
+  rvars_nb_deleted = 0;
+  return 0;
+}
+
+/* Returns the head of the chain of the host addr, created if needed, NULL
+ if out of memory. */
+static struct remotevars_host *rvars_create_host(u_int32_t addr) {
+  struct remotevars_host *host;
+  unsigned int h, nb_slots;
+  
+  host = rvars_find_host(addr);
+  if (host != NULL)
+    return host;
+  
+  /* keep the table at most half full, deleted slots included */
+  if (2 * (rvars_nb_hosts + rvars_nb_hosts_deleted + 1) > rvars_nb_hosts_slots) {
+    nb_slots = rvars_nb_hosts_slots ? rvars_nb_hosts_slots : RVARS_MIN_SLOTS;
+    while (4 * (rvars_nb_hosts + 1) > nb_slots)
+      nb_slots *= 2;
+    if (rvars_resize_hosts(nb_slots) < 0)
+      return NULL;
+  }
+  
+  h = rvars_hash(addr, 0, rvars_nb_hosts_slots);
+  while (rvars_hosts[h].state == RVARS_USED)
+    h = (h + 1) & (rvars_nb_hosts_slots - 1);
+  if (rvars_hosts[h].state == RVARS_DELETED)
+    rvars_nb_hosts_deleted--;
+  rvars_hosts[h].addr = addr;
+  rvars_hosts[h].state = RVARS_USED;
+  rvars_hosts[h].first = -1;
+  rvars_nb_hosts++;
+  return &rvars_hosts[h];
+}
+
+
+/* Returns 0 if the accusation variable of the group gid has been found,
+ -1 otherwise. */
+int get_accusationTime_of_remoteprocess(struct sockaddr_in *addr, u_int gid,
+  struct timeval *accusationTime) {
+  
+  int h = rvars_find(addr->sin_addr.s_addr, gid);
+  
+  if (h < 0)
+    return -1;
+  memcpy(accusationTime, &rvars_slots[h].accusationTime, sizeof(struct timeval));
+  return 0;
 }
 
 
 /* Returns 0 if the startTime variable of the group gid has been found,
  -1 otherwise. */
-inline int get_startTime_of_remoteprocess(struct sockaddr_in *addr, u_int gid,
+int get_startTime_of_remoteprocess(struct sockaddr_in *addr, u_int gid,
   struct timeval *startTime) {
   
-  struct list_head *tmp_head1, *tmp_head2;
-  
-  struct remotevars_struct *tmp_remote;
-  struct vars_struct *tmp_vars;
+  int h = rvars_find(addr->sin_addr.s_addr, gid);
   
-  list_for_each(tmp_head1, &remotevars_head) {
-    tmp_remote = list_entry(tmp_head1, struct remotevars_struct, remotevars_list);
-    if (sockaddr_smaller(&tmp_remote->addr, addr))
-      continue;
-    else if (sockaddr_eq(&tmp_remote->addr, addr)) {
-      list_for_each(tmp_head2, &tmp_remote->vars_head) {
-        tmp_vars = list_entry(tmp_head2, struct vars_struct, vars_list);
-        if (tmp_vars->gid < gid)
-          continue;
-        else if (tmp_vars->gid == gid) {
-          memcpy(startTime, &tmp_vars->startTime, sizeof(struct timeval));
-          return 0;
-        }
-        else
-          break;
-      }
-      break;
-    }
-    else
-      break;
-  }
-  return -1;
+  if (h < 0)
+    return -1;
+  memcpy(startTime, &rvars_slots[h].startTime, sizeof(struct timeval));
+  return 0;
 }
 
 
 /* Inserts in variable remotevars all the remote vars received of a particular group.
 If the size of the returned list is zero then we return 0. Otherwise
  we return 1. */
-inline int get_remote_vars_of_group(u_int gid, struct list_head *remotevars) {
+int get_remote_vars_of_group(u_int gid, struct list_head *remotevars) {
   
-  struct list_head *tmp_head1, *tmp_head2;
+  struct sockaddr_in addr;
+  unsigned int i;
   
-  struct remotevars_struct *tmp_remote;
-  struct vars_struct *tmp_vars;
-  
-  list_for_each(tmp_head1, &remotevars_head) {
-    tmp_remote = list_entry(tmp_head1, struct remotevars_struct, remotevars_list);
-    list_for_each(tmp_head2, &tmp_remote->vars_head) {
-      tmp_vars = list_entry(tmp_head2, struct vars_struct, vars_list);
-      if (tmp_vars->gid < gid)
-        continue;
-      else if (tmp_vars->gid == gid) {
-        if (insert_remotevars_in_list(&tmp_remote->addr, tmp_vars->gid,
-            &tmp_vars->accusationTime, &tmp_vars->startTime,
-        remotevars) < 0)
-        fprintf(stderr, "Couldn't allocate new memory when retreiving the remote variables of group: %u\n", gid);
-        break;
-      }
-      else
-        break;
-    }
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  for (i = 0; i < rvars_nb_slots; i++) {
+    if (rvars_slots[i].state != RVARS_USED || rvars_slots[i].gid != gid)
+      continue;
+    addr.sin_addr.s_addr = rvars_slots[i].addr;
+    if (insert_remotevars_in_list(&addr, gid, &rvars_slots[i].accusationTime,
+      &rvars_slots[i].startTime, remotevars) < 0)
+    fprintf(stderr, "Couldn't allocate new memory when retreiving the remote variables of group: %u\n", gid);
   }
   if (list_empty(remotevars))
     return 0;
@@ -482,38 +584,84 @@ inline int get_remote_vars_of_group(u_int gid, struct list_head *remotevars) {
 
 
 
-/* Adds or updates variables received from a remote host. */
-inline int insert_in_remotevars(struct sockaddr_in *addr, unsigned int gid,
+/* Adds or updates variables received from a remote host. Returns 1 if they
+ changed, 0 if not and -1 on error. */
+int insert_in_remotevars(struct sockaddr_in *addr, unsigned int gid,
   struct timeval *accusationTime, struct timeval *startTime) {
   
-  int retval;
-  retval = insert_remotevars_in_list(addr, gid, accusationTime, startTime, &remotevars_head);
-  return retval;
+  struct remotevars_host *host;
+  struct remotevars_slot *slot;
+  u_int32_t a = addr->sin_addr.s_addr;
+  unsigned int nb_slots;
+  int h, changed;
+  
+  h = rvars_find(a, gid);
+  if (h >= 0) {
+    slot = &rvars_slots[h];
+    changed = timercmp(accusationTime, &slot->accusationTime, >) ||
+    timercmp(startTime, &slot->startTime, >);
+    
+    /* the max is taken because the links are not
+     necessarily fifo */
+    memcpy(&slot->accusationTime, timermax(accusationTime, &slot->accusationTime),
+    sizeof(struct timeval));
+    memcpy(&slot->startTime, timermax(startTime, &slot->startTime),
+    sizeof(struct timeval));
+    return changed;
+  }
+  
+  /* New gid for that remote host */
+  host = rvars_create_host(a);
+  if (host == NULL)
+    return -1;
+  
+  /* keep the table at most half full, deleted slots included */
+  if (2 * (rvars_nb_used + rvars_nb_deleted + 1) > rvars_nb_slots) {
+    nb_slots = rvars_nb_slots ? rvars_nb_slots : RVARS_MIN_SLOTS;
+    while (4 * (rvars_nb_used + 1) > nb_slots)
+      nb_slots *= 2;
+    if (rvars_resize(nb_slots) < 0)
+      return -1;
+  }
+  
+  h = rvars_hash(a, gid, rvars_nb_slots);
+  while (rvars_slots[h].state == RVARS_USED)
+    h = (h + 1) & (rvars_nb_slots - 1);
+  if (rvars_slots[h].state == RVARS_DELETED)
+    rvars_nb_deleted--;
+  slot = &rvars_slots[h];
+  slot->addr = a;
+  slot->gid = gid;
+  slot->state = RVARS_USED;
+  memcpy(&slot->accusationTime, accusationTime, sizeof(struct timeval));
+  memcpy(&slot->startTime, startTime, sizeof(struct timeval));
+  slot->next = host->first;
+  host->first = h;
+  rvars_nb_used++;
+  return 1;
 }
 
 
+/* Drops the variables of the host addr, following its chain. Returns 0 if
+ it had some, -1 otherwise. */
 int free_host_in_remotevars_list(struct sockaddr_in *addr) {
   
-  struct list_head *tmp_head;
-  struct remotevars_struct *remote_tmp;
-  int retval = 0;
+  struct remotevars_host *host;
+  int h;
   
-  list_for_each(tmp_head, &remotevars_head) {
-    remote_tmp = list_entry(tmp_head, struct remotevars_struct, remotevars_list);
-    if (sockaddr_smaller(&remote_tmp->addr, addr))
-      continue;
-    else if (sockaddr_eq(addr, &remote_tmp->addr)) {
-      list_del(&remote_tmp->remotevars_list);
-      list_free(&remote_tmp->vars_head, struct vars_struct, vars_list);
-      free(remote_tmp);
-      break;
-    }
-    else {
-      retval = -1;
-      break;
-    }
+  host = rvars_find_host(addr->sin_addr.s_addr);
+  if (host == NULL)
+    return -1;
+  
+  for (h = host->first; h >= 0; h = rvars_slots[h].next) {
+    rvars_slots[h].state = RVARS_DELETED;
+    rvars_nb_used--;
+    rvars_nb_deleted++;
   }
-  return retval;
+  host->state = RVARS_DELETED;
+  rvars_nb_hosts--;
+  rvars_nb_hosts_deleted++;
+  return 0;
 }
 
 /*****************************************************************************/